@@ -0,0 +1,466 @@
+#include "CommitGraphItem.h"
+#include "CommitTable.h"
+#include "GraphLayoutEngine.h"
+#include "HistoryLoader.h"
+
+#include <git2/global.h>
+#include <git2/refs.h>
+#include <git2/repository.h>
+#include <git2/signature.h>
+#include <git2/sys/commit.h>
+#include <git2/tree.h>
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQuickWindow>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVarLengthArray>
+
+#include <iterator>
+#include <random>
+
+/**
+ * Headless benchmark of the history graph: generates repositories of a given
+ * shape on local disk, then times loading their history, laying out the
+ * lanes and rendering the graph item while scrolling through all rows.
+ * Results are written as JSON, times per 1000 rows.
+ *
+ * Rendering uses the null RHI backend unless QSG_RHI_BACKEND says otherwise,
+ * so it measures building and uploading geometry, not the GPU.
+ */
+
+namespace {
+
+constexpr int PageSize = 1000;
+constexpr qreal ViewportHeight = 900;
+
+/**
+ * \brief Writes commits with an empty tree straight into a new repository
+ */
+class RepoBuilder
+{
+public:
+    explicit RepoBuilder(const QString &path)
+    {
+        if (git_repository_init(&m_repo, path.toUtf8().constData(), false) != GIT_OK)
+            return;
+
+        git_treebuilder *builder = nullptr;
+        if (git_treebuilder_new(&builder, m_repo, nullptr) == GIT_OK) {
+            git_treebuilder_write(&m_tree, builder);
+            git_treebuilder_free(builder);
+        }
+
+        static const char *const names[] = { "Ada", "Brian", "Chen", "Dana", "Emeka", "Femi", "Gita", "Hiro" };
+        for (const char *name : names)
+            m_authors.append(QByteArray(name));
+    }
+
+    ~RepoBuilder()
+    {
+        git_repository_free(m_repo);
+    }
+
+    bool isValid() const { return m_repo != nullptr; }
+    int count() const { return m_count; }
+
+    git_oid commit(const QVector<git_oid> &parents)
+    {
+        const QByteArray &author = m_authors.at(m_count % m_authors.size());
+        const QByteArray email = author.toLower() + "@example.com";
+        const QByteArray message = "Change " + QByteArray::number(m_count) + "\n\nSynthetic commit.\n";
+
+        git_signature *signature = nullptr;
+        git_signature_new(&signature, author.constData(), email.constData(), m_time, 0);
+        m_time += 60;
+
+        QVarLengthArray<const git_oid *, 8> parentIds;
+        for (const git_oid &parent : parents)
+            parentIds.append(&parent);
+
+        git_oid oid = {};
+        git_commit_create_from_ids(&oid, m_repo, nullptr, signature, signature, nullptr,
+                                   message.constData(), &m_tree, size_t(parentIds.size()),
+                                   parentIds.data());
+        git_signature_free(signature);
+
+        m_count++;
+        return oid;
+    }
+
+    void setBranch(const QString &name, const git_oid &oid)
+    {
+        const QByteArray ref = "refs/heads/" + name.toUtf8();
+        git_reference *created = nullptr;
+        if (git_reference_create(&created, m_repo, ref.constData(), &oid, true, nullptr) == GIT_OK)
+            git_reference_free(created);
+    }
+
+    void setHead(const QString &name)
+    {
+        git_repository_set_head(m_repo, ("refs/heads/" + name.toUtf8()).constData());
+    }
+
+private:
+    git_repository *m_repo = nullptr;
+    git_oid m_tree = {};
+    QList<QByteArray> m_authors;
+    qint64 m_time = 1500000000;
+    int m_count = 0;
+};
+
+void buildLinear(RepoBuilder &repo, int commits, std::mt19937 &)
+{
+    git_oid tip = repo.commit({});
+    while (repo.count() < commits)
+        tip = repo.commit({ tip });
+
+    repo.setBranch("main", tip);
+}
+
+/**
+ * \brief Mainline with an octopus merge of several short branches every few commits
+ */
+void buildOctopus(RepoBuilder &repo, int commits, std::mt19937 &random)
+{
+    std::uniform_int_distribution<int> armLength(1, 3);
+
+    git_oid tip = repo.commit({});
+    while (repo.count() < commits) {
+        for (int i = 0; i < 16 && repo.count() < commits; ++i)
+            tip = repo.commit({ tip });
+
+        QVector<git_oid> parents = { tip };
+        for (int arm = 0; arm < 6; ++arm) {
+            git_oid armTip = tip;
+            for (int i = armLength(random); i > 0; --i)
+                armTip = repo.commit({ armTip });
+            parents.append(armTip);
+        }
+        tip = repo.commit(parents);
+    }
+
+    repo.setBranch("main", tip);
+}
+
+/**
+ * \brief Many branches advancing side by side, syncing with main now and then
+ */
+void buildLongLived(RepoBuilder &repo, int commits, std::mt19937 &random)
+{
+    constexpr int BranchCount = 24;
+    std::uniform_int_distribution<int> pickBranch(0, BranchCount);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    git_oid main = repo.commit({});
+    QVector<git_oid> branches(BranchCount, main);
+
+    while (repo.count() < commits) {
+        const int branch = pickBranch(random);
+        if (branch == BranchCount) {
+            main = repo.commit({ main });
+            continue;
+        }
+
+        const double roll = chance(random);
+        if (roll < 0.04)
+            branches[branch] = repo.commit({ branches.at(branch), main });     // Sync with main
+        else if (roll < 0.06)
+            main = repo.commit({ main, branches.at(branch) });                 // Deliver to main
+        else
+            branches[branch] = repo.commit({ branches.at(branch) });
+    }
+
+    repo.setBranch("main", main);
+    for (int branch = 0; branch < BranchCount; ++branch)
+        repo.setBranch(QStringLiteral("feature-%1").arg(branch), branches.at(branch));
+}
+
+/**
+ * \brief Merge-heavy mainline: topic branches forked from older commits, merged through subsystem trees
+ */
+void buildKernel(RepoBuilder &repo, int commits, std::mt19937 &random)
+{
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_int_distribution<int> topicLength(1, 12);
+    std::uniform_int_distribution<int> topicCount(2, 5);
+
+    QVector<git_oid> mainline = { repo.commit({}) };
+    auto forkPoint = [&](int depth) {
+        std::uniform_int_distribution<int> back(0, qMin(depth, int(mainline.size()) - 1));
+        return mainline.at(mainline.size() - 1 - back(random));
+    };
+    auto topic = [&](const git_oid &base) {
+        git_oid tip = base;
+        for (int i = topicLength(random); i > 0; --i)
+            tip = repo.commit({ tip });
+        return tip;
+    };
+
+    while (repo.count() < commits) {
+        const double roll = chance(random);
+        if (roll < 0.3) {
+            mainline.append(repo.commit({ mainline.last() }));
+        } else if (roll < 0.85) {
+            const git_oid topicTip = topic(forkPoint(50));
+            mainline.append(repo.commit({ mainline.last(), topicTip }));
+        } else {
+            // Subsystem tree collecting several topics before being pulled
+            git_oid subsystem = forkPoint(100);
+            for (int i = topicCount(random); i > 0; --i) {
+                const git_oid topicTip = topic(forkPoint(100));
+                subsystem = repo.commit({ subsystem, topicTip });
+            }
+            mainline.append(repo.commit({ mainline.last(), subsystem }));
+        }
+    }
+
+    repo.setBranch("main", mainline.last());
+}
+
+struct Shape
+{
+    const char *name;
+    void (*build)(RepoBuilder &, int, std::mt19937 &);
+};
+
+const Shape Shapes[] = {
+    { "linear", buildLinear },
+    { "octopus", buildOctopus },
+    { "long-lived", buildLongLived },
+    { "kernel", buildKernel },
+};
+
+QJsonObject timing(qint64 nanoseconds, int rows)
+{
+    QJsonObject object;
+    object["totalMs"] = nanoseconds / 1e6;
+    object["msPer1kRows"] = rows > 0 ? nanoseconds / 1e6 * 1000.0 / rows : 0.0;
+    return object;
+}
+
+/**
+ * \brief Load all history page by page, like the history view scrolling to the end
+ */
+QJsonObject benchLoad(const QString &repoPath, CommitTable &table)
+{
+    HistoryLoader loader(&table);
+    loader.setRepositoryPath(repoPath);
+
+    QEventLoop loop;
+    QVariantMap result;
+    QObject::connect(&loader, &HistoryLoader::finished, &loop, [&](const QVariantMap &finished) {
+        result = finished;
+        loop.quit();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString cursor;
+    int pages = 0;
+    do {
+        if (!loader.load(cursor, PageSize))
+            break;
+        loop.exec();
+        cursor = result.value("cursor").toString();
+        pages++;
+    } while (result.value("success").toBool() && result.value("hasMore").toBool());
+
+    QJsonObject object = timing(timer.nsecsElapsed(), table.count());
+    object["pages"] = pages;
+    object["success"] = result.value("success").toBool();
+    return object;
+}
+
+/**
+ * \brief Lay out the rows one page at a time, then all of them in one go
+ */
+QJsonObject benchLayout(const CommitTable &table, GraphLayoutEngine &engine)
+{
+    QVector<int> rows;
+    rows.reserve(table.count());
+
+    QElapsedTimer timer;
+    timer.start();
+    while (rows.size() < table.count()) {
+        const int end = qMin(table.count(), int(rows.size()) + PageSize);
+        for (int row = rows.size(); row < end; ++row)
+            rows.append(row);
+        engine.append(table, rows);
+    }
+    const qint64 paged = timer.nsecsElapsed();
+
+    timer.restart();
+    const GraphLayout full = GraphLayoutEngine::compute(table, rows);
+    const qint64 oneShot = timer.nsecsElapsed();
+
+    QJsonObject object = timing(paged, rows.size());
+    object["oneShot"] = timing(oneShot, rows.size());
+    object["laneCount"] = full.laneCount;
+    object["edges"] = int(full.edges.size() / 3);
+    return object;
+}
+
+/**
+ * \brief Scroll the graph item through all rows half a viewport at a time, rendering each step
+ */
+QJsonObject benchRender(const GraphLayoutEngine &engine)
+{
+    static const char *const palette[] = { "#4e79a7", "#f28e2b", "#e15759", "#76b7b2",
+                                           "#59a14f", "#edc948", "#b07aa1", "#ff9da7" };
+
+    const GraphLayout &layout = engine.result();
+    const int rowCount = layout.lanes.size();
+
+    QQuickWindow window;
+    window.resize(600, int(ViewportHeight));
+
+    auto *item = new CommitGraphItem(window.contentItem());
+    item->setLayoutEngine(const_cast<GraphLayoutEngine *>(&engine));
+    item->setShowAvatar(false);
+    item->setWidth(qMax(1, layout.laneCount) * item->columnSpacing() + item->nodeSize());
+    item->setHeight(rowCount * item->rowHeight());
+    item->setViewportHeight(ViewportHeight);
+
+    QVariantList colors;
+    colors.reserve(rowCount);
+    for (int colorRow : layout.colorRows)
+        colors.append(QString::fromLatin1(palette[colorRow % std::size(palette)]));
+    item->setRowColors(0, colors);
+
+    window.show();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int frames = 0;
+    for (qreal y = 0; y < item->height(); y += ViewportHeight / 2) {
+        item->setViewportY(y);
+        item->setY(-y);
+        window.grabWindow();
+        frames++;
+    }
+
+    QJsonObject object = timing(timer.nsecsElapsed(), rowCount);
+    object["frames"] = frames;
+    object["backend"] = qEnvironmentVariable("QSG_RHI_BACKEND", "null");
+    return object;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Headless by default; both can still be overridden from the environment
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    if (!qEnvironmentVariableIsSet("QSG_RHI_BACKEND"))
+        QQuickWindow::setGraphicsApi(QSGRendererInterface::Null);
+
+    git_libgit2_init();
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("GitEaseGraphBench");
+
+    // Keep the history cache of the generated repositories out of the user's cache
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks history loading, graph layout and graph rendering.");
+    parser.addHelpOption();
+    parser.addOption({ "commits", "Commits per generated repository.", "count", "20000" });
+    parser.addOption({ "shapes", "Comma separated shapes: linear, octopus, long-lived, kernel.",
+                       "shapes", "linear,octopus,long-lived,kernel" });
+    parser.addOption({ "seed", "Seed of the generated histories.", "seed", "1" });
+    parser.addOption({ "output", "Write the JSON results to a file instead of stdout.", "file" });
+    parser.process(app);
+
+    const int commits = qMax(1, parser.value("commits").toInt());
+    const QStringList shapes = parser.value("shapes").split(',', Qt::SkipEmptyParts);
+    const uint seed = parser.value("seed").toUInt();
+
+    QTextStream err(stderr);
+    QJsonArray results;
+
+    for (const QString &shapeName : shapes) {
+        const Shape *shape = nullptr;
+        for (const Shape &candidate : Shapes) {
+            if (shapeName.trimmed() == QString::fromLatin1(candidate.name))
+                shape = &candidate;
+        }
+        if (!shape) {
+            err << "Unknown shape: " << shapeName << Qt::endl;
+            return 1;
+        }
+
+        QTemporaryDir dir;
+        if (!dir.isValid()) {
+            err << "Cannot create a temporary directory" << Qt::endl;
+            return 1;
+        }
+
+        err << shape->name << ": generating " << commits << " commits" << Qt::endl;
+        QElapsedTimer timer;
+        timer.start();
+        {
+            RepoBuilder repo(dir.path());
+            if (!repo.isValid()) {
+                err << "Cannot create a repository in " << dir.path() << Qt::endl;
+                return 1;
+            }
+
+            std::mt19937 random(seed);
+            shape->build(repo, commits, random);
+            repo.setHead("main");
+        }
+        const qint64 generated = timer.nsecsElapsed();
+
+        CommitTable table;
+        GraphLayoutEngine engine;
+
+        err << shape->name << ": loading" << Qt::endl;
+        const QJsonObject load = benchLoad(dir.path(), table);
+        err << shape->name << ": laying out " << table.count() << " rows" << Qt::endl;
+        const QJsonObject layout = benchLayout(table, engine);
+        err << shape->name << ": rendering" << Qt::endl;
+        const QJsonObject render = benchRender(engine);
+
+        QJsonObject result;
+        result["shape"] = QString::fromLatin1(shape->name);
+        result["commits"] = commits;
+        result["rows"] = table.count();
+        result["generateMs"] = generated / 1e6;
+        result["load"] = load;
+        result["layout"] = layout;
+        result["render"] = render;
+        results.append(result);
+    }
+
+    QJsonObject report;
+    report["seed"] = int(seed);
+    report["pageSize"] = PageSize;
+    report["results"] = results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet("output")) {
+        QFile file(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "Cannot write " << file.fileName() << Qt::endl;
+            return 1;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    git_libgit2_shutdown();
+    return 0;
+}
@@ -40,6 +40,11 @@ Item {
         update()
     }
 
+    // The page is unloaded when another one is opened; leave no scan running for it
+    Component.onDestruction: {
+        root.statusController?.cancelStatus()
+    }
+
     /* Object Properties
      * ****************************************************************************************/
     anchors.fill: parent
@@ -176,11 +181,21 @@ Item {
                                             color: Style.colors.placeholderText
                                         }
                                         Text {
+                                            id: currentBranchText
                                             text: branchController.getCurrentBranchName()
                                             font.family: Style.fontTypes.roboto
                                             font.pixelSize: 10
                                             color: Style.colors.placeholderText
                                         }
+                                        Text {
+                                            // Ahead/behind of the upstream, from the last refresh of the branch status
+                                            property var status: branchController?.branchStatus[currentBranchText.text] ?? null
+                                            visible: status !== null
+                                            text: status ? "\u2191" + status.ahead + " \u2193" + status.behind : ""
+                                            font.family: Style.fontTypes.roboto
+                                            font.pixelSize: 10
+                                            color: Style.colors.placeholderText
+                                        }
                                         Item { Layout.fillWidth: true }
                                         Text {
                                             text: commitTextArea.text.length + " characters"
@@ -200,7 +215,7 @@ Item {
                                 id: commitBtn
                                 Layout.fillWidth: true
                                 Layout.preferredHeight: 30
-                                color: (changesFileLists.stagedModel.length > 0 && commitTextArea.text !== "")
+                                color: (changesFileLists.stagedModel.count > 0 && commitTextArea.text !== "")
                                         ? Style.colors.accent : Style.colors.disabledButton
                                 radius: 1
 
@@ -217,7 +232,7 @@ Item {
                                     anchors.fill: parent
                                     hoverEnabled: true
                                     cursorShape: Qt.PointingHandCursor
-                                    enabled: (changesFileLists.stagedModel.length > 0 && commitTextArea.text !== "")
+                                    enabled: (changesFileLists.stagedModel.count > 0 && commitTextArea.text !== "")
                                     onClicked: {
                                         let res = commitController.commit(commitTextArea.text, false, false)
 
@@ -278,17 +293,24 @@ Item {
                     Layout.fillHeight: true
                     color: "transparent"
 
-                    // Default fake data so the UI is visibly populated without git wiring.
-                    // Keep one list non-empty and the other empty to demonstrate both states.
-                    property var unstagedChanges: []
+                    // Rows are updated one by one as the status changes, not rebuilt
+                    ChangesModel {
+                        id: stagedChangesModel
+                        controller: root.statusController
+                        section: ChangesModel.Staged
+                    }
 
-                    property var stagedChanges: []
+                    ChangesModel {
+                        id: unstagedChangesModel
+                        controller: root.statusController
+                        section: ChangesModel.Unstaged
+                    }
 
                     ChangesFileLists {
                         id: changesFileLists
                         anchors.fill: parent
-                        unstagedModel: fileListsPanel.unstagedChanges
-                        stagedModel: fileListsPanel.stagedChanges
+                        unstagedModel: unstagedChangesModel
+                        stagedModel: stagedChangesModel
 
                         selectedFilePath: root.selectedFilePath
 
@@ -324,8 +346,8 @@ Item {
 
                         onUnstageAllRequested: function() {
 
-                            fileListsPanel.stagedChanges.forEach((file)=>{
-                                statusController.unstageFile(file.path)
+                            stagedChangesModel.paths().forEach((path)=>{
+                                statusController.unstageFile(path)
                             })
                             root.update()
                         }
@@ -335,15 +357,8 @@ Item {
                             root.update()
                         }
 
+                        // Stashing is not wired to git yet; the lists follow the status
                         onStashAllRequested: function(section) {
-                            if (section === "unstaged") {
-                                fileListsPanel.unstagedChanges = []
-                            }
-
-                            if (section === "staged") {
-                                fileListsPanel.stagedChanges = []
-                            }
-
                             if (root.selectedFilePath !== "" && root.selectedFilePath !== null)
                                 root.selectedFilePath = ""
                         }
@@ -390,24 +405,7 @@ Item {
     }
 
     function updateStatus() {
-        let res = statusController.status()
-
-        if (!res.success)
-            return;
-        fileListsPanel.unstagedChanges = []
-        fileListsPanel.stagedChanges = []
-
-        res.data.forEach((file)=>{
-            if (file.isStaged) {
-                fileListsPanel.stagedChanges.push(file)
-            }
-            if (file.isUnstaged || file.isUntracked) {
-                fileListsPanel.unstagedChanges.push(file)
-            }
-        })
-
-        fileListsPanel.unstagedChanges = fileListsPanel.unstagedChanges.slice(0)
-        fileListsPanel.stagedChanges = fileListsPanel.stagedChanges.slice(0)
+        statusController.loadStatus()
     }
 
     function update() {
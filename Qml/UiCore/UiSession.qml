@@ -34,6 +34,7 @@ QtObject {
             commitController.currentRepo = currentRepo
             statusController.currentRepo = currentRepo
             bundleController.currentRepo = currentRepo
+            branchController.refreshBranchStatus()
         }
     }
 
@@ -41,7 +42,10 @@ QtObject {
 
     property RemoteController remoteController: RemoteController {}
 
-    property CommitController commitController: CommitController {}
+    property CommitController commitController: CommitController {
+        // Refs moved: ahead/behind of the moved branches is counted again
+        onRefDecorationsChanged: root.branchController.refreshBranchStatus()
+    }
 
     property StatusController statusController: StatusController {}
 
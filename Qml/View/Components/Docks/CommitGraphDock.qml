@@ -6,7 +6,6 @@ import GitEase_Style
 import GitEase_Style_Impl
 import GitEase
 
-import "qrc:/GitEase/Qml/Core/Scripts/GraphLayout.js" as GraphLayout
 import "qrc:/GitEase/Qml/Core/Scripts/GraphUtils.js" as GraphUtils
 
 
@@ -28,11 +27,9 @@ Item {
 
     /* Property Declarations
      * ****************************************************************************************/
-    // Full data set (unfiltered) vs displayed set (filtered)
-    property var allCommits: []
+    // View rows of historyModel, laid out for the graph canvas
     property var commits: []
     property var selectedCommit: null
-    property var allCommitsHash: ({})
 
     // navigation state
     // navigationRule: one of ["Author Email", "Author", "Parent 1", "Branch"]
@@ -50,15 +47,19 @@ Item {
 
     // Lazy loading (infinite scroll)
     property int pageSize: 200
-    property int commitsOffset: 0
-    property bool isLoadingMore: false
-    property bool hasMoreCommits: true
 
     property int graphColumnWidth: 0  // Will be calculated as half of dock width
     property int commitItemHeight: 24  // Reduced spacing between commits
     property int commitItemSpacing: 4
     property int columnSpacing: 30  // Increased spacing between branch columns
-    property var commitPositions: ({})  // Cache for commit positions {hash: {x, y, column}}
+    readonly property int rowHeight: commitItemHeight + (commitItemSpacing * 2)
+    property var commitPositions: ({})  // Cache for commit positions {hash: {x, y, column, row}}
+    property int laneCount: 0
+
+    // Labels of the rows in view: [{row, column, texts, color}], see updateVisibleLabels()
+    property var visibleLabels: []
+    property int labelsFirstRow: -1
+    property int labelsLastRow: -1
 
     // Property to receive list of CommitData objects
     property int commitsColGraphWidth: parent.width * 0.08
@@ -82,7 +83,7 @@ Item {
      * ****************************************************************************************/
     function emptyStateDetailsText() {
         // 1) No commits in repo at all
-        if (!root.allCommits || root.allCommits.length === 0)
+        if (historyModel.loadedCount === 0)
             return "This repository has no commits."
 
         // 2) Commits exist, but filter/search returned no matches
@@ -120,88 +121,34 @@ Item {
         return GraphUtils.getCategoryColor(commitObj.colorKey)
     }
 
-    function edgeColor(edge, commitByHash) {
-        if (commitByHash && edge && edge.from) {
-            var fromCommit = commitByHash[edge.from]
-            if (fromCommit && fromCommit.colorKey)
-                return GraphUtils.getCategoryColor(fromCommit.colorKey)
-        }
-        return GraphUtils.getCategoryColor("edge:" + edge.from + ":" + edge.to)
-    }
-
     function normalizeFilterString(str) {
         return (str === null || str === undefined) ? "" : ("" + str)
     }
 
-    function parseDateYYYYMMDD(str) {
-        // Returns milliseconds since epoch, or NaN if invalid.
-        // Accepts:
-        // - YYYY-MM-DD
-        // - YYYY/MM/DD (used by GraphViewPage placeholders)
-        if (str === null || str === undefined)
-            return NaN
-
-        str = ("" + str).trim()
-        if (str.length < 8)
-            return NaN
-
-        // Split on '-' or '/'
-        var parts = str.split(/[-\/]/)
-        if (parts.length !== 3)
-            return NaN
-
-        var y = parseInt(parts[0])
-        var m = parseInt(parts[1])
-        var d = parseInt(parts[2])
-        if (isNaN(y) || isNaN(m) || isNaN(d))
-            return NaN
-
-        // local time midnight
-        return new Date(y, m - 1, d, 0, 0, 0, 0).getTime()
-    }
-
     /*!
-     * Application-level filter: checks if a commit matches based on selected filter modes
-     * Returns true if the commit matches the filter criteria
+     * Fetch the full message of commits that only carry their summary, in one batched call
      */
-    function applicationFilter(commit, needle, modes) {
-        if (!needle || needle.length === 0)
-            return true  // No text filter, matches all
+    function loadCommitMessages(commits) {
+        if (!commitController)
+            return
 
-        // If no modes selected, default to "Messages"
-        var activeMode = (modes && modes.length > 0) ? modes : ["Messages"]
-        
-        // Check each active filter mode
-        for (var i = 0; i < activeMode.length; i++) {
-            var mode = activeMode[i]
-            var haystack = ""
-            
-            switch(mode) {
-                case "Messages":
-                    haystack = normalizeFilterString(commit.summary) + " " + normalizeFilterString(commit.message)
-                    break
-                case "Subjects":
-                    haystack = normalizeFilterString(commit.summary)
-                    break
-                case "Authors":
-                    haystack = normalizeFilterString(commit.author)
-                    break
-                case "Emails":
-                    haystack = normalizeFilterString(commit.authorEmail)
-                    break
-                case "SHA-1":
-                    haystack = normalizeFilterString(commit.hash)
-                    break
-                default:
-                    continue
-            }
-            
-            // If any mode matches, return true
-            if (haystack.toLowerCase().indexOf(needle) !== -1)
-                return true
+        var missing = []
+        for (var i = 0; i < commits.length; i++) {
+            if (commits[i] && commits[i].message === undefined)
+                missing.push(commits[i].hash)
+        }
+        if (missing.length === 0)
+            return
+
+        var res = commitController.getCommitMessages(missing)
+        if (!res.success)
+            return
+
+        for (var j = 0; j < commits.length; j++) {
+            var c = commits[j]
+            if (c && c.message === undefined)
+                c.message = res.data[c.hash] || ""
         }
-        
-        return false  // No mode matched
     }
 
     function applyFilter(text, startDate, endDate, modes) {
@@ -214,173 +161,110 @@ Item {
         if (modes !== undefined)
             root.filterMode = modes
 
-        var base = root.allCommits || []
-        if (!base.length) {
-            loadData([])
-            return
-        }
-
-        var needle = normalizeFilterString(root.filterText).trim().toLowerCase()
-
-        var startMs = parseDateYYYYMMDD(root.filterStartDate)
-        var endMs = parseDateYYYYMMDD(root.filterEndDate)
-
-        if (!isNaN(endMs))
-            endMs = endMs + (24 * 60 * 60 * 1000) - 1
-
-        var filtered = []
-        for (var i = 0; i < base.length; i++) {
-            var c = base[i]
-            if (!c)
-                continue
-
-            // Date range filter (authorDate)
-            if (!isNaN(startMs) || !isNaN(endMs)) {
-                var commitMs = new Date(c.authorDate).getTime()
-                if (!isNaN(startMs) && !(commitMs >= startMs))
-                    continue
-                if (!isNaN(endMs) && !(commitMs <= endMs))
-                    continue
-            }
-
-            // Text filter using applicationFilter
-            if (!applicationFilter(c, needle, root.filterMode))
-                continue
-
-            filtered.push(c)
-        }
-
-        loadData(filtered)
-
-        // Auto-load more pages if filtered results are less than pageSize
-        ensureMinimumResults()
+        // Rows come back through historyModel.rowsInserted, one page at a time
+        historyModel.setFilter(normalizeFilterString(root.filterText), root.filterMode || [],
+                               root.filterStartDate, root.filterEndDate)
 
-        // If current selection is filtered out, clear it.
-        if (root.selectedCommit && root.selectedCommit.hash) {
-            var stillThere = filtered.find(function(x) { return x && x.hash === root.selectedCommit.hash })
-            if (!stillThere)
-                root.selectedCommit = null
-        }
+        // Drop a selection the filter hides
+        if (root.selectedCommit && !root.commits.some(function(c) { return c.hash === root.selectedCommit.hash }))
+            root.selectedCommit = null
     }
 
-    /*!
-     * Ensures that filtered results meet minimum threshold by loading more pages if needed.
-     * Automatically loads additional pages until we have at least pageSize results or no more commits.
-     */
-    function ensureMinimumResults() {
-        if (!root.hasAnyFilter) {
-            return
-        }
-
-        var currentResultCount = root.commits ? root.commits.length : 0
-        
-        if (currentResultCount >= root.pageSize || !root.hasMoreCommits || root.isLoadingMore) {
-            return
-        }
+    function clearFilter() {
+        root.filterText = ""
+        root.filterStartDate = ""
+        root.filterEndDate = ""
+        root.navigationRule = "Message"
 
-        loadMoreCommitsForFilter()
+        historyModel.setFilter("", [], "", "")
     }
 
-    /*!
-     * Loads additional commits specifically for filter scenarios.
-     * Continues loading until filtered results reach pageSize or no more commits available.
+    /**
+     * Load commit data and calculate graph layout positions
+     * Only rows from first on are laid out; rows above keep their positions
      */
-    function loadMoreCommitsForFilter() {
-        if (root.isLoadingMore || !root.hasMoreCommits) {
+    function loadData(commits, first) {
+        // Lanes, edges and color segments come from the rows of historyModel, laid out in C++.
+        // The engine starts over (first 0) when rows changed other than by appending.
+        var layout = graphLayoutEngine.layout(first || 0)
+        var start = layout.first
+        var lanes = layout.lanes
+        var colorRows = layout.colorRows
+        if (start + lanes.length !== commits.length)
             return
-        }
 
-        root.isLoadingMore = true
+        var positions = (start === 0) ? {} : root.commitPositions
+        var colors = []
+        for (var i = 0; i < lanes.length; i++) {
+            var j = start + i
+            var c = commits[j]
+            var lane = lanes[i]
+
+            positions[c.hash] = {
+                x: lane * root.columnSpacing,
+                y: j * root.rowHeight,
+                column: lane,
+                row: j,
+                branchName: (c.branchNames && c.branchNames.length > 0) ? c.branchNames[0] : "main",
+                lane: lane,
+                commitType: c.commitType || "normal"
+            }
 
-        var allBranches = branchController.getBranches();
-        let page = commitController.getCommits(pageSize, commitsOffset);
-        
-        if (!page || page.length === 0) {
-            root.hasMoreCommits = false
-            root.isLoadingMore = false
-            return
+            // A segment is named after its first commit (unique per checkout / new branch instance)
+            c.colorKey = "lane-seg:" + lane + ":" + commits[colorRows[i]].hash
+            colors.push(commitColor(c))
         }
 
-        var compiled = compileGraphCommits(page, allBranches);
-        var commits = root.allCommits.concat(compiled)
-        root.commitsOffset = commits.length
-        root.hasMoreCommits = (page.length === root.pageSize)
-
-        root.allCommits = commits.slice(0)
-        
-        var currentText = root.filterText
-        var currentStartDate = root.filterStartDate
-        var currentEndDate = root.filterEndDate
-        var currentModes = root.filterMode
-        
-        root.isLoadingMore = false
-        
-        root.applyFilter(currentText, currentStartDate, currentEndDate, currentModes)
-    }
+        // Edges and nodes are drawn by graphItem straight from the engine's layout
+        if (start === 0)
+            root.commitPositions = positions
+        graphItem.setRowColors(start, colors)
+        root.laneCount = layout.laneCount
 
-    function clearFilter() {
-        root.filterText = ""
-        root.filterStartDate = ""
-        root.filterEndDate = ""
-        root.navigationRule = "Message"
+        // Rows are appended in place; only notify when the array itself is the same
+        if (root.commits === commits)
+            root.commitsChanged()
+        else
+            root.commits = commits
 
-        loadData((root.allCommits || []).slice(0))
+        updateVisibleLabels(true)
     }
 
     /**
-     * Load commit data and calculate graph layout positions
+     * Collect the branch and tag labels of the rows in view
+     * Only rebuilt when the visible rows change, unless forced (labels or rows changed)
      */
-    function loadData(commits) {
-        commitPositions = GraphLayout.calculateDAGPositions(
-            commits,
-            root.columnSpacing,
-            root.commitItemHeight,
-            root.commitItemSpacing
-        );
-
-        // Color assignment:
-        var colorKeyByHash = {}
-
-        for (var j = commits.length - 1; j >= 0; j--) {
-            var c2 = commits[j]
-            var pos2 = root.commitPositions[c2.hash]
-            if (!pos2) continue
-
-            var inheritedKey = ""
-            if (c2.parentHashes && c2.parentHashes.length) {
-                // Find a parent in the same column; if found, inherit its color key.
-                for (var pi = 0; pi < c2.parentHashes.length; pi++) {
-                    var pHash = c2.parentHashes[pi]
-                    var pPos = root.commitPositions[pHash]
-                    if (pPos && pPos.column === pos2.column) {
-                        inheritedKey = colorKeyByHash[pHash] || ""
-                        break
-                    }
-                }
-            }
+    function updateVisibleLabels(force) {
+        var first = Math.max(0, Math.floor(graphFlickable.contentY / root.rowHeight))
+        var last = Math.min(root.commits.length - 1,
+                            Math.floor((graphFlickable.contentY + graphFlickable.height) / root.rowHeight))
+        if (!force && first === root.labelsFirstRow && last === root.labelsLastRow)
+            return
 
-            if (inheritedKey) {
-                c2.colorKey = inheritedKey
-            } else {
-                // Start a new segment (unique per checkout / new branch instance)
-                c2.colorKey = "lane-seg:" + pos2.column + ":" + c2.hash
-            }
+        root.labelsFirstRow = first
+        root.labelsLastRow = last
 
-            colorKeyByHash[c2.hash] = c2.colorKey
-        }
+        var labels = []
+        for (var r = first; r <= last; r++) {
+            var c = root.commits[r]
+            var pos = c ? root.commitPositions[c.hash] : null
+            if (!pos)
+                continue
 
-        root.commits = commits.slice(0)
-    }
+            // Tags first, then the branches pointing at the commit
+            var texts = (c.tagNames || []).slice()
+            for (var b = 0; c.branchNames && b < c.branchNames.length; b++)
+                texts.push(c.branchNames[b] + " (HEAD)")
+            if (texts.length === 0)
+                continue
 
-    /* Children
-     * ****************************************************************************************/
-    Connections {
-        target: Style
-        function onCurrentThemeChanged(){
-            graphCanvas.requestPaint()
+            labels.push({ row: r, column: pos.column, texts: texts, color: commitColor(c) })
         }
+        root.visibleLabels = labels
     }
 
+    /* Children
+     * ****************************************************************************************/
     Rectangle{
         anchors.fill: parent
         color : Style.colors.primaryBackground
@@ -759,26 +643,22 @@ Item {
                         // Calculate contentWidth based on max columns to avoid binding loop
                         contentWidth: {
                             if (root.commits.length === 0) return width
-                            var maxCols = 0
-                            for (var i = 0; i < root.commits.length; i++) {
-                                var commit = root.commits[i]
-                                var pos = root.commitPositions[commit.hash]
-                                if (pos && pos.column > maxCols) {
-                                    maxCols = pos.column
-                                }
-                            }
-                            var minWidth = 40 + (maxCols + 1) * root.columnSpacing + 300
+                            var minWidth = 40 + Math.max(root.laneCount, 1) * root.columnSpacing + 300
                             return Math.max(width, minWidth)
                         }
-                        contentHeight: Math.max(height, root.commits.length * (root.commitItemHeight + (commitItemSpacing * 2)))
+                        contentHeight: Math.max(height, root.commits.length * root.rowHeight)
                         boundsBehavior: Flickable.StopAtBounds
 
                         property bool syncScroll: false
 
+                        onHeightChanged: root.updateVisibleLabels(false)
+
                         // Sync scroll position with commits list
                         onContentYChanged: {
+                            root.updateVisibleLabels(false)
+
                             // Infinite scroll trigger (graph side)
-                            if (!root.isLoadingMore && root.hasMoreCommits) {
+                            if (!historyModel.loading) {
                                 var remaining = graphFlickable.contentHeight - (graphFlickable.contentY + graphFlickable.height)
                                 if (remaining < 300) {
                                     root.loadMoreCommits()
@@ -801,437 +681,88 @@ Item {
                             }
                         }
 
-                        // Single Canvas for entire DAG
-                        Canvas {
-                            id: graphCanvas
-                            // Use Flickable's contentWidth
+                        // Graph on the scene graph; only rows around the viewport get geometry
+                        CommitGraphItem {
+                            id: graphItem
                             width: graphFlickable.contentWidth
-                            height: root.commits.length * (root.commitItemHeight + (root.commitItemSpacing * 2))
-
-                            Connections {
-                                target: root
-                                function onSelectedCommitChanged() {
-                                    graphCanvas.requestPaint()
-                                }
+                            height: Math.max(graphFlickable.height, root.commits.length * root.rowHeight)
+
+                            layoutEngine: graphLayoutEngine
+                            rowHeight: root.rowHeight
+                            columnSpacing: root.columnSpacing
+                            nodeSize: root.commitItemHeight
+                            showAvatar: root.appModel?.appSettings?.generalSettings?.showAvatar ?? true
+                            avatarSource: "qrc:/GitEase/Resources/Images/defaultUserIcon.svg"
+                            selectedRow: {
+                                var pos = root.selectedCommit ? root.commitPositions[root.selectedCommit.hash] : null
+                                return pos ? pos.row : -1
                             }
+                            selectionColor: "#6088B2DF"
+                            viewportY: graphFlickable.contentY
+                            viewportHeight: graphFlickable.height
+                        }
 
-                            Component.onCompleted: {
-                                graphCanvas.requestPaint()
-                            }
-
-                            Connections {
-                                target: root
-                                function onCommitsChanged() {
-                                    var newHeight = Math.max(graphFlickable.height, root.commits.length * (root.commitItemHeight + (commitItemSpacing * 2)))
-                                    graphCanvas.height = newHeight
-                                    graphFlickable.contentHeight = newHeight
-                                    graphCanvas.requestPaint()
-                                    // Force contentWidth recalculation
-                                    graphFlickable.contentWidth = Qt.binding(function() {
-                                        if (root.commits.length === 0) return graphFlickable.width
-                                        var maxCols = 0
-                                        for (var i = 0; i < root.commits.length; i++) {
-                                            var commit = root.commits[i]
-                                            var pos = root.commitPositions[commit.hash]
-                                            if (pos && pos.column > maxCols) {
-                                                maxCols = pos.column
-                                            }
-                                        }
-                                        var minWidth = 40 + (maxCols + 1) * root.columnSpacing + 300
-                                        return Math.max(graphFlickable.width, minWidth)
-                                    })
-                                }
-                            }
-
-                            Connections {
-                                target: root
-                                function onCommitsColGraphWidthChanged() {
-                                    graphCanvas.requestPaint()
-                                }
-                            }
-
-                            property var svgImage: Image {
-                                source: "qrc:/GitEase/Resources/Images/defaultUserIcon.svg"
-                                anchors.centerIn: parent
-                                height: 14.5
-                                width: 14.5
-                            }
-
-                            onPaint: {
-                                // Always clear the canvas first. Otherwise, when commits becomes empty
-                                // (e.g., filter has no results), the old graph remains visible.
-                                var ctx = getContext("2d");
-
-                                // Erase previous frame completely
-                                ctx.clearRect(0, 0, width, height);
-                                ctx.globalAlpha = 1.0;
-                                ctx.fillStyle = Style.colors.primaryBackground;
-                                ctx.fillRect(0, 0, width, height);
-                                
-                                let showAvatar = root.appModel?.appSettings?.generalSettings?.showAvatar ?? true
-
-                                if (!root.commits || root.commits.length === 0)
-                                    return;
-
-                                // Calculate center offset for graph
-                                var maxColumns = 0;
-                                for (var i = 0; i < root.commits.length; i++) {
-                                    var commit = root.commits[i];
-                                    var pos = root.commitPositions[commit.hash];
-                                    if (pos && pos.column > maxColumns) {
-                                        maxColumns = pos.column;
-                                    }
-                                }
-
-                                // Start graph from left side
-                                var centerOffset = root.columnSpacing / 2; // Padding from left edge
-
-                                // Build quick lookup: hash -> commit object (for edge coloring)
-                                var commitByHash = {}
-                                for (var bi0 = 0; bi0 < root.commits.length; bi0++) {
-                                    var c0m = root.commits[bi0]
-                                    if (c0m && c0m.hash)
-                                        commitByHash[c0m.hash] = c0m
-                                }
-
-                                // Track branch HEAD commits for labels.
-                                // No separate branches model: HEAD labels are stored on commits as commit.branchNames.
-                                // Build a map: branchName -> commitHash for quick checks.
-                                var branchLatestCommit = {};
-                                for (var bi = 0; bi < root.commits.length; bi++) {
-                                    var bc = root.commits[bi];
-                                    if (bc && bc.branchNames && bc.branchNames.length) {
-                                        for (var bni = 0; bni < bc.branchNames.length; bni++) {
-                                            var bn = bc.branchNames[bni];
-                                            if (bn)
-                                                branchLatestCommit[bn] = bc.hash;
-                                        }
-                                    }
-                                }
-                                
-                                // Build edge routing information for better visualization
-                                // Track ALL parent connections
-                                var parentInSameLane = {};
-                                var crossLaneEdges = [];  // Store cross-lane edges (different columns)
-                                
-                                for (var j = 0; j < root.commits.length; j++) {
-                                    var c0 = root.commits[j];
-                                    var pos0 = root.commitPositions[c0.hash];
-                                    if (!pos0 || !c0.parentHashes) continue;
-                                    
-                                    // Process ALL parents
-                                    for (var p = 0; p < c0.parentHashes.length; p++) {
-                                        var parentHash = c0.parentHashes[p];
-                                        var parentPos = root.commitPositions[parentHash];
-                                        if (!parentPos) continue;
-                                        
-                                        if (parentPos.column === pos0.column) {
-                                            // Same lane - only store first one for straight line
-                                            if (!parentInSameLane[c0.hash]) {
-                                                parentInSameLane[c0.hash] = parentHash;
-                                            }
-                                        } else {
-                                            // Different lane - draw cross-lane edge
-                                            // For merge commits: draw FROM parent TO merge commit
-                                            // For normal commits: draw FROM child TO parent
-                                            var isMerge = c0.commitType === "merge";
-                                            crossLaneEdges.push({
-                                                from: isMerge ? parentHash : c0.hash,
-                                                to: isMerge ? c0.hash : parentHash,
-                                                fromPos: isMerge ? parentPos : pos0,
-                                                toPos: isMerge ? pos0 : parentPos,
-                                                isMerge: isMerge
-                                            });
-                                        }
-                                    }
-                                }
-
-                                // PHASE 1: Draw all continuation lines (same-lane parent connections)
-                                for (var j = 0; j < root.commits.length; j++) {
-                                    var commit2 = root.commits[j];
-                                    var pos2 = root.commitPositions[commit2.hash];
-                                    if (!pos2) continue;
-
-                                    var centerX = centerOffset + pos2.column * root.columnSpacing + root.columnSpacing / 2;
-                                    var centerY = pos2.y + root.commitItemHeight / 2 + root.commitItemSpacing;
-
-                                    // Draw straight line to parent in same lane
-                                    var parentHash = parentInSameLane[commit2.hash];
-                                    if (parentHash) {
-                                        var parentPos = root.commitPositions[parentHash];
-                                        if (parentPos) {
-                                            var parentX = centerOffset + parentPos.column * root.columnSpacing + root.columnSpacing / 2;
-                                            var parentY = parentPos.y + root.commitItemHeight / 2 + root.commitItemSpacing;
-                                            
-                                            var branchColor2 = commitColor(commit2);
-
-                                            ctx.save();
-                                            ctx.strokeStyle = branchColor2;
-                                            ctx.globalAlpha = 0.9;
-                                            ctx.lineWidth = 2.5;
-
-                                            ctx.beginPath();
-                                            ctx.moveTo(centerX, centerY);
-                                            ctx.lineTo(parentX, parentY);
-                                            ctx.stroke();
-                                            ctx.restore();
-                                        }
-                                    } else {
-                                        let canDraw = false
-                                        for(let i = 0; i < commit2.parentHashes.length; i++){
-                                            if(!allCommitsHash[commit2.parentHashes[i]]){
-                                                canDraw = true
-                                                break
-                                            }
-                                        }
-
-                                        if(canDraw){
-                                            var branchColor2 = commitColor(commit2);
-
-                                            ctx.save();
-                                            ctx.strokeStyle = branchColor2;
-                                            ctx.globalAlpha = 0.9;
-                                            ctx.lineWidth = 2.5;
-
-                                            ctx.beginPath();
-                                            ctx.moveTo(centerX, centerY);
-                                            ctx.lineTo(centerX, graphCanvas.height);
-                                            ctx.stroke();
-                                            ctx.restore();
-                                        }
-                                    }
-                                }
-                                
-                                // PHASE 2: Draw cross-lane edges (Diagonal/Bezier curves for different columns)
-                                for (var edgeIdx = 0; edgeIdx < crossLaneEdges.length; edgeIdx++) {
-                                    var edge = crossLaneEdges[edgeIdx];
-                                    var fromPos = edge.fromPos;
-                                    var toPos = edge.toPos;
-                                    
-                                    var fromX = centerOffset + fromPos.column * root.columnSpacing + root.columnSpacing / 2;
-                                    var fromY = fromPos.y + root.commitItemHeight / 2 + root.commitItemSpacing;
-                                    var toX = centerOffset + toPos.column * root.columnSpacing + root.columnSpacing / 2;
-                                    var toY = toPos.y + root.commitItemHeight / 2 + root.commitItemSpacing;
-                                    
-                                    // Color edge by the originating commit's lane/graph color
-                                    var edgeColorVal = edgeColor(edge, commitByHash)
-                                    
-                                    ctx.save();
-                                    ctx.strokeStyle = edgeColorVal;
-                                    ctx.globalAlpha = 0.85;
-                                    ctx.lineWidth = 2.5;
-                                    
-                                    ctx.beginPath();
-                                    
-                                    // Draw smooth Bezier curve for diagonal connection
-                                    ctx.moveTo(fromX, fromY);
-                                    
-                                    // Calculate control points for smooth curve
-                                    var verticalDistance = Math.abs(toY - fromY);
-                                    var horizontalDistance = Math.abs(toX - fromX);
-                                    
-                                    // Use bezier curve for smooth diagonal lines
-                                    // Control points are offset to create a natural curve
-                                    var controlOffset = Math.min(verticalDistance * 0.6, 40);
-                                    
-                                    let isUpside = toY < fromY
-
-                                    if (isUpside) {
-                                        ctx.bezierCurveTo(fromX, toY + 5, fromX - 2, toY, fromX - 20, toY);
-                                        ctx.lineTo(toX, toY);
-                                    } else {
-                                        ctx.lineTo(fromX, toY - 20);
-                                        ctx.bezierCurveTo(fromX, toY - 20, fromX - 2, toY, fromX - 20, toY);
-                                        ctx.lineTo(toX, toY);
-                                    }
-                                    
-                                    ctx.stroke();
-                                    ctx.restore();
-                                }
-
-                                // First pass: Draw lines from nodes to branch/tag labels (only for HEAD commits)
-                                for (var lineIdx = 0; lineIdx < root.commits.length; lineIdx++) {
-                                    var commitForLine = root.commits[lineIdx];
-                                    var posForLine = root.commitPositions[commitForLine.hash];
-                                    if (!posForLine) continue;
+                        // Branch and tag labels of the visible rows
+                        Repeater {
+                            model: root.visibleLabels
 
-                                    // Check if this commit is a HEAD of ANY branch
-                                    var isHeadCommitForLabels = false;
-                                    var headBranchesForThisCommit = [];
-                                    
-                                    // Check ALL branches to see if this commit is a HEAD
-                                    for (var branchKey in branchLatestCommit) {
-                                        if (branchLatestCommit[branchKey] === commitForLine.hash) {
-                                            isHeadCommitForLabels = true;
-                                            headBranchesForThisCommit.push(branchKey);
-                                        }
-                                    }
+                            delegate: Item {
+                                id: labelRow
 
-                                    // Only show labels for HEAD commits
-                                    if (!isHeadCommitForLabels) continue;
-
-                                    var centerXForLine = centerOffset + posForLine.column * root.columnSpacing + root.columnSpacing / 2;
-                                    var centerYForLine = posForLine.y + root.commitItemHeight / 2 + root.commitItemSpacing;
-
-                                    // Collect all labels (tags first, then branches) for this commit
-                                    // Label colors are based on the commit's lane/graph color
-                                    var laneLabelColor = commitColor(commitForLine)
-                                    var allLabels = [];
-
-                                    // Add tag labels first (left side)
-                                    if (commitForLine.tagNames && commitForLine.tagNames.length > 0) {
-                                        for (var tIdx = 0; tIdx < commitForLine.tagNames.length; tIdx++) {
-                                            var tagName = commitForLine.tagNames[tIdx];
-                                            allLabels.push({
-                                                text: tagName,
-                                                color: laneLabelColor
-                                            });
-                                        }
-                                    }
+                                required property var modelData
 
-                                    // Add branch labels for HEAD branches
-                                    // Each label uses the lane/graph color
-                                    for (var hbi = 0; hbi < headBranchesForThisCommit.length; hbi++) {
-                                        var headBranchName = headBranchesForThisCommit[hbi];
-                                        allLabels.push({
-                                            text: headBranchName + " (HEAD)",
-                                            color: laneLabelColor
-                                        });
-                                    }
+                                readonly property real nodeX: (modelData.column + 1) * root.columnSpacing
+                                readonly property real nodeRadius: graphItem.showAvatar ? root.commitItemHeight / 2 : 5
 
-                                    // Draw all labels on same horizontal line
-                                    if (allLabels.length > 0) {
-                                        // Align labels to start at the Graph/BranchTag divider position
-                                        // But ensure labels start AFTER the commit node (never overlap or go backwards)
-                                        var dividerPosition = root.commitsColGraphWidth + 10;  // Position at divider + small padding
-                                        var nodeEndPosition = centerXForLine + 20;  // Node position + node radius + padding
-                                        var labelStartX = Math.max(dividerPosition, nodeEndPosition);  // Use whichever is further right
-                                        var labelY = centerYForLine;  // Same Y as node (horizontal line)
-                                        var currentLabelX = labelStartX;
-                                        var labelSpacing = 8;  // Horizontal spacing between labels
-
-                                        // Calculate positions for all labels
-                                        var labelPositions = [];
-                                        for (var calcIdx = 0; calcIdx < allLabels.length; calcIdx++) {
-                                            var calcLabelInfo = allLabels[calcIdx];
-                                            ctx.font = "bold 11px Arial";
-                                            ctx.textAlign = "left";
-                                            var calcTextMetrics = ctx.measureText(calcLabelInfo.text);
-                                            var calcLabelWidth = calcTextMetrics.width + 16;
-                                            labelPositions.push({
-                                                x: currentLabelX,
-                                                width: calcLabelWidth,
-                                                info: calcLabelInfo
-                                            });
-                                            currentLabelX += calcLabelWidth + labelSpacing;
-                                        }
-
-                                        // Draw single connecting line using first label's color
-                                        if (labelPositions.length > 0) {
-                                            var firstLabel = labelPositions[0];
-                                            var lastLabel = labelPositions[labelPositions.length - 1];
-                                            var lineEndX = lastLabel.x + lastLabel.width;
-                                            
-                                            ctx.save();
-                                            ctx.strokeStyle = laneLabelColor;  // Use commit lane/graph color
-                                            ctx.globalAlpha = 0.8;
-                                            ctx.lineWidth = 5;
-
-                                            ctx.beginPath();
-                                            ctx.moveTo(centerXForLine, centerYForLine);
-                                            ctx.lineTo(lineEndX, labelY);
-                                            ctx.stroke();
-                                            ctx.restore();
-                                        }
+                                x: 0
+                                y: modelData.row * root.rowHeight + root.rowHeight / 2 - height / 2
+                                width: graphItem.width
+                                height: 20
 
-                                        // Draw all labels
-                                        for (var labelDrawIdx = 0; labelDrawIdx < labelPositions.length; labelDrawIdx++) {
-                                            var labelPos = labelPositions[labelDrawIdx];
-                                            var labelInfo = labelPos.info;
-                                            var labelX = labelPos.x;
-                                            var labelWidth = labelPos.width;
-                                            var labelHeight = 20;
-                                            var labelRectY = labelY - labelHeight / 2;
-
-                                            ctx.save();
-                                            ctx.fillStyle = labelInfo.color;
-                                            ctx.globalAlpha = 0.95;
-                                            GraphUtils.drawRoundedRect(ctx, labelX, labelRectY, labelWidth, labelHeight, 2);
-                                            ctx.fill();
-
-                                            // Enhanced label styling with better contrast
-                                            var contrastColor = GraphUtils.getContrastColor(labelInfo.color);
-                                            ctx.fillStyle = contrastColor;
-                                            ctx.globalAlpha = 1.0;
-                                            ctx.font = "bold 11px 'Segoe UI', Arial, sans-serif";
-                                            ctx.textAlign = "left";
-                                            ctx.textBaseline = "middle";
-                                            ctx.fillText(labelInfo.text, labelX + 8, labelY);
-                                            ctx.restore();
-                                        }
-                                    }
+                                // Single connecting line from the node to the last label
+                                Rectangle {
+                                    x: labelRow.nodeX + labelRow.nodeRadius
+                                    anchors.verticalCenter: parent.verticalCenter
+                                    width: Math.max(0, labels.x + labels.width - x)
+                                    height: 5
+                                    color: labelRow.modelData.color
+                                    opacity: 0.8
                                 }
 
-                                // Second pass: Draw commit nodes (on top of lines)
-                                for (var k = 0; k < root.commits.length; k++) {
-                                    var commit3 = root.commits[k];
-                                    var pos3 = root.commitPositions[commit3.hash];
-                                    if (!pos3) continue;
-
-                                    var centerX2 = centerOffset + pos3.column * root.columnSpacing + root.columnSpacing / 2;
-                                    var centerY2 = pos3.y + root.commitItemHeight / 2 + root.commitItemSpacing;
-
-                                    var branchColor3 = commitColor(commit3);
-
-                                    // Determine HEAD status without falling back to "main"
-                                    var isHeadCommit = false;
-                                    if (commit3.branchNames && commit3.branchNames.length) {
-                                        for (var hb = 0; hb < commit3.branchNames.length; hb++) {
-                                            var bname = commit3.branchNames[hb]
-                                            if (branchLatestCommit && branchLatestCommit[bname] === commit3.hash) {
-                                                isHeadCommit = true;
-                                                break;
+                                // Labels start at the Graph/BranchTag divider, but never over the node
+                                Row {
+                                    id: labels
+                                    x: Math.max(root.commitsColGraphWidth + 10, labelRow.nodeX + 20)
+                                    height: parent.height
+                                    spacing: 8
+
+                                    Repeater {
+                                        model: labelRow.modelData.texts
+
+                                        delegate: Rectangle {
+                                            required property string modelData
+
+                                            width: labelText.implicitWidth + 16
+                                            height: 20
+                                            radius: 2
+                                            color: labelRow.modelData.color
+                                            opacity: 0.95
+
+                                            Text {
+                                                id: labelText
+                                                x: 8
+                                                anchors.verticalCenter: parent.verticalCenter
+                                                text: parent.modelData
+                                                color: GraphUtils.getContrastColor(labelRow.modelData.color)
+                                                font.pixelSize: 11
+                                                font.bold: true
                                             }
                                         }
                                     }
-                                    var isSelected = root.selectedCommit && root.selectedCommit.hash === commit3.hash;
-
-                                    // Highlight selected commit row
-                                    if (isSelected) {
-                                        ctx.fillStyle = "#6088B2DF";
-                                        ctx.fillRect(0, pos3.y, graphCanvas.width, root.commitItemHeight + (root.commitItemSpacing * 2));
-                                    }
-
-                                    var avatarSize = showAvatar ? root.commitItemHeight : 10;
-                                    var avatarRadius = avatarSize / 2;
-
-                                    // All commits: Circle with avatar (same style)
-                                    ctx.save();
-                                    ctx.strokeStyle = isSelected ? GraphUtils.darkenColor(branchColor3, 0.2): GraphUtils.lightenColor(branchColor3, 0.3);
-                                    ctx.lineWidth = isSelected ? 4 : 2.5;
-
-                                    ctx.beginPath();
-                                    ctx.arc(centerX2, centerY2, avatarRadius, 0, 2 * Math.PI);
-                                    ctx.fillStyle = showAvatar ? "#D9D9D9" : GraphUtils.lightenColor(branchColor3, 0.3);
-                                    ctx.fill();
-                                    ctx.stroke();
-
-                                    if (showAvatar) {
-                                        // Draw avatar icon
-                                        ctx.fillStyle = "#ffffff";
-                                        ctx.font = (avatarSize * 0.8) + "px Arial";
-                                        ctx.textAlign = "center";
-                                        ctx.textBaseline = "middle";
-
-                                        var drawX = centerX2 - svgImage.width / 2;
-                                        var drawY = centerY2 - svgImage.height / 2;
-                                        ctx.drawImage(svgImage, drawX, drawY);
-                                    }
-                                    ctx.restore();
                                 }
-
                             }
                         }
+                        }
                     }
                 }
 
@@ -1241,7 +772,7 @@ Item {
                     Layout.fillWidth: true
                     Layout.preferredWidth: root.commitsColMessageWidth + root.commitsColAuthorWidth+ root.commitsColDateWidth
                     Layout.fillHeight: true
-                    model: root.commits
+                    model: historyModel
                     clip: true
 
                     property bool syncScroll: false
@@ -1249,7 +780,7 @@ Item {
                     // Sync scroll position with graph
                     onContentYChanged: {
                         // Infinite scroll trigger (list side)
-                        if (!root.isLoadingMore && root.hasMoreCommits) {
+                        if (!historyModel.loading) {
                             var remaining = commitsListView.contentHeight - (commitsListView.contentY + commitsListView.height)
                             if (remaining < 300) {
                                 root.loadMoreCommits()
@@ -1276,7 +807,7 @@ Item {
                         width: ListView.view.width
                         height: root.commitItemHeight + commitItemSpacing + commitItemSpacing
 
-                        property var commitData: modelData
+                        property var commitData: root.commits[index] || ({})
                         property bool isHovered: false
                         property bool isSelected: root.selectedCommit && root.selectedCommit.hash === commitData.hash
 
@@ -1424,67 +955,34 @@ Item {
         }
     }
 
-    /**
-     * Load all commits from repository
-     */
-    // Build graph-ready commits by combining:
-    // - getCommits(): list of commits (hash, summary, author, ...)
-    // - getCommit(hash): per-commit details (parentHashes, etc)
-    // - getBranches(): to attach branch name labels to tip commits (targetHash)
-    function compileGraphCommits(rawCommits, rawBranches) {
-        if (!rawCommits) return []
-
-        // tip commit hash -> [branchName,...]
-        var tipHashToBranches = {}
-        var branchTipHashes = []
-        if (rawBranches && rawBranches.length) {
-            for (var i = 0; i < rawBranches.length; i++) {
-                var b = rawBranches[i]
-                if (!b || !b.targetHash) continue
-                if (!tipHashToBranches[b.targetHash]) {
-                    tipHashToBranches[b.targetHash] = []
-                    branchTipHashes.push(b.targetHash)
-                }
-                tipHashToBranches[b.targetHash].push(b.name)
-            }
-        }
-
-        // Build commits
-        var compiled = []
-
-        for (var c = 0; c < rawCommits.length; c++) {
-            var commit = rawCommits[c]
-
-            var parentHashes = []
-            var details = commit
-            if (details && details.parentHashes) {
-                parentHashes = details.parentHashes
-            }
-
-            var obj = {
-                hash: commit.hash,
-                shortHash: commit.shortHash,
-                message: commit.message,
-                summary: commit.summary,
-                author: commit.author,
-                authorEmail: commit.authorEmail,
-                authorDate: commit.authorDate,
-
-                parentHashes: parentHashes,
-                commitType: (parentHashes.length > 1) ? "merge" : "normal",
-
-                // Only branch tips start with branch names; we'll propagate membership below
-                branchNames: tipHashToBranches[commit.hash] || [],
-                tagNames: [],
-
-                // assigned in loadData() after layout (lane -> category)
-                colorKey: ""
-            }
-
-            compiled.push(obj)
+    // Build a graph-ready commit from a historyModel row (get(row)): the history row
+    // exposed by CommitHistoryModel, decorated with the refs pointing at it and the
+    // branches containing it
+    function compileGraphCommit(row) {
+        var parentHashes = row.parentHashes
+
+        return {
+            hash: row.hash,
+            shortHash: row.shortHash,
+            // Full body is fetched on demand (see loadCommitMessages)
+            message: undefined,
+            summary: row.summary,
+            author: row.author,
+            authorEmail: row.authorEmail,
+            authorDate: row.authorDate,
+
+            parentHashes: parentHashes,
+            commitType: (parentHashes.length > 1) ? "merge" : "normal",
+
+            // Labels: only the branches and tags pointing at this commit
+            branchNames: row.branchNames,
+            tagNames: row.tagNames,
+            // Membership: every branch this commit is part of (RefMembershipIndex)
+            containingBranches: row.branches,
+
+            // assigned in loadData() after layout (lane -> category)
+            colorKey: ""
         }
-
-        return compiled
     }
 
     function selectedIndex() {
@@ -1663,67 +1161,89 @@ Item {
         GraphUtils.clearTagColorCache();
         GraphUtils.clearCategoryColorCache();
 
-        commitsOffset = 0
-        hasMoreCommits = true
-        isLoadingMore = false
+        // Only commits added since the last load are walked; new rows arrive through historyModel,
+        // labels of rows already shown through onDataChanged
+        historyModel.refresh()
+    }
 
-        let allBranches = branchController.getBranches();
-        let commitRes = commitController.getCommits(pageSize, commitsOffset);
+    function loadMoreCommits() {
+        if (!root.appModel || !root.appModel.currentRepository)
+            return
 
-        if (!commitRes.success)
-            return;
-        let page = commitRes.data;
+        historyModel.loadMore()
+    }
 
-        var commits = compileGraphCommits(page, allBranches);
-        commitsOffset = commits.length
-        hasMoreCommits = (page && page.length === pageSize)
+    CommitHistoryModel {
+        id: historyModel
+        controller: root.commitController
+        pageSize: root.pageSize
+    }
 
-        // Store full dataset and apply current filter
-        root.allCommits = commits.slice(0)
-        root.applyFilter(root.filterText, root.filterStartDate, root.filterEndDate)
+    GraphLayoutEngine {
+        id: graphLayoutEngine
+        model: historyModel
     }
 
-    function loadMoreCommits() {
-        if (isLoadingMore || !hasMoreCommits)
-            return
-        if (!branchController || !root.appModel || !root.appModel.currentRepository)
-            return
+    Connections {
+        target: historyModel
 
-        var currentContentY = commitsListView.contentY;
-        isLoadingMore = true
+        function onRowsInserted(parent, first, last) {
+            var currentContentY = commitsListView.contentY;
 
-        let allBranches = branchController.getBranches();
-        let commitRes = commitController.getCommits(pageSize, commitsOffset);
+            // Only the new rows are compiled; earlier rows keep their objects
+            var added = []
+            for (var r = first; r <= last; r++)
+                added.push(root.compileGraphCommit(historyModel.get(r)))
 
-        if (!commitRes.success)
-            return;
-        let page = commitRes.data;
-        if (!page || page.length === 0) {
-            hasMoreCommits = false
-            isLoadingMore = false
-            return
-        }
-
-        var compiled = compileGraphCommits(page, allBranches);
+            // Appended pages, or commits made since the last load at the top
+            var commits = root.commits
+            Array.prototype.splice.apply(commits, [first, 0].concat(added))
 
-        var commits = root.allCommits.concat(compiled)
-        commitsOffset = commits.length
-        hasMoreCommits = (page.length === pageSize)
+            root.loadData(commits, first)
+            commitsListView.contentY = currentContentY;
+        }
 
-        root.allCommits = commits.slice(0)
-        root.applyFilter(root.filterText, root.filterStartDate, root.filterEndDate)
+        function onModelReset() {
+            root.commits = []
+            root.commitPositions = {}
+            root.laneCount = 0
+            graphItem.setRowColors(0, [])
+            updateVisibleLabels(true)
+        }
 
-        commitsListView.contentY = currentContentY;
+        // Refs moved: labels and membership of rows already shown are recomputed in C++
+        function onDataChanged(topLeft, bottomRight, roles) {
+            // Only the rows the model reports; no roles means all of them changed
+            var last = Math.min(bottomRight.row, root.commits.length - 1)
+            var labels = roles.length === 0 || roles.indexOf(CommitHistoryModel.BranchNamesRole) >= 0
+            var branches = roles.length === 0 || roles.indexOf(CommitHistoryModel.BranchesRole) >= 0
+
+            for (var r = topLeft.row; r <= last; r++) {
+                var index = historyModel.index(r, 0)
+                var c = root.commits[r]
+                if (labels) {
+                    c.branchNames = historyModel.data(index, CommitHistoryModel.BranchNamesRole)
+                    c.tagNames = historyModel.data(index, CommitHistoryModel.TagNamesRole)
+
+                    var pos = root.commitPositions[c.hash]
+                    if (pos)
+                        pos.branchName = (c.branchNames && c.branchNames.length > 0) ? c.branchNames[0] : "main"
+                }
+                if (branches)
+                    c.containingBranches = historyModel.data(index, CommitHistoryModel.BranchesRole)
+            }
 
-        isLoadingMore = false
+            // Labels are drawn over the graph; lanes do not depend on them
+            if (labels && root.commits.length > 0)
+                updateVisibleLabels(true)
+        }
     }
 
     onRepositoryControllerChanged: reloadAll();
 
-    onAllCommitsChanged: {
-        root.allCommitsHash = {}
-        for(let i = 0 ; i < root.allCommits.length; ++i)
-            root.allCommitsHash[root.allCommits[i].hash] = root.allCommits[i].hash
+    onSelectedCommitChanged: {
+        if (root.selectedCommit)
+            loadCommitMessages([root.selectedCommit])
     }
 
     Connections {
@@ -1732,11 +1252,4 @@ Item {
             reloadAll();
         }
     }
-
-    Connections {
-        target: appModel?.appSettings?.generalSettings ?? null
-        function onShowAvatarChanged() {
-            graphCanvas.requestPaint()
-        }
-    }
 }
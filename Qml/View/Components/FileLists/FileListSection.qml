@@ -195,11 +195,12 @@ Rectangle {
                                 if (!item)
                                     return
 
-                                item.rowModelData = modelData
-                                item.rowIndex = index
+                                // Bound, not copied: rows are updated and moved in place when the model changes
+                                item.rowModelData = Qt.binding(() => modelData)
+                                item.rowIndex = Qt.binding(() => index)
 
                                 if (item.hasOwnProperty("showSeparator"))
-                                    item.showSeparator = index < (listView.count - 1)
+                                    item.showSeparator = Qt.binding(() => index < (listView.count - 1))
                             }
                         }
                     }
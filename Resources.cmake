@@ -28,7 +28,6 @@ set(RESOURCES_CORE
 
     # Scripts
     Qml/Core/Scripts/GraphUtils.js
-    Qml/Core/Scripts/GraphLayout.js
 )
 
 
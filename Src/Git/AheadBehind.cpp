@@ -0,0 +1,187 @@
+#include "AheadBehind.h"
+#include "OidHash.h"
+
+#include <git2/commit.h>
+#include <git2/errors.h>
+
+#include <QHash>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <queue>
+
+namespace {
+// Bit 2i marks the local tip of pair i, bit 2i+1 its upstream
+constexpr quint64 LocalBits = 0x5555555555555555ULL;
+
+struct Node
+{
+    git_time_t time = 0;
+    QVector<git_oid> parents;
+    bool queued = false;
+};
+
+class Walk
+{
+public:
+    Walk(git_repository *repo, int pairCount)
+        : m_repo(repo),
+          m_words((pairCount * 2 + 63) / 64)
+    {}
+
+    /**
+     * \brief Node of a commit, read on first use; -1 if the commit can't be read
+     */
+    int node(const git_oid &oid)
+    {
+        const auto it = m_index.constFind(oid);
+        if (it != m_index.constEnd())
+            return it.value();
+
+        git_commit *commit = nullptr;
+        if (git_commit_lookup(&commit, m_repo, &oid) != GIT_OK)
+            return -1;
+
+        Node node;
+        node.time = git_commit_time(commit);
+        const unsigned int parentCount = git_commit_parentcount(commit);
+        node.parents.reserve(parentCount);
+        for (unsigned int i = 0; i < parentCount; ++i)
+            node.parents.append(*git_commit_parent_id(commit, i));
+        git_commit_free(commit);
+
+        const int index = m_nodes.size();
+        m_nodes.append(node);
+        m_flags.resize(m_flags.size() + m_words);
+        m_index.insert(oid, index);
+        return index;
+    }
+
+    /**
+     * \brief Whether some pair has exactly one of its two bits set on a node
+     */
+    bool isInteresting(int index) const
+    {
+        const quint64 *flags = m_flags.constData() + index * m_words;
+        for (int w = 0; w < m_words; ++w) {
+            if ((flags[w] ^ (flags[w] >> 1)) & LocalBits)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * \brief Add bits to a node and queue it if they changed anything
+     */
+    void paint(int index, const quint64 *bits)
+    {
+        quint64 *flags = m_flags.data() + index * m_words;
+        bool changed = false;
+        for (int w = 0; w < m_words; ++w) {
+            if (bits[w] & ~flags[w])
+                changed = true;
+        }
+        if (!changed)
+            return;
+
+        Node &node = m_nodes[index];
+        const bool wasInteresting = node.queued && isInteresting(index);
+        for (int w = 0; w < m_words; ++w)
+            flags[w] |= bits[w];
+
+        if (!node.queued) {
+            // Also re-queues a commit already visited, should dates be skewed
+            node.queued = true;
+            m_queue.push({ node.time, index });
+        }
+        m_interesting += (isInteresting(index) ? 1 : 0) - (wasInteresting ? 1 : 0);
+    }
+
+    void setBit(int index, int bit)
+    {
+        QVector<quint64> bits(m_words, 0);
+        bits[bit / 64] |= quint64(1) << (bit % 64);
+        paint(index, bits.constData());
+    }
+
+    bool run()
+    {
+        QVector<quint64> bits(m_words);
+
+        while (m_interesting > 0 && !m_queue.empty()) {
+            const int index = m_queue.top().second;
+            m_queue.pop();
+
+            m_nodes[index].queued = false;
+            if (isInteresting(index))
+                m_interesting--;
+
+            // Copy: creating parents may reallocate the flag storage
+            std::copy_n(m_flags.constData() + index * m_words, m_words, bits.data());
+            const QVector<git_oid> parents = m_nodes.at(index).parents;
+            for (const git_oid &parent : parents) {
+                const int parentIndex = node(parent);
+                if (parentIndex < 0)
+                    return false;
+                paint(parentIndex, bits.constData());
+            }
+        }
+
+        return true;
+    }
+
+    void count(QVector<AheadBehindCount> &out) const
+    {
+        for (int index = 0; index < m_nodes.size(); ++index) {
+            const quint64 *flags = m_flags.constData() + index * m_words;
+            for (int w = 0; w < m_words; ++w) {
+                quint64 differing = (flags[w] ^ (flags[w] >> 1)) & LocalBits;
+                while (differing) {
+                    const int bit = qCountTrailingZeroBits(differing);
+                    differing &= differing - 1;
+
+                    AheadBehindCount &pair = out[(w * 64 + bit) / 2];
+                    if (flags[w] & (quint64(1) << bit))
+                        pair.ahead++;
+                    else
+                        pair.behind++;
+                }
+            }
+        }
+    }
+
+private:
+    git_repository *m_repo = nullptr;
+    int m_words = 0;
+    QVector<Node> m_nodes;
+    QVector<quint64> m_flags;               ///< m_words per node
+    QHash<git_oid, int> m_index;
+    std::priority_queue<std::pair<git_time_t, int>> m_queue;   ///< Newest first
+    int m_interesting = 0;                  ///< Queued nodes isInteresting() holds for
+};
+}
+
+bool AheadBehind::compute(git_repository *repo, const QVector<QPair<git_oid, git_oid>> &pairs,
+                          QVector<AheadBehindCount> &out)
+{
+    out = QVector<AheadBehindCount>(pairs.size());
+    if (!repo || pairs.isEmpty())
+        return true;
+
+    Walk walk(repo, pairs.size());
+    for (int i = 0; i < pairs.size(); ++i) {
+        const int local = walk.node(pairs.at(i).first);
+        const int upstream = walk.node(pairs.at(i).second);
+        if (local < 0 || upstream < 0)
+            return false;
+
+        walk.setBit(local, i * 2);
+        walk.setBit(upstream, i * 2 + 1);
+    }
+
+    if (!walk.run())
+        return false;
+
+    walk.count(out);
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QPair>
+#include <QVector>
+
+#include <git2/oid.h>
+#include <git2/types.h>
+
+/**
+ * \brief Commits a tip has that its counterpart does not, and the reverse
+ */
+struct AheadBehindCount
+{
+    int ahead = 0;      ///< Reachable from the local tip only
+    int behind = 0;     ///< Reachable from the upstream tip only
+};
+
+/**
+ * \brief Ahead/behind counts of many tip pairs from one shared walk
+ *
+ * git_graph_ahead_behind walks each pair separately, so branches sharing
+ * most of their history pay for it once per branch. Here every tip gets a
+ * bit; bits are painted down the graph in commit time order, each commit
+ * is visited once for all pairs, and the walk stops as soon as no queued
+ * commit is reachable from only one side of any pair.
+ *
+ * Like git's merge-base walk, the time order assumes commit dates are not
+ * badly skewed.
+ */
+class AheadBehind
+{
+public:
+    /**
+     * \brief Count ahead/behind for every (local, upstream) pair
+     * \param repo Repository to walk; not shared with other threads while running
+     * \param pairs Local and upstream tip of each pair
+     * \param out Receives one count per pair, in the same order
+     * \return false if a commit could not be read
+     */
+    static bool compute(git_repository *repo, const QVector<QPair<git_oid, git_oid>> &pairs,
+                        QVector<AheadBehindCount> &out);
+};
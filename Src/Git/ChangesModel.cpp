@@ -0,0 +1,249 @@
+#include "ChangesModel.h"
+
+#include <algorithm>
+
+namespace {
+
+bool sameStatus(const GitFileStatus &a, const GitFileStatus &b)
+{
+    return a.status() == b.status() && a.isStaged() == b.isStaged()
+           && a.isUnstaged() == b.isUnstaged() && a.isUntracked() == b.isUntracked();
+}
+
+bool pathLess(const GitFileStatus &a, const GitFileStatus &b)
+{
+    return a.path() < b.path();
+}
+
+}
+
+ChangesModel::ChangesModel(QObject *parent)
+    : QAbstractListModel{parent}
+{}
+
+int ChangesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_rows.size());
+}
+
+QVariant ChangesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size())
+        return QVariant();
+
+    const GitFileStatus &file = m_rows.at(index.row());
+
+    switch (role) {
+    case FileRole:
+        return QVariant::fromValue(file);
+    case PathRole:
+        return file.path();
+    case StatusRole:
+        return file.status();
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ChangesModel::roleNames() const
+{
+    return {
+        { FileRole, "modelData" },
+        { PathRole, "path" },
+        { StatusRole, "status" }
+    };
+}
+
+GitStatus *ChangesModel::controller() const
+{
+    return m_controller;
+}
+
+void ChangesModel::setController(GitStatus *controller)
+{
+    if (m_controller == controller)
+        return;
+
+    if (m_controller)
+        disconnect(m_controller, nullptr, this, nullptr);
+
+    m_controller = controller;
+    clear();
+
+    if (m_controller) {
+        connect(m_controller, &GitStatus::statusStarted, this, &ChangesModel::statusStarted);
+        connect(m_controller, &GitStatus::statusBatchLoaded, this, &ChangesModel::statusBatchLoaded);
+        connect(m_controller, &GitStatus::statusFinished, this, &ChangesModel::statusFinished);
+
+        // Rows of another repository have nothing in common with the next status
+        connect(m_controller, &IGitController::currentRepoChanged, this, &ChangesModel::clear);
+    }
+
+    emit controllerChanged();
+}
+
+ChangesModel::Section ChangesModel::section() const
+{
+    return m_section;
+}
+
+void ChangesModel::setSection(Section section)
+{
+    if (m_section == section)
+        return;
+
+    m_section = section;
+    clear();
+    emit sectionChanged();
+}
+
+int ChangesModel::count() const
+{
+    return int(m_rows.size());
+}
+
+QStringList ChangesModel::paths() const
+{
+    QStringList paths;
+    paths.reserve(m_rows.size());
+    for (const GitFileStatus &file : m_rows)
+        paths.append(file.path());
+
+    return paths;
+}
+
+void ChangesModel::statusStarted()
+{
+    m_pending.clear();
+}
+
+void ChangesModel::statusBatchLoaded(const QList<GitFileStatus> &files)
+{
+    // A file may come in two batches (staged, then modified again); rows show both
+    QStringList batchPaths;
+    batchPaths.reserve(files.size());
+    for (const GitFileStatus &file : files) {
+        const auto it = m_pending.find(file.path());
+        if (it == m_pending.end())
+            m_pending.insert(file.path(), file);
+        else
+            it.value() = it.value().merged(file);
+
+        batchPaths.append(file.path());
+    }
+    batchPaths.removeDuplicates();
+
+    QVector<GitFileStatus> sectionFiles;
+    for (const QString &path : std::as_const(batchPaths)) {
+        const GitFileStatus &file = m_pending[path];
+        if (accepts(file))
+            sectionFiles.append(file);
+    }
+    std::sort(sectionFiles.begin(), sectionFiles.end(), pathLess);
+
+    applyFiles(sectionFiles);
+}
+
+void ChangesModel::statusFinished(const QVariantMap &result)
+{
+    // A failed status says nothing about the rows that were not seen
+    if (result.value("success").toBool())
+        removeStaleRows();
+
+    m_pending.clear();
+}
+
+void ChangesModel::applyFiles(const QVector<GitFileStatus> &files)
+{
+    // Changed rows are updated in place; new ones are collected with the row they go before
+    QVector<QPair<int, GitFileStatus>> inserts;
+    for (const GitFileStatus &file : files) {
+        const int row = lowerBound(file.path());
+        if (row < m_rows.size() && m_rows.at(row).path() == file.path()) {
+            if (!sameStatus(m_rows.at(row), file)) {
+                m_rows[row] = file;
+                emit dataChanged(index(row), index(row));
+            }
+        } else {
+            inserts.append({ row, file });
+        }
+    }
+
+    if (inserts.isEmpty())
+        return;
+
+    // From the back, so the rows of the runs before stay valid; files going before the same row go in at once
+    for (qsizetype end = inserts.size(); end > 0;) {
+        const int row = inserts.at(end - 1).first;
+        qsizetype begin = end - 1;
+        while (begin > 0 && inserts.at(begin - 1).first == row)
+            --begin;
+
+        beginInsertRows(QModelIndex(), row, row + int(end - begin) - 1);
+        m_rows.insert(row, end - begin, GitFileStatus());
+        for (qsizetype i = begin; i < end; ++i)
+            m_rows[row + (i - begin)] = inserts.at(i).second;
+        endInsertRows();
+
+        end = begin;
+    }
+
+    emit countChanged();
+}
+
+void ChangesModel::removeStaleRows()
+{
+    const auto stale = [this](const GitFileStatus &file) {
+        const auto it = m_pending.constFind(file.path());
+        return it == m_pending.constEnd() || !accepts(it.value());
+    };
+
+    // From the back in runs of adjacent rows, one signal per run
+    bool removed = false;
+    for (int last = int(m_rows.size()) - 1; last >= 0;) {
+        if (!stale(m_rows.at(last))) {
+            --last;
+            continue;
+        }
+
+        int first = last;
+        while (first > 0 && stale(m_rows.at(first - 1)))
+            --first;
+
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rows.remove(first, last - first + 1);
+        endRemoveRows();
+
+        removed = true;
+        last = first - 1;
+    }
+
+    if (removed)
+        emit countChanged();
+}
+
+void ChangesModel::clear()
+{
+    m_pending.clear();
+    if (m_rows.isEmpty())
+        return;
+
+    beginResetModel();
+    m_rows.clear();
+    endResetModel();
+    emit countChanged();
+}
+
+bool ChangesModel::accepts(const GitFileStatus &file) const
+{
+    return m_section == Staged ? file.isStaged() : file.isUnstaged() || file.isUntracked();
+}
+
+int ChangesModel::lowerBound(const QString &path) const
+{
+    const auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), path,
+                                     [](const GitFileStatus &file, const QString &value) {
+                                         return file.path() < value;
+                                     });
+    return int(it - m_rows.cbegin());
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QStringList>
+#include <QVector>
+
+#include "GitFileStatus.h"
+#include "GitStatus.h"
+
+/**
+ * \brief List model over the staged or the unstaged files of GitStatus::loadStatus()
+ *
+ * The model keeps the status it shows and only announces what a new status
+ * changes: rows of new files are inserted (rowsInserted), rows whose status
+ * changed are updated in place (dataChanged) and rows of files no longer in
+ * the section are removed (rowsRemoved). Staging one file out of thousands
+ * moves one row from the unstaged to the staged model; the other rows and
+ * their delegates are left alone.
+ *
+ * Rows are sorted by path. New and changed files are applied as soon as
+ * their batch arrives, so the first files of a long scan show up early;
+ * rows not in the new status are removed when the scan finishes, and stay
+ * if it failed. Switching repositories clears the model.
+ *
+ * Staged files come first and are shown at once. The few that are also
+ * modified in the working tree come back with a later batch; their rows
+ * are updated a second time, with both changes.
+ */
+class ChangesModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(GitStatus* controller READ controller WRITE setController NOTIFY controllerChanged FINAL)
+    Q_PROPERTY(Section section READ section WRITE setSection NOTIFY sectionChanged FINAL)
+    Q_PROPERTY(int count READ count NOTIFY countChanged FINAL)
+
+public:
+    enum Section {
+        Staged,         ///< Files with changes in the index
+        Unstaged        ///< Modified, deleted and untracked files in the working tree
+    };
+    Q_ENUM(Section)
+
+    enum Roles {
+        FileRole = Qt::UserRole + 1,    ///< The GitFileStatus, exposed to delegates as modelData
+        PathRole,
+        StatusRole
+    };
+    Q_ENUM(Roles)
+
+    explicit ChangesModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    GitStatus *controller() const;
+    void setController(GitStatus *controller);
+
+    Section section() const;
+    void setSection(Section section);
+
+    int count() const;
+
+    /**
+     * \brief Paths of all rows, in row order
+     */
+    Q_INVOKABLE QStringList paths() const;
+
+signals:
+    void controllerChanged();
+    void sectionChanged();
+    void countChanged();
+
+private:
+    void statusStarted();
+    void statusBatchLoaded(const QList<GitFileStatus> &files);
+    void statusFinished(const QVariantMap &result);
+
+    /**
+     * \brief Insert new files and update changed ones; nothing is removed
+     * \param files Files of the section, sorted by path, each path once
+     */
+    void applyFiles(const QVector<GitFileStatus> &files);
+
+    /**
+     * \brief Remove the rows of files not in the section of m_pending
+     */
+    void removeStaleRows();
+
+    void clear();
+
+    bool accepts(const GitFileStatus &file) const;
+
+    /**
+     * \brief Row of a path, or the row it would be inserted at
+     */
+    int lowerBound(const QString &path) const;
+
+    QPointer<GitStatus> m_controller;
+    Section m_section = Unstaged;
+    QVector<GitFileStatus> m_rows;                  ///< Sorted by path
+    QHash<QString, GitFileStatus> m_pending;        ///< Files of the running status so far, all sections
+};
@@ -0,0 +1,120 @@
+#include "CommitCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+constexpr quint32 CacheMagic = 0x47454843; // "GEHC"
+constexpr quint32 CacheVersion = 3;
+}
+
+// Global so QList<RefTip> streaming finds them through argument-dependent lookup
+static QDataStream &operator<<(QDataStream &stream, const RefTip &tip)
+{
+    stream << tip.name;
+    stream.writeRawData(reinterpret_cast<const char *>(tip.oid.id), GIT_OID_SHA1_SIZE);
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, RefTip &tip)
+{
+    stream >> tip.name;
+    memset(&tip.oid, 0, sizeof(tip.oid));
+    if (stream.readRawData(reinterpret_cast<char *>(tip.oid.id), GIT_OID_SHA1_SIZE) != GIT_OID_SHA1_SIZE)
+        stream.setStatus(QDataStream::ReadPastEnd);
+    return stream;
+}
+
+CommitCache::~CommitCache()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+}
+
+QString CommitCache::pathFor(const QString &repoPath, const QString &kind)
+{
+    const QByteArray key = QCryptographicHash::hash(QDir::cleanPath(repoPath).toUtf8(),
+                                                    QCryptographicHash::Sha1).toHex();
+
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/" + kind + "/" + QString::fromLatin1(key) + ".bin";
+}
+
+bool CommitCache::write(const QString &path, const CommitCacheState &state, const QByteArray &table)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << CacheMagic << CacheVersion
+           << qint32(state.rowCount) << qint32(state.walkPosition) << state.exhausted
+           << state.refTips << state.walkTips
+           << quint64(table.size());
+    stream.writeRawData(table.constData(), table.size());
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool CommitCache::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data)
+        return false;
+
+    QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char *>(m_data), m_size);
+    QDataStream stream(raw);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 rowCount = 0;
+    qint32 walkPosition = 0;
+    quint64 tableSize = 0;
+    stream >> magic >> version;
+    if (magic != CacheMagic || version != CacheVersion)
+        return false;
+
+    stream >> rowCount >> walkPosition >> m_state.exhausted
+           >> m_state.refTips >> m_state.walkTips
+           >> tableSize;
+
+    m_tableOffset = stream.device()->pos();
+    if (stream.status() != QDataStream::Ok || quint64(m_size - m_tableOffset) != tableSize)
+        return false;
+
+    m_state.rowCount = rowCount;
+    m_state.walkPosition = walkPosition;
+    return true;
+}
+
+const CommitCacheState &CommitCache::state() const
+{
+    return m_state;
+}
+
+const char *CommitCache::tableData() const
+{
+    return reinterpret_cast<const char *>(m_data) + m_tableOffset;
+}
+
+qsizetype CommitCache::tableSize() const
+{
+    return m_size - m_tableOffset;
+}
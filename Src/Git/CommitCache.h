@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+#include "HistorySession.h"
+
+/**
+ * \brief Walk state a cached commit table belongs to
+ */
+struct CommitCacheState
+{
+    QList<RefTip> refTips;      ///< Refs the cached rows were loaded for
+    QList<RefTip> walkTips;     ///< Tips of the walk the rows continue
+    int walkPosition = 0;       ///< Commits of that walk already in the rows
+    bool exhausted = false;     ///< Whether the walk reached the root commits
+    int rowCount = 0;           ///< Rows of the cached table
+
+    bool isValid() const { return rowCount > 0; }
+};
+
+/**
+ * \brief Per-repository on-disk cache of loaded commit history
+ *
+ * The file holds the walk state followed by a CommitTable image (see
+ * CommitTable::serialize()). It is memory mapped when read, so validating
+ * the ref tips and loading the columns never touches the object database.
+ */
+class CommitCache
+{
+public:
+    CommitCache() = default;
+    ~CommitCache();
+
+    CommitCache(const CommitCache &) = delete;
+    CommitCache &operator=(const CommitCache &) = delete;
+
+    /**
+     * \brief Location of the cache file of a repository
+     * \param repoPath Path of the repository's .git directory
+     * \param kind Cache directory, for other per-repository caches kept alongside
+     */
+    static QString pathFor(const QString &repoPath, const QString &kind = QStringLiteral("history"));
+
+    /**
+     * \brief Atomically replace the cache file
+     * \param path Cache file path as returned by pathFor()
+     * \param state Walk state of the table
+     * \param table Image returned by CommitTable::serialize()
+     */
+    static bool write(const QString &path, const CommitCacheState &state, const QByteArray &table);
+
+    /**
+     * \brief Map a cache file and read its walk state
+     * \return false if the file is missing, from another version or malformed
+     */
+    bool open(const QString &path);
+
+    const CommitCacheState &state() const;
+
+    /**
+     * \brief Table image inside the mapped file
+     */
+    const char *tableData() const;
+    qsizetype tableSize() const;
+
+private:
+    QFile m_file;
+    uchar *m_data = nullptr;
+    qsizetype m_size = 0;
+    qsizetype m_tableOffset = 0;
+    CommitCacheState m_state;
+};
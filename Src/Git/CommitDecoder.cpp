@@ -0,0 +1,70 @@
+#include "CommitDecoder.h"
+
+#include <git2/repository.h>
+
+#include <QMutexLocker>
+#include <QThread>
+
+namespace {
+// Smaller chunks balance better, larger ones pay less scheduling overhead
+constexpr int MinChunkSize = 16;
+}
+
+CommitDecoder::CommitDecoder(const QString &repoPath, int threadCount)
+    : m_repoPath(repoPath)
+{
+    m_pool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+}
+
+CommitDecoder::~CommitDecoder()
+{
+    m_pool.waitForDone();
+
+    for (git_repository *repo : m_handles)
+        git_repository_free(repo);
+}
+
+QFuture<QVector<CommitRecord>> CommitDecoder::decodeAsync(const QVector<git_oid> &oids)
+{
+    return mapAsync<CommitRecord>(oids, [](const git_commit *commit) {
+        return CommitRecord::fromCommit(commit);
+    });
+}
+
+QVector<CommitRecord> CommitDecoder::decode(const QVector<git_oid> &oids)
+{
+    return take(decodeAsync(oids));
+}
+
+QVector<QVector<git_oid>> CommitDecoder::split(const QVector<git_oid> &oids) const
+{
+    // One chunk per thread at most, so every core gets a share of the block
+    const int threads = qMax(1, m_pool.maxThreadCount());
+    const int chunkSize = qMax(MinChunkSize, int((oids.size() + threads - 1) / threads));
+
+    QVector<QVector<git_oid>> chunks;
+    for (qsizetype first = 0; first < oids.size(); first += chunkSize)
+        chunks.append(oids.mid(first, chunkSize));
+
+    return chunks;
+}
+
+git_repository *CommitDecoder::acquire()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_idle.isEmpty())
+        return m_idle.takeLast();
+
+    git_repository *repo = nullptr;
+    if (git_repository_open(&repo, m_repoPath.toUtf8().constData()) != GIT_OK)
+        return nullptr;
+
+    m_handles.append(repo);
+    return repo;
+}
+
+void CommitDecoder::release(git_repository *repo)
+{
+    QMutexLocker locker(&m_mutex);
+    m_idle.append(repo);
+}
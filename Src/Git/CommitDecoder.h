@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QFuture>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <git2/commit.h>
+#include <git2/errors.h>
+#include <git2/oid.h>
+#include <git2/types.h>
+
+#include "CommitTable.h"
+
+/**
+ * \brief Decodes commit objects into CommitRecords on a pool of threads
+ *
+ * Reading a commit means inflating its object and parsing the header,
+ * which dominates a cold history load. The revision walk itself only
+ * produces ids (cheap with a commit-graph attached), so the walking thread
+ * hands blocks of ids to this decoder and keeps walking while they are
+ * decoded.
+ *
+ * libgit2 repository handles must not be used by two threads at once:
+ * every decoding task borrows a handle of its own from a small pool,
+ * opened on demand on the same repository path.
+ */
+class CommitDecoder
+{
+public:
+    /**
+     * \param repoPath Path of the repository
+     * \param threadCount Decoding threads, 0 for one per core
+     */
+    explicit CommitDecoder(const QString &repoPath, int threadCount = 0);
+    ~CommitDecoder();
+
+    CommitDecoder(const CommitDecoder &) = delete;
+    CommitDecoder &operator=(const CommitDecoder &) = delete;
+
+    /**
+     * \brief Start decoding commits in the background
+     *
+     * The future yields one result per chunk, in the order of oids; pass it
+     * to take() to get the records. Commits that cannot be read are
+     * skipped.
+     */
+    QFuture<QVector<CommitRecord>> decodeAsync(const QVector<git_oid> &oids);
+
+    /**
+     * \brief Decode commits and wait for the result, in the order of oids
+     */
+    QVector<CommitRecord> decode(const QVector<git_oid> &oids);
+
+    /**
+     * \brief Run convert on every commit in the background, like decodeAsync()
+     *
+     * For callers that need other data than a CommitRecord (e.g. the full
+     * message). convert(const git_commit *) is called on the pool threads.
+     */
+    template<class T, class Convert>
+    QFuture<QVector<T>> mapAsync(const QVector<git_oid> &oids, Convert convert);
+
+    /**
+     * \brief Wait for a decodeAsync() or mapAsync() future and concatenate its chunks
+     */
+    template<class T>
+    static QVector<T> take(const QFuture<QVector<T>> &future);
+
+private:
+    QVector<QVector<git_oid>> split(const QVector<git_oid> &oids) const;
+
+    git_repository *acquire();
+    void release(git_repository *repo);
+
+    QString m_repoPath;
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QVector<git_repository *> m_idle;       ///< Handles not used by a running task
+    QVector<git_repository *> m_handles;    ///< Every handle opened, freed on destruction
+};
+
+template<class T, class Convert>
+QFuture<QVector<T>> CommitDecoder::mapAsync(const QVector<git_oid> &oids, Convert convert)
+{
+    return QtConcurrent::mapped(&m_pool, split(oids), [this, convert](const QVector<git_oid> &chunk) {
+        QVector<T> results;
+
+        git_repository *repo = acquire();
+        if (!repo)
+            return results;
+
+        results.reserve(chunk.size());
+        for (const git_oid &oid : chunk) {
+            git_commit *gitCommit = nullptr;
+            if (git_commit_lookup(&gitCommit, repo, &oid) != GIT_OK)
+                continue;
+
+            results.append(convert(gitCommit));
+            git_commit_free(gitCommit);
+        }
+
+        release(repo);
+        return results;
+    });
+}
+
+template<class T>
+QVector<T> CommitDecoder::take(const QFuture<QVector<T>> &future)
+{
+    // mapped() keeps results in the order of the input chunks
+    QVector<T> results;
+    const QList<QVector<T>> chunks = future.results();
+    for (const QVector<T> &chunk : chunks)
+        results += chunk;
+
+    return results;
+}
@@ -0,0 +1,253 @@
+#include "CommitGraph.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <git2/errors.h>
+#include <git2/oid.h>
+#include <git2/odb.h>
+#include <git2/repository.h>
+#include <git2/revwalk.h>
+#include <git2/sys/commit_graph.h>
+
+#include <cstring>
+
+namespace {
+// Commit-graph file format (gitformat-commit-graph), all integers big-endian
+constexpr quint32 GraphSignature = 0x43475048;  // "CGPH"
+constexpr quint32 ChunkOidFanout = 0x4f494446;  // "OIDF"
+constexpr quint32 ChunkOidLookup = 0x4f49444c;  // "OIDL"
+constexpr quint32 ChunkCommitData = 0x43444154; // "CDAT"
+constexpr qint64 HeaderSize = 8;
+constexpr qint64 ChunkEntrySize = 12;
+constexpr qint64 FanoutSize = 256 * 4;
+constexpr qint64 OidSize = GIT_OID_SHA1_SIZE;
+constexpr qint64 CommitDataSize = OidSize + 16;  // Tree id, two parent positions, generation and date
+
+QDateTime newestModification(const QString &commonDir, const QString &objectsDir)
+{
+    QDateTime newest;
+    auto consider = [&newest](const QFileInfo &info) {
+        if (info.exists() && (!newest.isValid() || info.lastModified() > newest))
+            newest = info.lastModified();
+    };
+
+    consider(QFileInfo(commonDir + "packed-refs"));
+
+    QDirIterator refs(commonDir + "refs", QDir::Files, QDirIterator::Subdirectories);
+    while (refs.hasNext()) {
+        refs.next();
+        consider(refs.fileInfo());
+    }
+
+    QDirIterator packs(objectsDir + "/pack", { "*.pack" }, QDir::Files);
+    while (packs.hasNext()) {
+        packs.next();
+        consider(packs.fileInfo());
+    }
+
+    return newest;
+}
+}
+
+QString CommitGraph::objectsDir(git_repository *repo)
+{
+    if (!repo)
+        return QString();
+
+    return QString::fromUtf8(git_repository_commondir(repo)) + "objects";
+}
+
+bool CommitGraph::needsRefresh(const QString &objectsDir)
+{
+    QFileInfo graph(objectsDir + "/info/commit-graph");
+    if (!graph.exists())
+        return true;
+
+    QDir objects(objectsDir);
+    objects.cdUp();
+    const QString commonDir = objects.absolutePath() + "/";
+
+    const QDateTime newest = newestModification(commonDir, objectsDir);
+    return newest.isValid() && newest > graph.lastModified();
+}
+
+bool CommitGraph::write(const QString &repoPath)
+{
+    git_repository *repo = nullptr;
+    if (git_repository_open(&repo, repoPath.toUtf8().constData()) != GIT_OK)
+        return false;
+
+    const QByteArray infoDir = (objectsDir(repo) + "/info").toUtf8();
+    QDir().mkpath(QString::fromUtf8(infoDir));
+
+    bool written = false;
+    git_revwalk *walker = nullptr;
+    git_commit_graph_writer *writer = nullptr;
+    git_commit_graph_writer_options opts = GIT_COMMIT_GRAPH_WRITER_OPTIONS_INIT;
+
+    if (git_revwalk_new(&walker, repo) == GIT_OK &&
+        git_commit_graph_writer_new(&writer, infoDir.constData(), &opts) == GIT_OK) {
+        // Every ref plus HEAD, so detached checkouts are covered as well
+        git_revwalk_push_glob(walker, "refs/*");
+        git_revwalk_push_head(walker);
+
+        written = git_commit_graph_writer_add_revwalk(writer, walker) == GIT_OK &&
+                  git_commit_graph_writer_commit(writer) == GIT_OK;
+    }
+
+    if (!written) {
+        const git_error *err = git_error_last();
+        qWarning() << "CommitGraph: failed to write commit-graph:" << (err ? err->message : "unknown error");
+    }
+
+    git_commit_graph_writer_free(writer);
+    git_revwalk_free(walker);
+    git_repository_free(repo);
+
+    return written;
+}
+
+bool CommitGraph::attach(git_repository *repo)
+{
+    if (!repo)
+        return false;
+
+    const QString objects = objectsDir(repo);
+    if (!QFileInfo::exists(objects + "/info/commit-graph"))
+        return false;
+
+    git_odb *odb = nullptr;
+    if (git_repository_odb(&odb, repo) != GIT_OK)
+        return false;
+
+    git_commit_graph *graph = nullptr;
+    bool attached = false;
+    if (git_commit_graph_open(&graph, objects.toUtf8().constData()) == GIT_OK) {
+        // The odb takes ownership of the graph
+        attached = git_odb_set_commit_graph(odb, graph) == GIT_OK;
+        if (!attached)
+            git_commit_graph_free(graph);
+    }
+
+    git_odb_free(odb);
+    return attached;
+}
+
+CommitGraphReader::~CommitGraphReader()
+{
+    close();
+}
+
+bool CommitGraphReader::open(const QString &objectsDir)
+{
+    close();
+
+    m_file.setFileName(objectsDir + "/info/commit-graph");
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = m_file.size();
+    const uchar *data = size >= HeaderSize ? m_file.map(0, size) : nullptr;
+    if (!data) {
+        close();
+        return false;
+    }
+
+    // Version 1, SHA-1 ids, no base graphs: what git_commit_graph_writer produces
+    const quint8 chunkCount = data[6];
+    if (qFromBigEndian<quint32>(data) != GraphSignature || data[4] != 1 || data[5] != 1 || data[7] != 0
+        || size < HeaderSize + (chunkCount + 1) * ChunkEntrySize) {
+        close();
+        return false;
+    }
+
+    // Chunks are listed in file order; the size of one is the distance to the next
+    qint64 fanout = -1, oids = -1, oidsEnd = -1, commitData = -1, commitDataEnd = -1;
+    for (quint8 i = 0; i < chunkCount; ++i) {
+        const uchar *entry = data + HeaderSize + i * ChunkEntrySize;
+        const quint32 id = qFromBigEndian<quint32>(entry);
+        const qint64 offset = qint64(qFromBigEndian<quint64>(entry + 4));
+        const qint64 next = qint64(qFromBigEndian<quint64>(entry + ChunkEntrySize + 4));
+        if (offset < 0 || next < offset || next > size) {
+            close();
+            return false;
+        }
+
+        if (id == ChunkOidFanout && next - offset == FanoutSize) {
+            fanout = offset;
+        } else if (id == ChunkOidLookup) {
+            oids = offset;
+            oidsEnd = next;
+        } else if (id == ChunkCommitData) {
+            commitData = offset;
+            commitDataEnd = next;
+        }
+    }
+
+    if (fanout < 0 || oids < 0 || commitData < 0) {
+        close();
+        return false;
+    }
+
+    m_count = qFromBigEndian<quint32>(data + fanout + FanoutSize - 4);
+    if (oidsEnd - oids < m_count * OidSize || commitDataEnd - commitData < m_count * CommitDataSize) {
+        close();
+        return false;
+    }
+
+    m_fanout = data + fanout;
+    m_oids = data + oids;
+    m_commitData = data + commitData;
+    return true;
+}
+
+void CommitGraphReader::close()
+{
+    // Unmaps as well
+    m_file.close();
+    m_fanout = nullptr;
+    m_oids = nullptr;
+    m_commitData = nullptr;
+    m_count = 0;
+}
+
+bool CommitGraphReader::isOpen() const
+{
+    return m_fanout != nullptr;
+}
+
+bool CommitGraphReader::lookup(const git_oid &oid, qint64 &time, quint32 *generation) const
+{
+    if (!isOpen())
+        return false;
+
+    // The fanout narrows the search to the ids sharing the first byte
+    const quint8 first = oid.id[0];
+    quint32 low = first > 0 ? qFromBigEndian<quint32>(m_fanout + (first - 1) * 4) : 0;
+    quint32 high = qMin(qFromBigEndian<quint32>(m_fanout + first * 4), m_count);
+
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        const int order = memcmp(m_oids + middle * OidSize, oid.id, OidSize);
+        if (order < 0) {
+            low = middle + 1;
+        } else if (order > 0) {
+            high = middle;
+        } else {
+            // Generation in the top 30 bits, then a 34-bit commit time
+            const uchar *record = m_commitData + middle * CommitDataSize + OidSize + 8;
+            const quint32 upper = qFromBigEndian<quint32>(record);
+            time = qint64(quint64(upper & 0x3) << 32 | qFromBigEndian<quint32>(record + 4));
+            if (generation)
+                *generation = upper >> 2;
+            return true;
+        }
+    }
+
+    return false;
+}
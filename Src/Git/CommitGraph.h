@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <git2/types.h>
+
+/**
+ * \brief Maintains the commit-graph file of a repository
+ *
+ * The commit-graph (objects/info/commit-graph) stores parents, commit dates
+ * and generation numbers of every reachable commit in a compact, mmapped
+ * table. Once it is attached to a repository's object database, libgit2
+ * uses it for revision walks and merge-base computation instead of
+ * inflating each commit object.
+ */
+class CommitGraph
+{
+public:
+    /**
+     * \brief Path of the objects directory of a repository (common dir aware)
+     */
+    static QString objectsDir(git_repository *repo);
+
+    /**
+     * \brief Whether the commit-graph is missing or older than the refs/packs
+     * \param objectsDir Objects directory as returned by objectsDir()
+     *
+     * Cheap mtime heuristic: compares the graph file against pack files,
+     * packed-refs and loose refs. It may report a refresh when none is
+     * strictly needed, but never misses a moved branch.
+     */
+    static bool needsRefresh(const QString &objectsDir);
+
+    /**
+     * \brief Write the commit-graph for all refs and HEAD
+     * \param repoPath Path of the repository (opened on its own handle)
+     * \return true if the file was written
+     *
+     * Safe to call from a worker thread; it never touches a handle owned by
+     * the UI thread.
+     */
+    static bool write(const QString &repoPath);
+
+    /**
+     * \brief Attach an existing commit-graph to the repository's object database
+     * \return true if a graph was found and attached
+     */
+    static bool attach(git_repository *repo);
+};
+
+/**
+ * \brief Read-only view of the commit dates and generation numbers in a commit-graph file
+ *
+ * libgit2 keeps the graph it attaches to the object database private, and
+ * git_commit_lookup() still inflates the whole commit object. Walks that
+ * only need the date of a commit (e.g. to skip commits outside a time
+ * window) read it from the mmapped CDAT chunk instead: a fanout lookup and
+ * a binary search over the sorted ids, no object is touched.
+ *
+ * Only the single-file graph written by CommitGraph::write() is read;
+ * split graph chains and commits added after the graph was written are
+ * reported as not found, and callers fall back to the object database.
+ */
+class CommitGraphReader
+{
+public:
+    CommitGraphReader() = default;
+    ~CommitGraphReader();
+
+    CommitGraphReader(const CommitGraphReader &) = delete;
+    CommitGraphReader &operator=(const CommitGraphReader &) = delete;
+
+    /**
+     * \brief Map the commit-graph of an objects directory
+     * \param objectsDir Objects directory as returned by CommitGraph::objectsDir()
+     * \return false if there is no graph or it is malformed
+     */
+    bool open(const QString &objectsDir);
+
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * \brief Committer time and generation number of a commit
+     * \param time Receives the committer time in seconds since epoch
+     * \param generation Receives the topological level (1 for root commits), if not null
+     * \return false if the commit is not in the graph
+     */
+    bool lookup(const git_oid &oid, qint64 &time, quint32 *generation = nullptr) const;
+
+private:
+    QFile m_file;
+    const uchar *m_fanout = nullptr;        ///< 256 big-endian cumulative counts
+    const uchar *m_oids = nullptr;          ///< Sorted ids, m_count entries
+    const uchar *m_commitData = nullptr;    ///< CDAT records, m_count entries
+    quint32 m_count = 0;
+};
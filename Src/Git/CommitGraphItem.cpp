@@ -0,0 +1,619 @@
+#include "CommitGraphItem.h"
+
+#include <QImageReader>
+#include <QQmlFile>
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGTextureMaterial>
+#include <QSGVertexColorMaterial>
+#include <QVarLengthArray>
+#include <QtMath>
+
+#include <cstring>
+#include <memory>
+
+namespace {
+constexpr qreal EdgeWidth = 2.5;
+constexpr qreal NodeBorderWidth = 2.5;
+constexpr qreal SelectedBorderWidth = 4;
+constexpr qreal PlainNodeSize = 10;         // Node without avatar
+constexpr qreal AvatarIconSize = 14.5;
+constexpr qreal EdgeOpacity = 0.9;
+constexpr qreal CrossEdgeOpacity = 0.85;
+constexpr int CircleSegments = 24;
+constexpr int CurveSegments = 16;
+
+constexpr QRgb DefaultColor = 0xff808080;
+constexpr QRgb AvatarBackground = 0xffd9d9d9;
+
+QRgb lighten(QRgb color, qreal amount)
+{
+    auto channel = [amount](int value) { return qMin(255, int(value + (255 - value) * amount)); };
+    return qRgb(channel(qRed(color)), channel(qGreen(color)), channel(qBlue(color)));
+}
+
+QRgb darken(QRgb color, qreal amount)
+{
+    auto channel = [amount](int value) { return qMax(0, int(value * (1 - amount))); };
+    return qRgb(channel(qRed(color)), channel(qGreen(color)), channel(qBlue(color)));
+}
+
+QPointF cubic(const QPointF &p0, const QPointF &p1, const QPointF &p2, const QPointF &p3, qreal t)
+{
+    const qreal u = 1 - t;
+    return u * u * u * p0 + 3 * u * u * t * p1 + 3 * u * t * t * p2 + t * t * t * p3;
+}
+
+/**
+ * \brief Triangles with premultiplied vertex colors, for QSGVertexColorMaterial
+ */
+class Triangles
+{
+public:
+    void setColor(QRgb color, qreal opacity = 1)
+    {
+        const qreal alpha = qAlpha(color) / 255.0 * opacity;
+        m_r = uchar(qRound(qRed(color) * alpha));
+        m_g = uchar(qRound(qGreen(color) * alpha));
+        m_b = uchar(qRound(qBlue(color) * alpha));
+        m_a = uchar(qRound(255 * alpha));
+    }
+
+    void triangle(const QPointF &a, const QPointF &b, const QPointF &c)
+    {
+        vertex(a);
+        vertex(b);
+        vertex(c);
+    }
+
+    void quad(const QPointF &a, const QPointF &b, const QPointF &c, const QPointF &d)
+    {
+        triangle(a, b, c);
+        triangle(a, c, d);
+    }
+
+    void rect(const QRectF &rect)
+    {
+        quad(rect.topLeft(), rect.topRight(), rect.bottomRight(), rect.bottomLeft());
+    }
+
+    void line(const QPointF &from, const QPointF &to, qreal width)
+    {
+        const QPointF delta = to - from;
+        const qreal length = qSqrt(QPointF::dotProduct(delta, delta));
+        if (length <= 0)
+            return;
+
+        const QPointF normal(-delta.y() / length * width / 2, delta.x() / length * width / 2);
+        quad(from + normal, to + normal, to - normal, from - normal);
+    }
+
+    void polyline(const QPointF *points, int count, qreal width)
+    {
+        for (int i = 1; i < count; ++i)
+            line(points[i - 1], points[i], width);
+    }
+
+    void disc(const QPointF &center, qreal radius)
+    {
+        QPointF previous = center + QPointF(radius, 0);
+        for (int i = 1; i <= CircleSegments; ++i) {
+            const qreal angle = 2 * M_PI * i / CircleSegments;
+            const QPointF next = center + QPointF(radius * qCos(angle), radius * qSin(angle));
+            triangle(center, previous, next);
+            previous = next;
+        }
+    }
+
+    void ring(const QPointF &center, qreal radius, qreal width)
+    {
+        const qreal inner = qMax<qreal>(0, radius - width / 2);
+        const qreal outer = radius + width / 2;
+        for (int i = 0; i < CircleSegments; ++i) {
+            const qreal a0 = 2 * M_PI * i / CircleSegments;
+            const qreal a1 = 2 * M_PI * (i + 1) / CircleSegments;
+            const QPointF d0(qCos(a0), qSin(a0));
+            const QPointF d1(qCos(a1), qSin(a1));
+            quad(center + inner * d0, center + outer * d0, center + outer * d1, center + inner * d1);
+        }
+    }
+
+    void upload(QSGGeometryNode *node) const
+    {
+        QSGGeometry *geometry = node->geometry();
+        geometry->allocate(m_vertices.size());
+        if (!m_vertices.isEmpty()) {
+            memcpy(geometry->vertexDataAsColoredPoint2D(), m_vertices.constData(),
+                   m_vertices.size() * sizeof(QSGGeometry::ColoredPoint2D));
+        }
+        node->markDirty(QSGNode::DirtyGeometry);
+    }
+
+private:
+    void vertex(const QPointF &point)
+    {
+        QSGGeometry::ColoredPoint2D vertex;
+        vertex.set(float(point.x()), float(point.y()), m_r, m_g, m_b, m_a);
+        m_vertices.append(vertex);
+    }
+
+    QVector<QSGGeometry::ColoredPoint2D> m_vertices;
+    uchar m_r = 0;
+    uchar m_g = 0;
+    uchar m_b = 0;
+    uchar m_a = 0;
+};
+
+QSGGeometryNode *createColorNode()
+{
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+    geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+
+    auto *node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setMaterial(new QSGVertexColorMaterial);
+    node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    return node;
+}
+
+/**
+ * \brief Avatar icons of all nodes in the window: textured quads sharing one texture
+ */
+class AvatarNode : public QSGGeometryNode
+{
+public:
+    AvatarNode()
+        : m_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0)
+    {
+        m_geometry.setDrawingMode(QSGGeometry::DrawTriangles);
+        m_material.setFiltering(QSGTexture::Linear);
+        setGeometry(&m_geometry);
+        setMaterial(&m_material);
+    }
+
+    QSGTexture *texture() const
+    {
+        return m_texture.get();
+    }
+
+    void setTexture(QSGTexture *texture)
+    {
+        m_texture.reset(texture);
+        m_material.setTexture(texture);
+        markDirty(QSGNode::DirtyMaterial);
+    }
+
+private:
+    QSGGeometry m_geometry;
+    QSGTextureMaterial m_material;
+    std::unique_ptr<QSGTexture> m_texture;
+};
+
+/**
+ * \brief Root of the graph: the window of rows, translated to its first row
+ */
+class GraphNode : public QSGTransformNode
+{
+public:
+    GraphNode()
+    {
+        // Back to front
+        appendChildNode(edges = createColorNode());
+        appendChildNode(highlight = createColorNode());
+        appendChildNode(nodes = createColorNode());
+        appendChildNode(avatars = new AvatarNode);
+        appendChildNode(selectedNode = createColorNode());
+    }
+
+    QSGGeometryNode *edges = nullptr;
+    QSGGeometryNode *highlight = nullptr;
+    QSGGeometryNode *nodes = nullptr;
+    AvatarNode *avatars = nullptr;
+    QSGGeometryNode *selectedNode = nullptr;
+};
+}
+
+CommitGraphItem::CommitGraphItem(QQuickItem *parent)
+    : QQuickItem{parent},
+      m_selectionColor(QColor(0x88, 0xb2, 0xdf, 0x60))
+{
+    setFlag(ItemHasContents, true);
+}
+
+GraphLayoutEngine *CommitGraphItem::layoutEngine() const
+{
+    return m_layoutEngine;
+}
+
+void CommitGraphItem::setLayoutEngine(GraphLayoutEngine *layoutEngine)
+{
+    if (m_layoutEngine == layoutEngine)
+        return;
+
+    if (m_layoutEngine)
+        disconnect(m_layoutEngine, nullptr, this, nullptr);
+
+    m_layoutEngine = layoutEngine;
+    if (m_layoutEngine) {
+        connect(m_layoutEngine, &GraphLayoutEngine::layoutUpdated, this, [this]() {
+            invalidate(ContentDirty);
+        });
+    }
+
+    invalidate(ContentDirty);
+    emit layoutEngineChanged();
+}
+
+qreal CommitGraphItem::rowHeight() const
+{
+    return m_rowHeight;
+}
+
+void CommitGraphItem::setRowHeight(qreal rowHeight)
+{
+    if (qFuzzyCompare(m_rowHeight, rowHeight))
+        return;
+
+    m_rowHeight = rowHeight;
+    invalidate(ContentDirty);
+    emit rowHeightChanged();
+}
+
+qreal CommitGraphItem::columnSpacing() const
+{
+    return m_columnSpacing;
+}
+
+void CommitGraphItem::setColumnSpacing(qreal columnSpacing)
+{
+    if (qFuzzyCompare(m_columnSpacing, columnSpacing))
+        return;
+
+    m_columnSpacing = columnSpacing;
+    invalidate(ContentDirty);
+    emit columnSpacingChanged();
+}
+
+qreal CommitGraphItem::nodeSize() const
+{
+    return m_nodeSize;
+}
+
+void CommitGraphItem::setNodeSize(qreal nodeSize)
+{
+    if (qFuzzyCompare(m_nodeSize, nodeSize))
+        return;
+
+    m_nodeSize = nodeSize;
+    invalidate(ContentDirty);
+    emit nodeSizeChanged();
+}
+
+bool CommitGraphItem::showAvatar() const
+{
+    return m_showAvatar;
+}
+
+void CommitGraphItem::setShowAvatar(bool showAvatar)
+{
+    if (m_showAvatar == showAvatar)
+        return;
+
+    m_showAvatar = showAvatar;
+    invalidate(ContentDirty);
+    emit showAvatarChanged();
+}
+
+QUrl CommitGraphItem::avatarSource() const
+{
+    return m_avatarSource;
+}
+
+void CommitGraphItem::setAvatarSource(const QUrl &avatarSource)
+{
+    if (m_avatarSource == avatarSource)
+        return;
+
+    m_avatarSource = avatarSource;
+    invalidate(ContentDirty | AvatarDirty);
+    emit avatarSourceChanged();
+}
+
+int CommitGraphItem::selectedRow() const
+{
+    return m_selectedRow;
+}
+
+void CommitGraphItem::setSelectedRow(int selectedRow)
+{
+    if (m_selectedRow == selectedRow)
+        return;
+
+    m_selectedRow = selectedRow;
+    invalidate(SelectionDirty);
+    emit selectedRowChanged();
+}
+
+QColor CommitGraphItem::selectionColor() const
+{
+    return m_selectionColor;
+}
+
+void CommitGraphItem::setSelectionColor(const QColor &selectionColor)
+{
+    if (m_selectionColor == selectionColor)
+        return;
+
+    m_selectionColor = selectionColor;
+    invalidate(SelectionDirty);
+    emit selectionColorChanged();
+}
+
+qreal CommitGraphItem::viewportY() const
+{
+    return m_viewportY;
+}
+
+void CommitGraphItem::setViewportY(qreal viewportY)
+{
+    if (qFuzzyCompare(m_viewportY, viewportY))
+        return;
+
+    m_viewportY = viewportY;
+    if (outsideWindow())
+        update();
+    emit viewportYChanged();
+}
+
+qreal CommitGraphItem::viewportHeight() const
+{
+    return m_viewportHeight;
+}
+
+void CommitGraphItem::setViewportHeight(qreal viewportHeight)
+{
+    if (qFuzzyCompare(m_viewportHeight, viewportHeight))
+        return;
+
+    m_viewportHeight = viewportHeight;
+    if (outsideWindow())
+        update();
+    emit viewportHeightChanged();
+}
+
+void CommitGraphItem::setRowColors(int first, const QVariantList &colors)
+{
+    m_rowColors.resize(qMax(0, first), DefaultColor);
+    m_rowColors.reserve(m_rowColors.size() + colors.size());
+    for (const QVariant &color : colors) {
+        const QColor value(color.toString());
+        m_rowColors.append(value.isValid() ? value.rgba() : DefaultColor);
+    }
+
+    invalidate(ContentDirty);
+}
+
+QSGNode *CommitGraphItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    auto *root = static_cast<GraphNode *>(oldNode);
+
+    const GraphLayout *layout = m_layoutEngine ? &m_layoutEngine->result() : nullptr;
+    if (!layout || layout->lanes.isEmpty() || m_rowHeight <= 0) {
+        delete root;
+        m_windowFirst = 0;
+        m_windowLast = -1;
+        m_dirty |= ContentDirty | SelectionDirty | AvatarDirty;
+        return nullptr;
+    }
+
+    if (!root) {
+        root = new GraphNode;
+        m_dirty |= ContentDirty | SelectionDirty | AvatarDirty;
+    }
+
+    const int rowCount = layout->lanes.size();
+    const qreal radius = nodeRadius();
+
+    if ((m_dirty & AvatarDirty) && window()) {
+        QSGTexture *texture = nullptr;
+        if (!m_avatarSource.isEmpty()) {
+            // Rasterized at the size it is drawn at, for crisp icons on high-DPI screens
+            const int pixels = qCeil(AvatarIconSize * window()->effectiveDevicePixelRatio());
+            QImageReader reader(QQmlFile::urlToLocalFileOrQrc(m_avatarSource));
+            reader.setScaledSize(QSize(pixels, pixels));
+            const QImage image = reader.read();
+            if (!image.isNull())
+                texture = window()->createTextureFromImage(image);
+        }
+        root->avatars->setTexture(texture);
+    }
+
+    int first = 0;
+    int last = -1;
+    visibleRows(rowCount, &first, &last);
+
+    if ((m_dirty & ContentDirty) || first < m_windowFirst || last > m_windowLast) {
+        // One viewport of slack each way: scrolling that far reuses the geometry
+        const int margin = last - first + 1;
+        m_windowFirst = qMax(0, first - margin);
+        m_windowLast = qMin(rowCount - 1, last + margin);
+
+        QMatrix4x4 matrix;
+        matrix.translate(0, float(m_windowFirst * m_rowHeight));
+        root->setMatrix(matrix);
+
+        // Edges touching the window; long ones cross it without an end inside
+        Triangles edges;
+        const QVector<int> &edgeRows = layout->edges;
+        for (int i = 0; i + 2 < edgeRows.size(); i += 3) {
+            const int child = edgeRows.at(i);
+            const int parent = edgeRows.at(i + 1);
+            const int kind = edgeRows.at(i + 2);
+            if (qMax(child, parent) < m_windowFirst || qMin(child, parent) > m_windowLast)
+                continue;
+
+            const QPointF childPoint(laneX(layout->lanes.at(child)), rowY(child));
+            const QPointF parentPoint(laneX(layout->lanes.at(parent)), rowY(parent));
+
+            if (kind == GraphLayoutEngine::StraightEdge) {
+                edges.setColor(rowColor(child), EdgeOpacity);
+                edges.line(childPoint, parentPoint, EdgeWidth);
+                continue;
+            }
+
+            // Merges are drawn from the merged parent, forks from the child
+            const bool merge = kind == GraphLayoutEngine::MergeEdge;
+            const QPointF from = merge ? parentPoint : childPoint;
+            const QPointF to = merge ? childPoint : parentPoint;
+            edges.setColor(rowColor(merge ? parent : child), CrossEdgeOpacity);
+
+            // Run along the lane of from, then bend into the row of to
+            QVarLengthArray<QPointF, CurveSegments + 3> points;
+            QPointF start = from;
+            points.append(from);
+            if (to.y() >= from.y()) {
+                start = QPointF(from.x(), to.y() - 20);
+                points.append(start);
+            }
+            const QPointF control1 = to.y() < from.y() ? QPointF(from.x(), to.y() + 5) : start;
+            const QPointF control2(from.x() - 2, to.y());
+            const QPointF end(from.x() - 20, to.y());
+            for (int step = 1; step <= CurveSegments; ++step)
+                points.append(cubic(start, control1, control2, end, qreal(step) / CurveSegments));
+            points.append(to);
+
+            edges.polyline(points.constData(), points.size(), EdgeWidth);
+        }
+
+        // Lanes running on to parents that are not shown yet
+        for (int row : layout->openRows) {
+            if (row > m_windowLast)
+                continue;
+
+            const QPointF point(laneX(layout->lanes.at(row)), rowY(row));
+            edges.setColor(rowColor(row), EdgeOpacity);
+            edges.line(point, QPointF(point.x(), height() - m_windowFirst * m_rowHeight), EdgeWidth);
+        }
+        edges.upload(root->edges);
+
+        Triangles nodes;
+        QVector<QSGGeometry::TexturedPoint2D> icons;
+        for (int row = m_windowFirst; row <= m_windowLast; ++row) {
+            const QPointF center(laneX(layout->lanes.at(row)), rowY(row));
+            const QRgb color = rowColor(row);
+
+            nodes.setColor(m_showAvatar ? AvatarBackground : lighten(color, 0.3));
+            nodes.disc(center, radius);
+            nodes.setColor(lighten(color, 0.3));
+            nodes.ring(center, radius, NodeBorderWidth);
+
+            if (m_showAvatar) {
+                const QRectF icon(center.x() - AvatarIconSize / 2, center.y() - AvatarIconSize / 2,
+                                  AvatarIconSize, AvatarIconSize);
+                const QSGGeometry::TexturedPoint2D corners[4] = {
+                    { float(icon.left()), float(icon.top()), 0, 0 },
+                    { float(icon.right()), float(icon.top()), 1, 0 },
+                    { float(icon.right()), float(icon.bottom()), 1, 1 },
+                    { float(icon.left()), float(icon.bottom()), 0, 1 }
+                };
+                icons << corners[0] << corners[1] << corners[2]
+                      << corners[0] << corners[2] << corners[3];
+            }
+        }
+        nodes.upload(root->nodes);
+
+        // Without a texture the material has nothing to sample
+        QSGGeometry *iconGeometry = root->avatars->geometry();
+        iconGeometry->allocate(root->avatars->texture() ? icons.size() : 0);
+        if (iconGeometry->vertexCount() > 0) {
+            memcpy(iconGeometry->vertexDataAsTexturedPoint2D(), icons.constData(),
+                   icons.size() * sizeof(QSGGeometry::TexturedPoint2D));
+        }
+        root->avatars->markDirty(QSGNode::DirtyGeometry);
+
+        m_dirty |= SelectionDirty;
+    }
+
+    if (m_dirty & SelectionDirty) {
+        Triangles highlight;
+        Triangles selected;
+        if (m_selectedRow >= m_windowFirst && m_selectedRow <= m_windowLast) {
+            const qreal top = (m_selectedRow - m_windowFirst) * m_rowHeight;
+            highlight.setColor(m_selectionColor.rgba());
+            highlight.rect(QRectF(0, top, width(), m_rowHeight));
+
+            // Thicker, darker ring drawn over the node's own ring
+            const QPointF center(laneX(layout->lanes.at(m_selectedRow)), rowY(m_selectedRow));
+            selected.setColor(darken(rowColor(m_selectedRow), 0.2));
+            selected.ring(center, radius, SelectedBorderWidth);
+        }
+        highlight.upload(root->highlight);
+        selected.upload(root->selectedNode);
+    }
+
+    m_dirty = 0;
+    return root;
+}
+
+void CommitGraphItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+
+    // The highlight spans the width, open lanes run to the bottom
+    if (newGeometry.height() != oldGeometry.height())
+        invalidate(ContentDirty);
+    else if (newGeometry.width() != oldGeometry.width())
+        invalidate(SelectionDirty);
+}
+
+void CommitGraphItem::invalidate(int flags)
+{
+    m_dirty |= flags;
+    update();
+}
+
+void CommitGraphItem::visibleRows(int rowCount, int *first, int *last) const
+{
+    if (m_viewportHeight <= 0 || m_rowHeight <= 0) {
+        *first = 0;
+        *last = rowCount - 1;
+        return;
+    }
+
+    *first = qBound(0, int(m_viewportY / m_rowHeight), rowCount - 1);
+    *last = qBound(*first, int((m_viewportY + m_viewportHeight) / m_rowHeight), rowCount - 1);
+}
+
+bool CommitGraphItem::outsideWindow() const
+{
+    const int rowCount = m_layoutEngine ? int(m_layoutEngine->result().lanes.size()) : 0;
+    if (rowCount == 0)
+        return false;
+
+    int first = 0;
+    int last = -1;
+    visibleRows(rowCount, &first, &last);
+    return first < m_windowFirst || last > m_windowLast;
+}
+
+QRgb CommitGraphItem::rowColor(int row) const
+{
+    return row < m_rowColors.size() ? m_rowColors.at(row) : DefaultColor;
+}
+
+qreal CommitGraphItem::laneX(int lane) const
+{
+    // Half a column of padding before the first lane
+    return m_columnSpacing / 2 + lane * m_columnSpacing + m_columnSpacing / 2;
+}
+
+qreal CommitGraphItem::rowY(int row) const
+{
+    // Relative to the first row of the window, see GraphNode
+    return (row - m_windowFirst) * m_rowHeight + m_rowHeight / 2;
+}
+
+qreal CommitGraphItem::nodeRadius() const
+{
+    return (m_showAvatar ? m_nodeSize : PlainNodeSize) / 2;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <QColor>
+#include <QPointer>
+#include <QQuickItem>
+#include <QUrl>
+#include <QVariantList>
+#include <QVector>
+
+#include "GraphLayoutEngine.h"
+
+/**
+ * \brief Draws the commit graph laid out by a GraphLayoutEngine on the scene graph
+ *
+ * The item spans all rows (it sits in a Flickable) but only builds geometry
+ * for a window of rows around the viewport: the visible rows and one viewport
+ * worth above and below. Scrolling within the window only moves the
+ * Flickable's content and keeps the vertex buffers as they are; leaving it
+ * rebuilds the window around the new viewport. Edges, nodes and avatars are
+ * one batched node each.
+ *
+ * The selection (row highlight and the ring of the selected node) has its own
+ * small nodes, so selecting a commit leaves the rest of the graph untouched.
+ */
+class CommitGraphItem : public QQuickItem
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(GraphLayoutEngine* layoutEngine READ layoutEngine WRITE setLayoutEngine NOTIFY layoutEngineChanged FINAL)
+    Q_PROPERTY(qreal rowHeight READ rowHeight WRITE setRowHeight NOTIFY rowHeightChanged FINAL)
+    Q_PROPERTY(qreal columnSpacing READ columnSpacing WRITE setColumnSpacing NOTIFY columnSpacingChanged FINAL)
+    Q_PROPERTY(qreal nodeSize READ nodeSize WRITE setNodeSize NOTIFY nodeSizeChanged FINAL)
+    Q_PROPERTY(bool showAvatar READ showAvatar WRITE setShowAvatar NOTIFY showAvatarChanged FINAL)
+    Q_PROPERTY(QUrl avatarSource READ avatarSource WRITE setAvatarSource NOTIFY avatarSourceChanged FINAL)
+    Q_PROPERTY(int selectedRow READ selectedRow WRITE setSelectedRow NOTIFY selectedRowChanged FINAL)
+    Q_PROPERTY(QColor selectionColor READ selectionColor WRITE setSelectionColor NOTIFY selectionColorChanged FINAL)
+    Q_PROPERTY(qreal viewportY READ viewportY WRITE setViewportY NOTIFY viewportYChanged FINAL)
+    Q_PROPERTY(qreal viewportHeight READ viewportHeight WRITE setViewportHeight NOTIFY viewportHeightChanged FINAL)
+
+public:
+    explicit CommitGraphItem(QQuickItem *parent = nullptr);
+
+    GraphLayoutEngine *layoutEngine() const;
+    void setLayoutEngine(GraphLayoutEngine *layoutEngine);
+
+    qreal rowHeight() const;
+    void setRowHeight(qreal rowHeight);
+
+    qreal columnSpacing() const;
+    void setColumnSpacing(qreal columnSpacing);
+
+    /**
+     * \brief Diameter of a node showing an avatar; plain nodes are smaller
+     */
+    qreal nodeSize() const;
+    void setNodeSize(qreal nodeSize);
+
+    bool showAvatar() const;
+    void setShowAvatar(bool showAvatar);
+
+    QUrl avatarSource() const;
+    void setAvatarSource(const QUrl &avatarSource);
+
+    int selectedRow() const;
+    void setSelectedRow(int selectedRow);
+
+    QColor selectionColor() const;
+    void setSelectionColor(const QColor &selectionColor);
+
+    /**
+     * \brief Top of the visible part, in item coordinates (the Flickable's contentY)
+     */
+    qreal viewportY() const;
+    void setViewportY(qreal viewportY);
+
+    /**
+     * \brief Height of the visible part, 0 to draw all rows
+     */
+    qreal viewportHeight() const;
+    void setViewportHeight(qreal viewportHeight);
+
+    /**
+     * \brief Set the lane colors of rows first, first + 1, ...; rows after them are dropped
+     * \param colors Colors (or color names) per row
+     */
+    Q_INVOKABLE void setRowColors(int first, const QVariantList &colors);
+
+signals:
+    void layoutEngineChanged();
+    void rowHeightChanged();
+    void columnSpacingChanged();
+    void nodeSizeChanged();
+    void showAvatarChanged();
+    void avatarSourceChanged();
+    void selectedRowChanged();
+    void selectionColorChanged();
+    void viewportYChanged();
+    void viewportHeightChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    enum DirtyFlag {
+        ContentDirty = 1,       ///< Layout, colors or metrics changed: rebuild the window
+        SelectionDirty = 2,
+        AvatarDirty = 4
+    };
+
+    /**
+     * \brief Schedule a repaint of the given parts
+     */
+    void invalidate(int flags);
+
+    /**
+     * \brief Rows intersecting the viewport, clamped to the laid out rows
+     */
+    void visibleRows(int rowCount, int *first, int *last) const;
+
+    /**
+     * \brief Whether the viewport left the rows geometry was built for
+     */
+    bool outsideWindow() const;
+
+    QRgb rowColor(int row) const;
+    qreal laneX(int lane) const;
+    qreal rowY(int row) const;
+    qreal nodeRadius() const;
+
+    QPointer<GraphLayoutEngine> m_layoutEngine;
+    qreal m_rowHeight = 32;
+    qreal m_columnSpacing = 30;
+    qreal m_nodeSize = 24;
+    bool m_showAvatar = true;
+    QUrl m_avatarSource;
+    int m_selectedRow = -1;
+    QColor m_selectionColor;
+    qreal m_viewportY = 0;
+    qreal m_viewportHeight = 0;
+
+    QVector<QRgb> m_rowColors;
+
+    // Rows the current geometry covers, written while rendering is synchronized
+    int m_windowFirst = 0;
+    int m_windowLast = -1;
+    int m_dirty = ContentDirty | SelectionDirty | AvatarDirty;
+};
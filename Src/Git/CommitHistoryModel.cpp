@@ -0,0 +1,576 @@
+#include "CommitHistoryModel.h"
+
+#include <QDate>
+#include <QDateTime>
+
+#include <algorithm>
+
+namespace {
+bool parseDay(const QString &text, QDate &day)
+{
+    QString normalized = text.trimmed();
+    normalized.replace('/', '-');
+    day = QDate::fromString(normalized, "yyyy-M-d");
+    return day.isValid();
+}
+}
+
+CommitHistoryModel::CommitHistoryModel(QObject *parent)
+    : QAbstractListModel{parent}
+{}
+
+int CommitHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return m_rows.size();
+}
+
+QVariant CommitHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size() || !table())
+        return QVariant();
+
+    const int row = m_rows.at(index.row());
+    const CommitTable *commits = table();
+
+    switch (role) {
+    case HashRole:
+        return commits->hash(row);
+    case ShortHashRole:
+        return commits->shortHash(row);
+    case Qt::DisplayRole:
+    case SummaryRole:
+        return commits->summary(row);
+    case AuthorRole:
+        return commits->author(row);
+    case AuthorEmailRole:
+        return commits->authorEmail(row);
+    case AuthorDateRole:
+        return commits->authorDate(row);
+    case TimestampRole:
+        return commits->timestamp(row);
+    case ParentHashesRole:
+        return commits->parentHashes(row);
+    case TableRowRole:
+        return row;
+    case BranchesRole:
+        return m_windowed ? QStringList() : m_controller->refMembership()->refsContainingRow(row);
+    case BranchNamesRole: {
+        const RefDecoration *decoration = m_controller->refDecoration(commits->oid(row));
+        return decoration ? QStringList(decoration->branches + decoration->remotes) : QStringList();
+    }
+    case TagNamesRole: {
+        const RefDecoration *decoration = m_controller->refDecoration(commits->oid(row));
+        return decoration ? decoration->tags : QStringList();
+    }
+    case IsHeadRole: {
+        const RefDecoration *decoration = m_controller->refDecoration(commits->oid(row));
+        return decoration && decoration->head;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> CommitHistoryModel::roleNames() const
+{
+    return {
+        { HashRole, "hash" },
+        { ShortHashRole, "shortHash" },
+        { SummaryRole, "summary" },
+        { AuthorRole, "author" },
+        { AuthorEmailRole, "authorEmail" },
+        { AuthorDateRole, "authorDate" },
+        { TimestampRole, "timestamp" },
+        { ParentHashesRole, "parentHashes" },
+        { TableRowRole, "tableRow" },
+        { BranchesRole, "branches" },
+        { BranchNamesRole, "branchNames" },
+        { TagNamesRole, "tagNames" },
+        { IsHeadRole, "isHead" }
+    };
+}
+
+bool CommitHistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !table())
+        return false;
+
+    return m_scanned < table()->count() || (source().hasMore && !allMatchesLoaded());
+}
+
+void CommitHistoryModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+
+    m_wanted = qMax(m_wanted, int(m_rows.size()) + m_pageSize);
+    scan();
+}
+
+GitCommit *CommitHistoryModel::controller() const
+{
+    return m_controller;
+}
+
+void CommitHistoryModel::setController(GitCommit *controller)
+{
+    if (m_controller == controller)
+        return;
+
+    if (m_controller) {
+        disconnect(m_controller->history(), nullptr, this, nullptr);
+        disconnect(m_controller->queryHistory(), nullptr, this, nullptr);
+        disconnect(m_controller->searchIndex(), nullptr, this, nullptr);
+        disconnect(m_controller->refMembership(), nullptr, this, nullptr);
+        disconnect(m_controller, nullptr, this, nullptr);
+    }
+
+    m_controller = controller;
+    m_history = Source();
+    m_query = Source();
+
+    if (m_controller) {
+        // Row indices are only valid for the table contents they were taken from;
+        // each table only matters while the rows come from it
+        connect(m_controller->history(), &CommitTable::rowsReset, this, [this]() {
+            if (!m_windowed)
+                resetRows();
+        });
+        connect(m_controller->history(), &CommitTable::rowsPrepended, this, [this](int count) {
+            if (!m_windowed)
+                onRowsPrepended(count);
+        });
+        connect(m_controller->queryHistory(), &CommitTable::rowsReset, this, [this]() {
+            if (m_windowed)
+                resetRows();
+        });
+
+        connect(m_controller, &GitCommit::commitsBatchLoaded, this, [this]() {
+            if (!m_windowed)
+                onBatchLoaded();
+            emit loadedCountChanged();
+        });
+        connect(m_controller, &GitCommit::queryBatchLoaded, this, [this]() {
+            if (m_windowed)
+                onBatchLoaded();
+        });
+        connect(m_controller, &GitCommit::commitsLoadFinished, this, [this](const QVariantMap &result) {
+            onLoadFinished(m_history, !m_windowed, result);
+        });
+        connect(m_controller, &GitCommit::queryLoadFinished, this, [this](const QVariantMap &result) {
+            onLoadFinished(m_query, m_windowed, result);
+        });
+
+        connect(m_controller->searchIndex(), &CommitSearchIndex::indexChanged, this, &CommitHistoryModel::onIndexChanged);
+        connect(m_controller, &GitCommit::refDecorationsChanged, this, &CommitHistoryModel::onRefDecorationsChanged);
+        connect(m_controller->refMembership(), &RefMembershipIndex::membershipChanged, this, [this]() {
+            if (!m_windowed && !m_rows.isEmpty())
+                emit dataChanged(index(0), index(m_rows.size() - 1), { BranchesRole });
+        });
+        connect(m_controller->refMembership(), &RefMembershipIndex::rowsMembershipChanged, this,
+                [this](int firstRow, int lastRow) {
+            if (m_windowed)
+                return;
+
+            // Shown rows are ascending table rows
+            const int first = int(std::lower_bound(m_rows.cbegin(), m_rows.cend(), firstRow) - m_rows.cbegin());
+            const int end = int(std::upper_bound(m_rows.cbegin(), m_rows.cend(), lastRow) - m_rows.cbegin());
+            if (first < end)
+                emit dataChanged(index(first), index(end - 1), { BranchesRole });
+        });
+    }
+
+    resetRows();
+    emit controllerChanged();
+}
+
+int CommitHistoryModel::pageSize() const
+{
+    return m_pageSize;
+}
+
+void CommitHistoryModel::setPageSize(int pageSize)
+{
+    if (m_pageSize == pageSize || pageSize <= 0)
+        return;
+
+    m_pageSize = pageSize;
+    emit pageSizeChanged();
+}
+
+bool CommitHistoryModel::isLoading() const
+{
+    return source().loading;
+}
+
+int CommitHistoryModel::loadedCount() const
+{
+    return m_controller ? m_controller->history()->count() : 0;
+}
+
+int CommitHistoryModel::matchCount() const
+{
+    return m_filter.indexed ? int(m_filter.matches.size()) : -1;
+}
+
+void CommitHistoryModel::reload()
+{
+    if (!m_controller)
+        return;
+
+    source() = Source();
+    resetRows();
+
+    // Clears the table; rows come back through onBatchLoaded
+    const bool started = request(QString());
+    source().hasMore = started;
+    setLoading(started);
+    emit loadedCountChanged();
+}
+
+void CommitHistoryModel::refresh()
+{
+    if (!m_controller)
+        return;
+
+    if (m_windowed) {
+        // Keep the unfiltered history current for when the window is cleared
+        if (!m_history.loading && m_controller->refreshHistory().success())
+            m_history.loading = true;
+        else
+            m_history.stale = true;
+
+        reload();
+        return;
+    }
+
+    if (source().loading || !m_controller->refreshHistory().success()) {
+        reload();
+        return;
+    }
+
+    setLoading(true);
+}
+
+void CommitHistoryModel::loadMore()
+{
+    if (canFetchMore(QModelIndex()))
+        fetchMore(QModelIndex());
+}
+
+void CommitHistoryModel::setFilter(const QString &text, const QStringList &modes,
+                                   const QString &startDate, const QString &endDate)
+{
+    Filter filter;
+    filter.text = text.trimmed();
+    filter.modes = modes.isEmpty() ? QStringList { "Messages" } : modes;
+    filter.startDate = startDate;
+    filter.endDate = endDate;
+
+    QDate day;
+    if (parseDay(startDate, day)) {
+        filter.start = day.startOfDay().toSecsSinceEpoch();
+        filter.hasStart = true;
+    }
+    if (parseDay(endDate, day)) {
+        // Inclusive: up to the last second of that day
+        filter.end = day.addDays(1).startOfDay().toSecsSinceEpoch() - 1;
+        filter.hasEnd = true;
+    }
+
+    CommitSearchIndex *index = m_controller ? m_controller->searchIndex() : nullptr;
+    if (!filter.text.isEmpty() && index) {
+        index->build();
+        if (index->canSearch(filter.text, filter.modes)) {
+            const QVector<git_oid> found = index->search(filter.text, filter.modes);
+            filter.matches = QSet<git_oid>(found.cbegin(), found.cend());
+            filter.indexed = true;
+        }
+    }
+
+    const bool countChanged = filter.indexed || m_filter.indexed;
+    const bool windowed = filter.hasStart || filter.hasEnd;
+    const bool windowChanged = windowed != m_windowed
+                               || filter.hasStart != m_filter.hasStart || filter.start != m_filter.start
+                               || filter.hasEnd != m_filter.hasEnd || filter.end != m_filter.end;
+    const bool wasLoading = isLoading();
+
+    m_filter = filter;
+    m_windowed = windowed;
+    resetRows();
+
+    if (windowed && windowChanged) {
+        // Starts a walk seeking to the new window; rows come back through onBatchLoaded
+        m_query = Source();
+        m_query.hasMore = request(QString());
+        m_query.loading = m_query.hasMore;
+    } else if (!windowed && m_history.stale) {
+        reload();
+    }
+
+    if (isLoading() != wasLoading)
+        emit loadingChanged();
+    if (countChanged)
+        emit matchCountChanged();
+    scan();
+}
+
+QVariantMap CommitHistoryModel::get(int row) const
+{
+    QVariantMap map;
+    if (row < 0 || row >= m_rows.size())
+        return map;
+
+    const QHash<int, QByteArray> roles = roleNames();
+    for (auto it = roles.cbegin(); it != roles.cend(); ++it)
+        map.insert(QString::fromUtf8(it.value()), data(index(row), it.key()));
+
+    return map;
+}
+
+bool CommitHistoryModel::isLoaded(const QString &hash) const
+{
+    return table() && table()->indexOf(hash) >= 0;
+}
+
+CommitTable *CommitHistoryModel::table() const
+{
+    if (!m_controller)
+        return nullptr;
+
+    return m_windowed ? m_controller->queryHistory() : m_controller->history();
+}
+
+const QVector<int> &CommitHistoryModel::tableRows() const
+{
+    return m_rows;
+}
+
+CommitHistoryModel::Source &CommitHistoryModel::source()
+{
+    return m_windowed ? m_query : m_history;
+}
+
+const CommitHistoryModel::Source &CommitHistoryModel::source() const
+{
+    return m_windowed ? m_query : m_history;
+}
+
+bool CommitHistoryModel::request(const QString &cursor)
+{
+    if (!m_controller)
+        return false;
+
+    if (m_windowed)
+        return m_controller->queryHistoryAsync(windowQuery(), cursor, m_pageSize).success();
+
+    return m_controller->loadCommitsAsync(cursor, m_pageSize).success();
+}
+
+QVariantMap CommitHistoryModel::windowQuery() const
+{
+    QVariantMap query;
+    if (m_filter.hasStart)
+        query["since"] = m_filter.start;
+    if (m_filter.hasEnd)
+        query["until"] = m_filter.end;
+
+    return query;
+}
+
+void CommitHistoryModel::resetRows()
+{
+    if (m_rows.isEmpty() && m_scanned == 0) {
+        m_wanted = m_pageSize;
+        return;
+    }
+
+    beginResetModel();
+    m_rows.clear();
+    m_scanned = 0;
+    m_indexHits = 0;
+    m_wanted = m_pageSize;
+    endResetModel();
+}
+
+void CommitHistoryModel::onRowsPrepended(int count)
+{
+    // Rows below the new ones shift down
+    for (int &row : m_rows)
+        row += count;
+    m_scanned += count;
+
+    QVector<int> matched;
+    for (int row = 0; row < count; ++row) {
+        if (matches(row))
+            matched.append(row);
+    }
+
+    if (!matched.isEmpty()) {
+        beginInsertRows(QModelIndex(), 0, matched.size() - 1);
+        m_rows = matched + m_rows;
+        m_wanted += matched.size();
+        endInsertRows();
+    }
+
+    emit loadedCountChanged();
+}
+
+void CommitHistoryModel::setLoading(bool loading)
+{
+    if (source().loading == loading)
+        return;
+
+    source().loading = loading;
+    emit loadingChanged();
+}
+
+void CommitHistoryModel::scan()
+{
+    CommitTable *commits = table();
+    if (!commits)
+        return;
+
+    // Test only rows that were not looked at yet: O(page), not O(history)
+    QVector<int> matched;
+    while (m_rows.size() + matched.size() < m_wanted && m_scanned < commits->count()) {
+        if (m_filter.indexed && m_filter.matches.contains(commits->oid(m_scanned)))
+            m_indexHits++;
+        if (matches(m_scanned))
+            matched.append(m_scanned);
+        m_scanned++;
+    }
+
+    if (!matched.isEmpty()) {
+        const int first = m_rows.size();
+        beginInsertRows(QModelIndex(), first, first + matched.size() - 1);
+        m_rows += matched;
+        endInsertRows();
+    }
+
+    // Everything loaded is shown but the views want more
+    if (m_rows.size() < m_wanted && m_scanned >= commits->count()
+        && source().hasMore && !source().loading && !allMatchesLoaded()) {
+        setLoading(request(source().cursor));
+    }
+}
+
+bool CommitHistoryModel::matches(int tableRow) const
+{
+    if (!m_filter.isActive())
+        return true;
+
+    const CommitTable *commits = table();
+
+    // Committer time, like the windowed walk and git log --since/--until; rows show the author date
+    const qint64 time = commits->commitTime(tableRow);
+    if (m_filter.hasStart && time < m_filter.start)
+        return false;
+    if (m_filter.hasEnd && time > m_filter.end)
+        return false;
+
+    if (m_filter.text.isEmpty())
+        return true;
+
+    if (m_filter.indexed)
+        return m_filter.matches.contains(commits->oid(tableRow));
+
+    // Bodies are not loaded: reading them here would decompress history on the GUI thread
+    for (const QString &mode : m_filter.modes) {
+        QString haystack;
+        if (mode == "Messages" || mode == "Subjects")
+            haystack = commits->summary(tableRow);
+        else if (mode == "Authors")
+            haystack = commits->author(tableRow);
+        else if (mode == "Emails")
+            haystack = commits->authorEmail(tableRow);
+        else if (mode == "SHA-1")
+            haystack = commits->hash(tableRow);
+        else
+            continue;
+
+        if (haystack.contains(m_filter.text, Qt::CaseInsensitive))
+            return true;
+    }
+
+    return false;
+}
+
+bool CommitHistoryModel::allMatchesLoaded() const
+{
+    return m_filter.indexed && m_indexHits >= m_filter.matches.size();
+}
+
+void CommitHistoryModel::onIndexChanged()
+{
+    CommitSearchIndex *index = m_controller ? m_controller->searchIndex() : nullptr;
+    if (!index || m_filter.text.isEmpty())
+        return;
+
+    // Switch to (or refresh) indexed matches once the whole repository is covered
+    if (index->isReady() || m_filter.indexed)
+        setFilter(m_filter.text, m_filter.modes, m_filter.startDate, m_filter.endDate);
+}
+
+void CommitHistoryModel::onRefDecorationsChanged()
+{
+    const CommitTable *commits = table();
+    if (!commits || m_rows.isEmpty())
+        return;
+
+    QVector<int> changed;
+    for (const git_oid &oid : m_controller->changedRefDecorations()) {
+        const int tableRow = commits->rowOf(oid);
+        const auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), tableRow);
+        if (tableRow >= 0 && it != m_rows.cend() && *it == tableRow)
+            changed.append(int(it - m_rows.cbegin()));
+    }
+    std::sort(changed.begin(), changed.end());
+
+    // One signal per run of adjacent rows
+    for (qsizetype begin = 0; begin < changed.size();) {
+        qsizetype end = begin + 1;
+        while (end < changed.size() && changed.at(end) == changed.at(end - 1) + 1)
+            ++end;
+
+        emit dataChanged(index(changed.at(begin)), index(changed.at(end - 1)),
+                         { BranchNamesRole, TagNamesRole, IsHeadRole });
+        begin = end;
+    }
+}
+
+void CommitHistoryModel::onBatchLoaded()
+{
+    scan();
+}
+
+void CommitHistoryModel::onLoadFinished(Source &loader, bool shown, const QVariantMap &result)
+{
+    if (shown)
+        setLoading(false);
+    else
+        loader.loading = false;
+
+    if (!result.value("success").toBool()) {
+        // Refs moved since the walk started: the cursor is stale, start over
+        if (result.value("expired").toBool()) {
+            if (shown)
+                reload();
+            else
+                loader.stale = true;
+        } else {
+            loader.hasMore = false;
+        }
+        return;
+    }
+
+    loader.cursor = result.value("cursor").toString();
+    loader.hasMore = result.value("hasMore").toBool();
+
+    // A filter may still need more rows to fill the page
+    if (shown)
+        scan();
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+#include "GitCommit.h"
+#include "OidHash.h"
+
+/**
+ * \brief List model over the commit history loaded by GitCommit
+ *
+ * Rows map to rows of GitCommit::history(). The model grows through
+ * canFetchMore()/fetchMore(): rows already in the table are exposed right
+ * away, missing ones are requested with GitCommit::loadCommitsAsync() and
+ * inserted as their batches arrive. Only the new rows are announced
+ * (rowsInserted), so views append in O(page) instead of O(history).
+ *
+ * An optional filter restricts the rows to matching commits. It is applied
+ * to each new page only; the model keeps fetching until a page worth of
+ * matches is shown or history is exhausted.
+ *
+ * A date window switches the rows to GitCommit::queryHistory(), loaded by
+ * GitCommit::queryHistoryAsync(): the walk skips the newer commits and
+ * stops behind the window instead of paging through all later history.
+ *
+ * Text filters are answered by the controller's CommitSearchIndex once it
+ * is ready: the matching commits of the whole repository are known up
+ * front (matchCount), rows are tested by a hash lookup and fetching stops
+ * as soon as the last match is loaded. Until then rows are tested one by
+ * one against the loaded commits.
+ */
+class CommitHistoryModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(GitCommit* controller READ controller WRITE setController NOTIFY controllerChanged FINAL)
+    Q_PROPERTY(int pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged FINAL)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged FINAL)
+    Q_PROPERTY(int loadedCount READ loadedCount NOTIFY loadedCountChanged FINAL)
+    Q_PROPERTY(int matchCount READ matchCount NOTIFY matchCountChanged FINAL)
+
+public:
+    enum Roles {
+        HashRole = Qt::UserRole + 1,
+        ShortHashRole,
+        SummaryRole,
+        AuthorRole,
+        AuthorEmailRole,
+        AuthorDateRole,
+        TimestampRole,
+        ParentHashesRole,
+        TableRowRole,
+        BranchesRole,           ///< Branches containing the commit (main history only)
+        BranchNamesRole,        ///< Local and remote branches pointing at the commit
+        TagNamesRole,
+        IsHeadRole
+    };
+    Q_ENUM(Roles)
+
+    explicit CommitHistoryModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    GitCommit *controller() const;
+    void setController(GitCommit *controller);
+
+    int pageSize() const;
+    void setPageSize(int pageSize);
+
+    bool isLoading() const;
+
+    /**
+     * \brief Number of commits loaded from (unfiltered) history
+     */
+    int loadedCount() const;
+
+    /**
+     * \brief Commits in the whole repository matching the text filter, -1 if not known (yet)
+     */
+    int matchCount() const;
+
+    /**
+     * \brief Restart history from the current ref tips (or the history cache)
+     */
+    Q_INVOKABLE void reload();
+
+    /**
+     * \brief Insert commits added since the last load at the top, reload if that is not possible
+     */
+    Q_INVOKABLE void refresh();
+
+    /**
+     * \brief Ask for another page of rows (same as fetchMore() on the root index)
+     */
+    Q_INVOKABLE void loadMore();
+
+    /**
+     * \brief Show only matching commits
+     * \param text Case-insensitive text to look for, empty for no text filter
+     * \param modes Fields to search: "Messages", "Subjects", "Authors", "Emails", "SHA-1" (default "Messages")
+     * \param startDate First day to include (YYYY-MM-DD or YYYY/MM/DD), empty for no bound
+     * \param endDate Last day to include, empty for no bound
+     *
+     * Dates are compared with the committer date, as git log --since/--until
+     * do, which can differ from the author date shown in the rows (rebased or
+     * cherry-picked commits).
+     *
+     * "Messages" searches whole messages through the search index. Until the
+     * index is ready, and for text shorter than three characters, only the
+     * subjects of the loaded rows are searched.
+     */
+    Q_INVOKABLE void setFilter(const QString &text, const QStringList &modes,
+                               const QString &startDate, const QString &endDate);
+
+    /**
+     * \brief All roles of a row as a map
+     */
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+    /**
+     * \brief Whether a commit is loaded in the table the rows come from (shown or not)
+     */
+    Q_INVOKABLE bool isLoaded(const QString &hash) const;
+
+    /**
+     * \brief Table the rows currently come from
+     */
+    CommitTable *table() const;
+
+    /**
+     * \brief Table row of every model row
+     */
+    const QVector<int> &tableRows() const;
+
+signals:
+    void controllerChanged();
+    void pageSizeChanged();
+    void loadingChanged();
+    void loadedCountChanged();
+    void matchCountChanged();
+
+private:
+    struct Filter
+    {
+        QString text;
+        QStringList modes;
+        QString startDate;
+        QString endDate;
+        qint64 start = 0;
+        qint64 end = 0;
+        bool hasStart = false;
+        bool hasEnd = false;
+        bool indexed = false;           ///< Text matches come from the search index
+        QSet<git_oid> matches;          ///< Text matches when indexed
+
+        bool isActive() const { return !text.isEmpty() || hasStart || hasEnd; }
+    };
+
+    /**
+     * \brief Paging state of one of the controller's loaders
+     */
+    struct Source
+    {
+        QString cursor;
+        bool hasMore = false;
+        bool loading = false;
+        bool stale = false;         ///< Its cursor expired while the other source was shown
+    };
+
+    Source &source();
+    const Source &source() const;
+
+    /**
+     * \brief Ask the current source for the page after cursor (empty: start over)
+     */
+    bool request(const QString &cursor);
+    QVariantMap windowQuery() const;
+
+    void resetRows();
+    void onRowsPrepended(int count);
+    void setLoading(bool loading);
+
+    /**
+     * \brief Expose loaded table rows until m_wanted rows are shown, fetch more if needed
+     */
+    void scan();
+    bool matches(int tableRow) const;
+
+    /**
+     * \brief Whether every indexed text match is already loaded, so no page can add rows
+     */
+    bool allMatchesLoaded() const;
+
+    void onIndexChanged();
+
+    /**
+     * \brief Update the labels of the shown rows whose refs changed
+     */
+    void onRefDecorationsChanged();
+
+    void onBatchLoaded();
+    void onLoadFinished(Source &loader, bool shown, const QVariantMap &result);
+
+    QPointer<GitCommit> m_controller;
+    QVector<int> m_rows;            ///< Table rows shown by the model
+    int m_scanned = 0;              ///< Table rows already tested against the filter
+    int m_indexHits = 0;            ///< Scanned rows found in Filter::matches
+    int m_wanted = 0;               ///< Rows the views asked for
+    int m_pageSize = 200;
+    Source m_history;               ///< GitCommit::history(), all commits
+    Source m_query;                 ///< GitCommit::queryHistory(), commits in the date window
+    bool m_windowed = false;        ///< Rows come from the query source
+    Filter m_filter;
+};
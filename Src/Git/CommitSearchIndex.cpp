@@ -0,0 +1,531 @@
+#include "CommitSearchIndex.h"
+#include "CommitDecoder.h"
+#include "CommitGraph.h"
+
+#include <git2/commit.h>
+#include <git2/errors.h>
+#include <git2/repository.h>
+#include <git2/revwalk.h>
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// Commits per published segment
+constexpr int SegmentSize = 16384;
+
+/**
+ * \brief Searchable fields of one commit, extracted on the decoder threads
+ */
+struct IndexedCommit
+{
+    git_oid oid;
+    QByteArray author;
+    QByteArray email;
+    QVector<quint32> trigrams;
+};
+
+/**
+ * \brief Outcome of checking a candidate against its message
+ */
+struct VerifiedCommit
+{
+    git_oid oid;
+    bool matches = false;
+};
+
+void appendVarint(QByteArray &out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+QByteArray lowerMessage(const git_commit *commit)
+{
+    return QString::fromUtf8(git_commit_message(commit)).toLower().toUtf8();
+}
+}
+
+/**
+ * \brief Worker side of a build: only touched from the running task
+ */
+struct CommitSearchIndex::BuildState
+{
+    QString repoPath;
+    std::atomic<bool> cancelled { false };
+};
+
+bool CommitSearchIndex::Segment::posting(quint32 trigram, QVector<qint32> &indices) const
+{
+    indices.clear();
+
+    const auto it = std::lower_bound(trigrams.cbegin(), trigrams.cend(), trigram);
+    if (it == trigrams.cend() || *it != trigram)
+        return false;
+
+    const qsizetype slot = it - trigrams.cbegin();
+    const uchar *bytes = reinterpret_cast<const uchar *>(postings.constData());
+    qint32 index = -1;
+    for (qint32 i = postingOffsets.at(slot); i < postingOffsets.at(slot + 1);) {
+        quint32 delta = 0;
+        for (int shift = 0; ; shift += 7) {
+            const uchar byte = bytes[i++];
+            delta |= quint32(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        index += qint32(delta);
+        indices.append(index);
+    }
+
+    return true;
+}
+
+CommitSearchIndex::CommitSearchIndex(QObject *parent)
+    : QObject{parent}
+{}
+
+CommitSearchIndex::~CommitSearchIndex()
+{
+    m_generation++;
+    if (m_build)
+        m_build->cancelled = true;
+
+    m_future.waitForFinished();
+}
+
+void CommitSearchIndex::setRepositoryPath(const QString &repoPath)
+{
+    if (repoPath == m_repoPath)
+        return;
+
+    // Drop results still queued for the GUI thread
+    m_generation++;
+    if (m_build)
+        m_build->cancelled = true;
+    m_future.waitForFinished();
+
+    m_build.reset();
+    m_repoPath = repoPath;
+    m_verifier = repoPath.isEmpty() ? nullptr : std::make_unique<CommitDecoder>(repoPath);
+    m_segments.clear();
+    m_tips.clear();
+    m_indexedCount = 0;
+    m_started = false;
+    m_ready = false;
+    m_building = false;
+    m_updatePending = false;
+
+    emit indexChanged();
+}
+
+void CommitSearchIndex::build()
+{
+    if (m_started || m_repoPath.isEmpty())
+        return;
+
+    m_started = true;
+    startBuild(QList<RefTip>());
+}
+
+void CommitSearchIndex::update()
+{
+    if (!m_started)
+        return;
+
+    if (m_building) {
+        m_updatePending = true;
+        return;
+    }
+
+    startBuild(m_tips);
+}
+
+bool CommitSearchIndex::isReady() const
+{
+    return m_ready;
+}
+
+int CommitSearchIndex::indexedCount() const
+{
+    return m_indexedCount;
+}
+
+void CommitSearchIndex::startBuild(const QList<RefTip> &previousTips)
+{
+    m_building = true;
+    m_updatePending = false;
+
+    const quint64 generation = m_generation;
+    m_build = std::make_shared<BuildState>();
+    m_build->repoPath = m_repoPath;
+    std::shared_ptr<BuildState> state = m_build;
+
+    m_future = QtConcurrent::run([this, state, generation, previousTips]() {
+        git_repository *repo = nullptr;
+        if (git_repository_open(&repo, state->repoPath.toUtf8().constData()) != GIT_OK) {
+            failBuild(generation);
+            return;
+        }
+        CommitGraph::attach(repo);
+
+        const QList<RefTip> tips = HistorySession::readRefTips(repo);
+        if (tips == previousTips) {
+            git_repository_free(repo);
+            finishBuild(generation, tips, false);
+            return;
+        }
+
+        // Only index what is new, unless indexed commits were rewritten away
+        const bool incremental = !previousTips.isEmpty()
+                                 && HistorySession::containsHistory(repo, tips, previousTips);
+
+        git_revwalk *walker = nullptr;
+        if (git_revwalk_new(&walker, repo) != GIT_OK) {
+            git_repository_free(repo);
+            failBuild(generation);
+            return;
+        }
+
+        // Order does not matter for the index, skip sorting
+        git_revwalk_sorting(walker, GIT_SORT_NONE);
+        for (const RefTip &tip : tips)
+            git_revwalk_push(walker, &tip.oid);
+        if (incremental) {
+            for (const RefTip &tip : previousTips)
+                git_revwalk_hide(walker, &tip.oid);
+        }
+
+        if (!incremental && !previousTips.isEmpty()) {
+            QMetaObject::invokeMethod(this, [this, generation]() {
+                if (generation != m_generation)
+                    return;
+
+                m_segments.clear();
+                m_indexedCount = 0;
+                m_ready = false;
+                emit indexChanged();
+            }, Qt::QueuedConnection);
+        }
+
+        auto convert = [](const git_commit *commit) {
+            IndexedCommit indexed;
+            git_oid_cpy(&indexed.oid, git_commit_id(commit));
+
+            const git_signature *author = git_commit_author(commit);
+            indexed.author = QString::fromUtf8(author->name).toLower().toUtf8();
+            indexed.email = QString::fromUtf8(author->email).toLower().toUtf8();
+            indexed.trigrams = trigrams(lowerMessage(commit));
+            return indexed;
+        };
+
+        // Walk the next block while the previous one is decoded
+        CommitDecoder decoder(state->repoPath);
+        QFuture<QVector<IndexedCommit>> decoding;
+        bool decodingBlock = false;
+
+        auto buildSegment = [&]() {
+            if (!decodingBlock)
+                return;
+            decodingBlock = false;
+
+            const QVector<IndexedCommit> commits = CommitDecoder::take(decoding);
+            auto segment = std::make_shared<Segment>();
+            segment->oids.reserve(commits.size());
+
+            QHash<QByteArray, qint32> stringIds;
+            auto intern = [&](const QByteArray &text) {
+                auto it = stringIds.constFind(text);
+                if (it != stringIds.constEnd())
+                    return it.value();
+
+                const qint32 id = segment->strings.size();
+                segment->strings.append(text);
+                stringIds.insert(text, id);
+                return id;
+            };
+
+            // Plain lists while the segment is built, encoded once it is complete
+            QHash<quint32, QVector<qint32>> lists;
+            for (const IndexedCommit &commit : commits) {
+                const qint32 index = segment->oids.size();
+                segment->oids.append(commit.oid);
+                segment->authorIds.append(intern(commit.author));
+                segment->emailIds.append(intern(commit.email));
+
+                if (commit.trigrams.isEmpty())
+                    segment->shortMessages.append(index);
+                for (quint32 trigram : commit.trigrams)
+                    lists[trigram].append(index);
+            }
+
+            segment->trigrams = lists.keys();
+            std::sort(segment->trigrams.begin(), segment->trigrams.end());
+            segment->postingOffsets.reserve(segment->trigrams.size() + 1);
+            for (quint32 trigram : std::as_const(segment->trigrams)) {
+                segment->postingOffsets.append(segment->postings.size());
+
+                // Indices ascend: small deltas fit in a byte
+                qint32 previous = -1;
+                for (qint32 index : lists.value(trigram)) {
+                    appendVarint(segment->postings, quint32(index - previous));
+                    previous = index;
+                }
+            }
+            segment->postingOffsets.append(segment->postings.size());
+            segment->postings.squeeze();
+
+            publish(generation, segment);
+        };
+
+        QVector<git_oid> block;
+        git_oid oid;
+        bool walking = true;
+
+        while (walking && !state->cancelled) {
+            block.clear();
+            while (block.size() < SegmentSize && !state->cancelled) {
+                if (git_revwalk_next(&oid, walker) != GIT_OK) {
+                    walking = false;
+                    break;
+                }
+                block.append(oid);
+            }
+
+            buildSegment();
+            if (block.isEmpty())
+                break;
+
+            decoding = decoder.mapAsync<IndexedCommit>(block, convert);
+            decodingBlock = true;
+        }
+        buildSegment();
+
+        git_revwalk_free(walker);
+        git_repository_free(repo);
+
+        if (!state->cancelled)
+            finishBuild(generation, tips, true);
+    });
+}
+
+void CommitSearchIndex::publish(quint64 generation, const std::shared_ptr<const Segment> &segment)
+{
+    QMetaObject::invokeMethod(this, [this, generation, segment]() {
+        if (generation != m_generation || segment->oids.isEmpty())
+            return;
+
+        m_segments.append(segment);
+        m_indexedCount += segment->oids.size();
+        emit indexChanged();
+    }, Qt::QueuedConnection);
+}
+
+void CommitSearchIndex::finishBuild(quint64 generation, const QList<RefTip> &tips, bool changed)
+{
+    QMetaObject::invokeMethod(this, [this, generation, tips, changed]() {
+        if (generation != m_generation)
+            return;
+
+        m_building = false;
+        m_tips = tips;
+        const bool becameReady = !m_ready;
+        m_ready = true;
+
+        if (changed || becameReady)
+            emit indexChanged();
+
+        if (m_updatePending)
+            update();
+    }, Qt::QueuedConnection);
+}
+
+void CommitSearchIndex::failBuild(quint64 generation)
+{
+    QMetaObject::invokeMethod(this, [this, generation]() {
+        if (generation != m_generation)
+            return;
+
+        // Queries keep using what is indexed; the next update() retries
+        m_building = false;
+        m_updatePending = false;
+    }, Qt::QueuedConnection);
+}
+
+bool CommitSearchIndex::canSearch(const QString &text, const QStringList &modes) const
+{
+    if (!m_ready)
+        return false;
+
+    const bool messages = modes.isEmpty() || modes.contains("Messages") || modes.contains("Subjects");
+    return !messages || text.trimmed().toLower().toUtf8().size() >= 3;
+}
+
+QVector<git_oid> CommitSearchIndex::search(const QString &text, const QStringList &modes) const
+{
+    QVector<git_oid> matches;
+
+    const QByteArray needle = text.trimmed().toLower().toUtf8();
+    if (needle.isEmpty())
+        return matches;
+
+    QVector<git_oid> candidates;
+    for (const std::shared_ptr<const Segment> &segment : m_segments)
+        searchSegment(*segment, needle, modes, matches, candidates);
+
+    if (candidates.isEmpty() || !m_verifier)
+        return matches;
+
+    // Trigrams only narrow the candidates down, the message decides
+    const bool subjectsOnly = !modes.isEmpty() && !modes.contains("Messages");
+    auto verify = [needle, subjectsOnly](const git_commit *commit) {
+        VerifiedCommit verified;
+        git_oid_cpy(&verified.oid, git_commit_id(commit));
+
+        QByteArray message = lowerMessage(commit);
+        if (subjectsOnly) {
+            const qsizetype end = message.indexOf('\n');
+            if (end >= 0)
+                message.truncate(end);
+        }
+        verified.matches = message.contains(needle);
+        return verified;
+    };
+
+    const QVector<VerifiedCommit> verified = CommitDecoder::take(
+        m_verifier->mapAsync<VerifiedCommit>(candidates, verify));
+    for (const VerifiedCommit &commit : verified) {
+        if (commit.matches)
+            matches.append(commit.oid);
+    }
+
+    return matches;
+}
+
+QVariantMap CommitSearchIndex::searchRows(const QString &text, const QStringList &modes,
+                                          CommitTable *table) const
+{
+    const QVector<git_oid> matches = search(text, modes);
+
+    QVector<int> rows;
+    if (table) {
+        for (const git_oid &oid : matches) {
+            const int row = table->rowOf(oid);
+            if (row >= 0)
+                rows.append(row);
+        }
+        std::sort(rows.begin(), rows.end());
+    }
+
+    QVariantList rowList;
+    rowList.reserve(rows.size());
+    for (int row : rows)
+        rowList.append(row);
+
+    QVariantMap result;
+    result["count"] = matches.size();
+    result["rows"] = rowList;
+    return result;
+}
+
+void CommitSearchIndex::searchSegment(const Segment &segment, const QByteArray &needle, const QStringList &modes,
+                                      QVector<git_oid> &out, QVector<git_oid> &candidates)
+{
+    const int count = segment.oids.size();
+    QVector<bool> hit(count, false);
+
+    const bool authors = modes.contains("Authors");
+    const bool emails = modes.contains("Emails");
+    if (authors || emails) {
+        QVector<bool> matching(segment.strings.size(), false);
+        for (int id = 0; id < segment.strings.size(); ++id)
+            matching[id] = segment.strings.at(id).contains(needle);
+
+        for (int index = 0; index < count; ++index) {
+            if ((authors && matching.at(segment.authorIds.at(index)))
+                || (emails && matching.at(segment.emailIds.at(index))))
+                hit[index] = true;
+        }
+    }
+
+    if (modes.contains("SHA-1")) {
+        char hex[GIT_OID_SHA1_HEXSIZE + 1];
+        for (int index = 0; index < count; ++index) {
+            if (hit.at(index))
+                continue;
+
+            git_oid_tostr(hex, sizeof(hex), &segment.oids.at(index));
+            if (QByteArray::fromRawData(hex, qstrlen(hex)).contains(needle))
+                hit[index] = true;
+        }
+    }
+
+    for (int index = 0; index < count; ++index) {
+        if (hit.at(index))
+            out.append(segment.oids.at(index));
+    }
+
+    const bool messages = modes.isEmpty() || modes.contains("Messages");
+    const bool subjects = modes.contains("Subjects");
+    if (!messages && !subjects)
+        return;
+
+    QVector<qint32> matched;
+    if (needle.size() >= 3) {
+        // Intersect the posting lists, shortest first
+        QVector<QVector<qint32>> lists;
+        for (quint32 trigram : trigrams(needle)) {
+            QVector<qint32> list;
+            if (!segment.posting(trigram, list)) {
+                lists.clear();
+                break;
+            }
+            lists.append(list);
+        }
+
+        std::sort(lists.begin(), lists.end(), [](const QVector<qint32> &a, const QVector<qint32> &b) {
+            return a.size() < b.size();
+        });
+
+        if (!lists.isEmpty()) {
+            matched = lists.first();
+            for (int i = 1; i < lists.size() && !matched.isEmpty(); ++i) {
+                QVector<qint32> common;
+                std::set_intersection(matched.cbegin(), matched.cend(),
+                                      lists.at(i).cbegin(), lists.at(i).cend(),
+                                      std::back_inserter(common));
+                matched.swap(common);
+            }
+        }
+    } else {
+        // Too short for a trigram: every commit is a candidate (see canSearch())
+        matched.resize(count);
+        std::iota(matched.begin(), matched.end(), 0);
+    }
+
+    for (qint32 index : std::as_const(matched)) {
+        if (!hit.at(index))
+            candidates.append(segment.oids.at(index));
+    }
+}
+
+QVector<quint32> CommitSearchIndex::trigrams(const QByteArray &text)
+{
+    QVector<quint32> result;
+    if (text.size() < 3)
+        return result;
+
+    result.reserve(text.size() - 2);
+    const uchar *bytes = reinterpret_cast<const uchar *>(text.constData());
+    for (qsizetype i = 0; i + 2 < text.size(); ++i)
+        result.append(quint32(bytes[i]) << 16 | quint32(bytes[i + 1]) << 8 | bytes[i + 2]);
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QQmlEngine>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+#include <git2/oid.h>
+
+#include <atomic>
+#include <memory>
+
+#include "CommitTable.h"
+#include "HistorySession.h"
+
+class CommitDecoder;
+
+/**
+ * \brief Trigram index over the commits of a whole repository
+ *
+ * Answers the commit graph filter without loading history page by page:
+ * every commit reachable from the refs is read once on worker threads and
+ * its lower-cased message is split into byte trigrams. A query looks up
+ * the posting lists of its own trigrams, intersects them and verifies the
+ * few candidates left against the messages in the object database, on the
+ * threads of a CommitDecoder.
+ *
+ * Messages themselves are not kept. Per commit the index holds its id
+ * (20 bytes), interned author and email ids (8 bytes) and one entry per
+ * distinct trigram of its message, delta and varint encoded (one or two
+ * bytes each): a few hundred bytes per commit, typically 100-300 MB for
+ * a million commits. Needles shorter than a trigram have no posting list;
+ * canSearch() tells callers to filter loaded rows instead.
+ *
+ * The index grows in segments. Each segment is built off the GUI thread
+ * and published when complete, so queries run on the GUI thread without
+ * locking and already see the part of history indexed so far. After refs
+ * move, update() indexes only the new commits (a walk from the new tips
+ * hiding the indexed ones) into another segment.
+ *
+ * Authors and emails are interned per segment and matched by scanning the
+ * distinct strings; hashes are matched on their hex form.
+ */
+class CommitSearchIndex : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("CommitSearchIndex is owned by GitCommit")
+
+    Q_PROPERTY(bool ready READ isReady NOTIFY indexChanged FINAL)
+    Q_PROPERTY(int indexedCount READ indexedCount NOTIFY indexChanged FINAL)
+
+public:
+    explicit CommitSearchIndex(QObject *parent = nullptr);
+    ~CommitSearchIndex();
+
+    /**
+     * \brief Switch to another repository and drop the index
+     *
+     * Indexing starts on the first call to build().
+     *
+     * \param repoPath Path of the repository, or empty to unload
+     */
+    void setRepositoryPath(const QString &repoPath);
+
+    /**
+     * \brief Start indexing the repository, if not done or running yet
+     */
+    Q_INVOKABLE void build();
+
+    /**
+     * \brief Index the commits added since the last build, rebuild if history was rewritten
+     *
+     * Does nothing until build() was called.
+     */
+    Q_INVOKABLE void update();
+
+    /**
+     * \brief Whether every commit reachable from the refs is indexed
+     */
+    bool isReady() const;
+
+    int indexedCount() const;
+
+    /**
+     * \brief Whether search() can answer a query from the index
+     *
+     * False until the index is ready, and for message or subject searches
+     * shorter than three bytes, which would check every commit against the
+     * object database.
+     */
+    bool canSearch(const QString &text, const QStringList &modes) const;
+
+    /**
+     * \brief Commits whose fields contain text (case-insensitive)
+     * \param text Text to look for
+     * \param modes Fields to search: "Messages", "Subjects", "Authors", "Emails", "SHA-1"
+     * \return Matching commits, in no particular order
+     */
+    QVector<git_oid> search(const QString &text, const QStringList &modes) const;
+
+    /**
+     * \brief Search and map the matches to rows of a commit table
+     * \return {count: total matches in the repository, rows: sorted rows of table that match}
+     */
+    Q_INVOKABLE QVariantMap searchRows(const QString &text, const QStringList &modes,
+                                       CommitTable *table) const;
+
+signals:
+    /**
+     * \brief A segment was added or the index was dropped
+     */
+    void indexChanged();
+
+private:
+    /**
+     * \brief A block of indexed commits; immutable once published
+     */
+    struct Segment
+    {
+        QVector<git_oid> oids;
+        QVector<qint32> authorIds;
+        QVector<qint32> emailIds;
+        QVector<QByteArray> strings;        ///< Lower-cased authors and emails
+        QVector<quint32> trigrams;          ///< Distinct trigrams of all messages, ascending
+        QVector<qint32> postingOffsets;     ///< Start of each trigram's list in postings, plus the end
+        QByteArray postings;                ///< Ascending commit indices per trigram, delta and varint encoded
+        QVector<qint32> shortMessages;      ///< Commits whose message is too short for a trigram
+
+        /**
+         * \brief Decode the commit indices of a trigram
+         * \return false if no message has the trigram
+         */
+        bool posting(quint32 trigram, QVector<qint32> &indices) const;
+    };
+
+    struct BuildState;
+
+    void startBuild(const QList<RefTip> &previousTips);
+    void publish(quint64 generation, const std::shared_ptr<const Segment> &segment);
+    void finishBuild(quint64 generation, const QList<RefTip> &tips, bool changed);
+    void failBuild(quint64 generation);
+
+    /**
+     * \brief Match the fields kept in a segment
+     * \param out Receives the commits matching by author, email or hash
+     * \param candidates Receives the other commits whose message may contain needle
+     */
+    static void searchSegment(const Segment &segment, const QByteArray &needle, const QStringList &modes,
+                              QVector<git_oid> &out, QVector<git_oid> &candidates);
+    static QVector<quint32> trigrams(const QByteArray &text);
+
+    QString m_repoPath;
+    std::unique_ptr<CommitDecoder> m_verifier;  ///< Reads candidate messages for search()
+    QVector<std::shared_ptr<const Segment>> m_segments;
+    QList<RefTip> m_tips;                   ///< Refs the published segments cover
+    std::shared_ptr<BuildState> m_build;
+    QFuture<void> m_future;
+    std::atomic<quint64> m_generation { 0 };
+    int m_indexedCount = 0;
+    bool m_started = false;
+    bool m_ready = false;
+    bool m_building = false;
+    bool m_updatePending = false;
+};
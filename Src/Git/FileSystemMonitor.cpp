@@ -0,0 +1,384 @@
+#include "FileSystemMonitor.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QtConcurrent>
+
+#include <git2/errors.h>
+#include <git2/ignore.h>
+#include <git2/index.h>
+#include <git2/repository.h>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// Content, metadata (the executable bit) and directory entries; never follow links out of the tree
+constexpr uint32_t WatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE
+                               | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW;
+#endif
+
+// Running out of watches is a system setting the user can change; say so once, not per repository
+bool watchLimitReported = false;
+
+QString childPath(const QString &dir, const QString &name)
+{
+    return dir.isEmpty() ? name : dir + '/' + name;
+}
+
+// Ignored directories (build output, node_modules) are left out unless they hold tracked
+// files, whose changes git still reports
+bool skipDirectory(git_repository *repo, git_index *index, const QString &path)
+{
+    if (!repo || !index)
+        return false;
+
+    const QByteArray directory = path.toUtf8() + '/';
+    int ignored = 0;
+    if (git_ignore_path_is_ignored(&ignored, repo, directory.constData()) != GIT_OK || !ignored)
+        return false;
+
+    size_t position = 0;
+    return git_index_find_prefix(&position, index, directory.constData()) != GIT_OK;
+}
+
+} // namespace
+
+FileSystemMonitor::FileSystemMonitor(QObject *parent)
+    : QObject{parent}
+{}
+
+FileSystemMonitor::~FileSystemMonitor()
+{
+    stop();
+}
+
+void FileSystemMonitor::setRootPath(const QString &rootPath)
+{
+    if (rootPath == m_rootPath)
+        return;
+
+    stop();
+    m_changes.clear();
+    m_overflowed = false;
+    m_fullScanNeeded = true;
+    m_rootPath = rootPath;
+
+    if (m_rootPath.isEmpty())
+        return;
+
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0)
+        return;
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &FileSystemMonitor::readEvents);
+
+    watchTree(QString());
+#endif
+}
+
+QString FileSystemMonitor::rootPath() const
+{
+    return m_rootPath;
+}
+
+bool FileSystemMonitor::isActive() const
+{
+    return m_fd >= 0;
+}
+
+bool FileSystemMonitor::takeChanges(QStringList &paths)
+{
+    paths.clear();
+    if (!isActive())
+        return false;
+
+    readEvents();
+
+    if (m_overflowed) {
+        // Directories created while events were lost are not watched yet; adding a watch twice is harmless
+        m_overflowed = false;
+        m_rootWatched = false;
+        m_fullScanNeeded = true;
+        m_changes.clear();
+        watchTree(QString());
+        return false;
+    }
+
+    // Running out of watches stops the monitor
+    if (!isActive())
+        return false;
+
+    // Until the whole tree is watched, and for the scan right after: files may have
+    // changed after the last full scan read them but before their directory had a watch
+    if (!m_rootWatched || m_fullScanNeeded) {
+        if (m_rootWatched)
+            m_fullScanNeeded = false;
+        m_changes.clear();
+        return false;
+    }
+
+    paths = m_changes.values();
+    m_changes.clear();
+    return true;
+}
+
+void FileSystemMonitor::readEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    while (m_fd >= 0) {
+        const ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;  // Drained (EAGAIN)
+
+        for (const char *next = buffer; next < buffer + length;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(next);
+            next += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                m_overflowed = true;
+                continue;
+            }
+
+            const QString name = event->len > 0 ? QFile::decodeName(event->name) : QString();
+            if (!handleEvent(event->wd, event->mask, name) && m_building) {
+                // The watch was added by the running worker; replayed once it is delivered
+                m_pendingEvents.append({ event->wd, event->mask, name });
+            }
+        }
+    }
+#endif
+}
+
+bool FileSystemMonitor::handleEvent(int wd, quint32 mask, const QString &name)
+{
+#ifdef Q_OS_LINUX
+    const auto watch = m_watches.find(wd);
+    if (watch == m_watches.end())
+        return false;
+
+    if (mask & IN_IGNORED) {
+        m_watches.erase(watch);
+        return true;
+    }
+
+    // Events on the watched directory itself are reported by its parent as well
+    if (name.isEmpty() || name == ".git")
+        return true;
+
+    const QString directory = watch.value();
+    const QString path = childPath(directory, name);
+    m_changes.insert(path);
+
+    if (mask & IN_ISDIR) {
+        if (mask & (IN_CREATE | IN_MOVED_TO))
+            watchTree(path);
+        else if (mask & IN_MOVED_FROM)
+            unwatchTree(path);
+    } else if (name == ".gitignore") {
+        // Directories the new rules no longer ignore need watches
+        watchTree(directory);
+    }
+#else
+    Q_UNUSED(wd)
+    Q_UNUSED(mask)
+    Q_UNUSED(name)
+#endif
+
+    return true;
+}
+
+void FileSystemMonitor::watchTree(const QString &path)
+{
+    if (m_fd < 0)
+        return;
+
+    if (!m_queuedTrees.contains(path))
+        m_queuedTrees.append(path);
+    startBuild();
+}
+
+void FileSystemMonitor::startBuild()
+{
+    if (m_building || m_queuedTrees.isEmpty() || m_fd < 0)
+        return;
+
+    const QStringList roots = m_queuedTrees;
+    m_queuedTrees.clear();
+    m_building = true;
+
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_buildCancelled = cancelled;
+
+    const quint64 generation = m_buildGeneration;
+    const int fd = m_fd;
+    const QString rootPath = m_rootPath;
+
+    m_build = QtConcurrent::run([this, generation, fd, rootPath, roots, cancelled]() {
+        QHash<int, QString> watches;
+        const int error = addWatches(fd, rootPath, roots, *cancelled, watches);
+        if (*cancelled)
+            return;
+
+        QMetaObject::invokeMethod(this, [this, generation, roots, watches, error]() {
+            finishBuild(generation, roots, watches, error);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FileSystemMonitor::finishBuild(quint64 generation, const QStringList &roots,
+                                    const QHash<int, QString> &watches, int error)
+{
+    if (generation != m_buildGeneration)
+        return;
+
+    m_building = false;
+
+    if (error != 0) {
+#ifdef Q_OS_LINUX
+        if (error == ENOSPC && !watchLimitReported) {
+            watchLimitReported = true;
+            qWarning() << "FileSystemMonitor: out of inotify watches, every status scans the whole tree."
+                       << "Raise fs.inotify.max_user_watches to track changes.";
+        }
+#endif
+        stop();
+        return;
+    }
+
+    for (auto it = watches.cbegin(); it != watches.cend(); ++it)
+        m_watches.insert(it.key(), it.value());
+
+    for (const QString &root : roots) {
+        if (root.isEmpty()) {
+            m_rootWatched = true;
+            m_fullScanNeeded = true;
+        } else {
+            // Files created in the subtree before its watches were in place
+            m_changes.insert(root);
+        }
+    }
+
+    // Events on the new watches that arrived before them; the others belong to removed watches
+    const QVector<PendingEvent> pending = std::exchange(m_pendingEvents, {});
+    for (const PendingEvent &event : pending)
+        handleEvent(event.wd, event.mask, event.name);
+
+    startBuild();
+}
+
+int FileSystemMonitor::addWatches(int fd, const QString &rootPath, const QStringList &roots,
+                                  const std::atomic<bool> &cancelled, QHash<int, QString> &watches)
+{
+#ifdef Q_OS_LINUX
+    // A handle of our own: the GUI thread's handle is not safe to share
+    git_repository *repo = nullptr;
+    git_index *index = nullptr;
+    if (git_repository_open(&repo, QFile::encodeName(rootPath).constData()) != GIT_OK)
+        repo = nullptr;
+    else if (git_repository_index(&index, repo) != GIT_OK)
+        index = nullptr;
+
+    const QDir root(rootPath);
+    QStringList stack = roots;
+    int error = 0;
+
+    while (!stack.isEmpty() && !cancelled) {
+        const QString path = stack.takeLast();
+        const QString absolute = root.filePath(path);
+
+        const int wd = inotify_add_watch(fd, QFile::encodeName(absolute).constData(), WatchMask);
+        if (wd < 0) {
+            // Out of watches: the tree can no longer be tracked. A directory that vanished or
+            // cannot be read is skipped; git cannot see into it either.
+            if (errno == ENOSPC || errno == ENOMEM) {
+                error = errno;
+                break;
+            }
+            continue;
+        }
+        watches.insert(wd, path);
+
+        // Repositories nested in the tree (submodules) keep their .git out of it too
+        const QStringList children = QDir(absolute).entryList(QDir::Dirs | QDir::NoDotAndDotDot
+                                                              | QDir::Hidden | QDir::NoSymLinks);
+        for (const QString &child : children) {
+            if (child == ".git")
+                continue;
+
+            const QString relative = childPath(path, child);
+            if (!skipDirectory(repo, index, relative))
+                stack.append(relative);
+        }
+    }
+
+    git_index_free(index);
+    git_repository_free(repo);
+    return error;
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(rootPath)
+    Q_UNUSED(roots)
+    Q_UNUSED(cancelled)
+    Q_UNUSED(watches)
+    return 0;
+#endif
+}
+
+void FileSystemMonitor::unwatchTree(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    const QString prefix = path + '/';
+    for (auto it = m_watches.begin(); it != m_watches.end();) {
+        if (it.value() == path || it.value().startsWith(prefix)) {
+            inotify_rm_watch(m_fd, it.key());
+            it = m_watches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+#else
+    Q_UNUSED(path)
+#endif
+}
+
+void FileSystemMonitor::stop()
+{
+    // The worker adds watches to m_fd: it must be done before the descriptor is closed and reused
+    m_buildGeneration++;
+    if (m_buildCancelled)
+        *m_buildCancelled = true;
+    m_build.waitForFinished();
+    m_buildCancelled.reset();
+    m_building = false;
+    m_queuedTrees.clear();
+    m_pendingEvents.clear();
+    m_rootWatched = false;
+
+    if (m_notifier) {
+        // May be called from the notifier's own activated() signal
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0)
+        close(m_fd);
+#endif
+
+    m_fd = -1;
+    m_watches.clear();
+}
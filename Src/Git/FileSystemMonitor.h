@@ -0,0 +1,133 @@
+#pragma once
+
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+class QSocketNotifier;
+
+/**
+ * \brief Collects the paths of a working tree that changed since they were last taken
+ *
+ * On Linux every directory of the tree (except .git and ignored directories
+ * without tracked files) gets an inotify watch; directories created later
+ * are watched as they appear. Changed files and directories are kept as
+ * paths relative to the root until takeChanges().
+ *
+ * Watches are added on a worker thread: a large tree has hundreds of
+ * thousands of directories, and listing them all must not stall the GUI.
+ * Until the whole tree is watched, and once more right after, takeChanges()
+ * asks for a full scan. A subtree that appears later is watched the same
+ * way and reported as changed once its watches are in place.
+ *
+ * The monitor cannot vouch for the tree when the kernel queue overflowed,
+ * a watch could not be added (e.g. fs.inotify.max_user_watches reached) or
+ * the platform has no inotify; takeChanges() then asks for a full scan.
+ */
+class FileSystemMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileSystemMonitor(QObject *parent = nullptr);
+    ~FileSystemMonitor();
+
+    /**
+     * \brief Watch another working tree, dropping the changes collected so far
+     * \param rootPath Working tree, or empty to stop watching
+     */
+    void setRootPath(const QString &rootPath);
+
+    QString rootPath() const;
+
+    /**
+     * \brief Whether changes are being tracked, i.e. takeChanges() can succeed
+     */
+    bool isActive() const;
+
+    /**
+     * \brief Hand over the paths changed since the previous call and start collecting anew
+     *
+     * Pending kernel events are read first, so writes finished before the
+     * call are included.
+     *
+     * \param paths Changed paths relative to the root, '/' separated; directories have no trailing '/'
+     * \return false if changes may have been missed and the whole tree must be scanned
+     */
+    bool takeChanges(QStringList &paths);
+
+private:
+    /**
+     * \brief An event on a watch descriptor the GUI thread does not know yet
+     */
+    struct PendingEvent
+    {
+        int wd = -1;
+        quint32 mask = 0;
+        QString name;
+    };
+
+    void readEvents();
+
+    /**
+     * \brief Record one event
+     * \return false if the watch descriptor is unknown
+     */
+    bool handleEvent(int wd, quint32 mask, const QString &name);
+
+    /**
+     * \brief Watch a directory and everything below it, on the worker thread
+     * \param path Directory relative to the root, empty for the root
+     */
+    void watchTree(const QString &path);
+
+    /**
+     * \brief Start a worker for the queued trees, unless one is running
+     */
+    void startBuild();
+
+    /**
+     * \brief Take over the watches added by a worker
+     * \param roots Trees the worker was asked to watch
+     * \param watches Watch descriptor -> directory, for every directory watched
+     * \param error errno of a failed inotify_add_watch that ends monitoring, 0 if none
+     */
+    void finishBuild(quint64 generation, const QStringList &roots,
+                     const QHash<int, QString> &watches, int error);
+
+    /**
+     * \brief Add watches below the given trees; runs on the worker thread
+     */
+    static int addWatches(int fd, const QString &rootPath, const QStringList &roots,
+                          const std::atomic<bool> &cancelled, QHash<int, QString> &watches);
+
+    /**
+     * \brief Stop watching a directory and everything below it (it was moved away)
+     */
+    void unwatchTree(const QString &path);
+
+    void stop();
+
+    QString m_rootPath;
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QHash<int, QString> m_watches;          ///< Watch descriptor -> directory relative to the root
+    QSet<QString> m_changes;
+    bool m_overflowed = false;
+
+    QFuture<void> m_build;
+    std::shared_ptr<std::atomic<bool>> m_buildCancelled;
+    quint64 m_buildGeneration = 0;
+    bool m_building = false;
+    QStringList m_queuedTrees;              ///< Trees waiting for the running worker
+    bool m_rootWatched = false;             ///< The whole tree has watches
+    bool m_fullScanNeeded = true;           ///< Changes before the watches were in place are unknown
+    QVector<PendingEvent> m_pendingEvents;  ///< Events on watches a running worker has not delivered yet
+};
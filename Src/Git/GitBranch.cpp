@@ -1,17 +1,51 @@
 #include "GitBranch.h"
+#include "CommitGraph.h"
 #include "GitResult.h"
+#include "Reachability.h"
 
 #include <QDebug>
+#include <QtConcurrent>
 #include <git2/branch.h>
 #include <git2/deprecated.h>
 #include <git2/object.h>
 #include <git2/refs.h>
+#include <git2/repository.h>
 #include <git2/revparse.h>
 #include <git2/types.h>
 
+namespace {
+/**
+ * \brief Commit a branch reference points to
+ */
+bool branchTip(git_reference *ref, git_oid *out)
+{
+    if (const git_oid *oid = git_reference_target(ref)) {
+        git_oid_cpy(out, oid);
+        return true;
+    }
+
+    git_object *target = nullptr;
+    if (git_reference_peel(&target, ref, GIT_OBJECT_COMMIT) != GIT_OK || !target)
+        return false;
+
+    git_oid_cpy(out, git_object_id(target));
+    git_object_free(target);
+    return true;
+}
+}
+
 GitBranch::GitBranch(QObject *parent)
     : IGitController{parent}
-{}
+{
+    // Counts of another repository must not show up, even from a running walk
+    connect(this, &IGitController::currentRepoChanged, this, &GitBranch::resetBranchStatus);
+}
+
+GitBranch::~GitBranch()
+{
+    m_statusGeneration++;
+    m_statusFuture.waitForFinished();
+}
 
 QVariantList GitBranch::getBranches()
 {
@@ -178,6 +212,8 @@ GitResult GitBranch::deleteBranch(const QString &branchName)
         git_reference_free(branchRef);
     }
 
+    refreshBranchStatus();
+
     return GitResult(true, QVariant(), QString("Successfully deleted branch: %1").arg(branchName));
 }
 
@@ -256,6 +292,8 @@ GitResult GitBranch::renameBranch(const QString &oldName, const QString &newName
     git_reference_free(newRef);
     git_reference_free(branchRef);
 
+    refreshBranchStatus();
+
     return GitResult(true, QVariant(), QString("Successfully renamed branch '%1' to '%2'.").arg(oldName).arg(newName));
 }
 
@@ -278,8 +316,12 @@ GitResult GitBranch::getBranchLineage(const QString &branchName)
         return GitResult(false, QVariant(), QString("Target branch '%1' not found.").arg(branchName));
     }
 
-    git_oid targetOid = *git_reference_target(targetRef);
+    git_oid targetOid;
+    const bool hasTarget = branchTip(targetRef, &targetOid);
     git_reference_free(targetRef);
+    if (!hasTarget) {
+        return GitResult(false, QVariant(), QString("Failed to resolve branch '%1'.").arg(branchName));
+    }
 
     // Initialize iterator for local branches
     git_branch_iterator *iterator = nullptr;
@@ -288,32 +330,21 @@ GitResult GitBranch::getBranchLineage(const QString &branchName)
         return GitResult(false, QVariant(), "Failed to initialize branch iterator.");
     }
 
-    QVariantList lineage;
+    QStringList candidateNames;
+    QVector<git_oid> candidateTips;
     git_reference *currentRef = nullptr;
     git_branch_t branchType;
 
-    // Traverse all local branches to check for ancestry relationship
     while (git_branch_next(&currentRef, &branchType, iterator) == GIT_OK) {
         const char *outName = nullptr;
         git_branch_name(&outName, currentRef);
         QString currentBranchName = QString::fromUtf8(outName);
 
         // Skip the target branch itself
-        if (currentBranchName == branchName) {
-            git_reference_free(currentRef);
-            continue;
-        }
-
-        git_oid currentOid = *git_reference_target(currentRef);
-        git_oid mergeBaseOid;
-
-        /* * A branch is an ancestor if the merge base between the target
-         * and the candidate is the candidate's tip itself.
-         */
-        int mergeBaseError = git_merge_base(&mergeBaseOid, m_currentRepo->repo, &targetOid, &currentOid);
-
-        if (mergeBaseError == GIT_OK && git_oid_equal(&mergeBaseOid, &currentOid)) {
-            lineage.append(currentBranchName);
+        git_oid currentOid;
+        if (currentBranchName != branchName && branchTip(currentRef, &currentOid)) {
+            candidateNames.append(currentBranchName);
+            candidateTips.append(currentOid);
         }
 
         git_reference_free(currentRef);
@@ -321,6 +352,17 @@ GitResult GitBranch::getBranchLineage(const QString &branchName)
 
     git_branch_iterator_free(iterator);
 
+    /* * A branch is an ancestor if its tip is reachable from the target.
+     * All tips are checked against a single walk from the target.
+     */
+    const QVector<bool> reachable = Reachability::reachableFrom(m_currentRepo->repo, { targetOid }, candidateTips);
+
+    QVariantList lineage;
+    for (int i = 0; i < candidateNames.size(); ++i) {
+        if (reachable.at(i))
+            lineage.append(candidateNames.at(i));
+    }
+
     return GitResult(true, lineage, QString("Successfully retrieved lineage for '%1'.").arg(branchName));
 }
 
@@ -439,3 +481,167 @@ git_reference *GitBranch::getRef(git_repository* repo, const QString &branchName
 }
 
 
+
+GitResult GitBranch::refreshBranchStatus()
+{
+    if (!m_currentRepo || !m_currentRepo->repo)
+        return GitResult(false, QVariant(), "Repository is not open.");
+
+    // Opening another repository reuses the Repository object, without currentRepoChanged()
+    const QString repoPath = QString::fromUtf8(git_repository_path(m_currentRepo->repo));
+    if (repoPath != m_statusRepoPath) {
+        resetBranchStatus();
+        m_statusRepoPath = repoPath;
+    }
+
+    if (m_statusRunning) {
+        m_statusRefreshPending = true;
+        return GitResult(true, 0);
+    }
+
+    const QList<TrackedBranch> branches = trackedBranches();
+
+    // Only pairs whose tips moved need the walk
+    QVector<QPair<git_oid, git_oid>> pairs;
+    QVector<QByteArray> keys;
+    int pendingBranches = 0;
+    for (const TrackedBranch &branch : branches) {
+        if (m_aheadBehindCache.contains(branch.key))
+            continue;
+
+        pendingBranches++;
+        if (keys.contains(branch.key))
+            continue;
+
+        pairs.append(qMakePair(branch.localTip, branch.upstreamTip));
+        keys.append(branch.key);
+    }
+
+    if (pairs.isEmpty()) {
+        publishBranchStatus(branches);
+        return GitResult(true, 0);
+    }
+
+    m_statusRunning = true;
+    const quint64 generation = m_statusGeneration;
+
+    m_statusFuture = QtConcurrent::run([this, generation, repoPath, branches, pairs, keys]() {
+        QVector<AheadBehindCount> counts;
+        bool ok = false;
+
+        git_repository *repo = nullptr;
+        if (git_repository_open(&repo, repoPath.toUtf8().constData()) == GIT_OK) {
+            CommitGraph::attach(repo);
+            ok = AheadBehind::compute(repo, pairs, counts);
+            git_repository_free(repo);
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, branches, keys, counts, ok]() {
+            m_statusRunning = false;
+
+            if (generation == m_statusGeneration) {
+                if (!ok)
+                    qWarning() << "GitBranch: Failed to count ahead/behind of" << keys.size() << "branches";
+
+                // Keep only the pairs of the current tips, old ones won't come back often
+                QHash<QByteArray, AheadBehindCount> cache;
+                for (const TrackedBranch &branch : branches) {
+                    const auto cached = m_aheadBehindCache.constFind(branch.key);
+                    if (cached != m_aheadBehindCache.constEnd())
+                        cache.insert(branch.key, cached.value());
+                }
+                for (int i = 0; ok && i < keys.size(); ++i)
+                    cache.insert(keys.at(i), counts.at(i));
+                m_aheadBehindCache = cache;
+
+                publishBranchStatus(branches);
+            }
+
+            if (m_statusRefreshPending) {
+                m_statusRefreshPending = false;
+                refreshBranchStatus();
+            }
+        }, Qt::QueuedConnection);
+    });
+
+    return GitResult(true, pendingBranches);
+}
+
+void GitBranch::resetBranchStatus()
+{
+    m_statusGeneration++;
+    m_statusRefreshPending = false;
+    m_statusRepoPath.clear();
+    m_aheadBehindCache.clear();
+
+    if (!m_branchStatus.isEmpty()) {
+        m_branchStatus.clear();
+        emit branchStatusChanged();
+    }
+}
+
+QVariantMap GitBranch::branchStatus() const
+{
+    return m_branchStatus;
+}
+
+QVariantMap GitBranch::getBranchStatus(const QString &branchName) const
+{
+    return m_branchStatus.value(branchName).toMap();
+}
+
+QList<GitBranch::TrackedBranch> GitBranch::trackedBranches() const
+{
+    QList<TrackedBranch> branches;
+
+    git_branch_iterator *iter = nullptr;
+    if (git_branch_iterator_new(&iter, m_currentRepo->repo, GIT_BRANCH_LOCAL) != GIT_OK)
+        return branches;
+
+    git_reference *ref = nullptr;
+    git_branch_t type;
+    while (git_branch_next(&ref, &type, iter) == GIT_OK) {
+        git_reference *upstream = nullptr;
+        const char *name = nullptr;
+        const char *upstreamName = nullptr;
+        TrackedBranch branch;
+
+        if (git_branch_upstream(&upstream, ref) == GIT_OK
+            && git_branch_name(&name, ref) == GIT_OK
+            && git_branch_name(&upstreamName, upstream) == GIT_OK
+            && branchTip(ref, &branch.localTip)
+            && branchTip(upstream, &branch.upstreamTip)) {
+            branch.name = QString::fromUtf8(name);
+            branch.upstream = QString::fromUtf8(upstreamName);
+            branch.key = QByteArray(reinterpret_cast<const char *>(branch.localTip.id), GIT_OID_SHA1_SIZE)
+                         + QByteArray(reinterpret_cast<const char *>(branch.upstreamTip.id), GIT_OID_SHA1_SIZE);
+            branches.append(branch);
+        }
+
+        if (upstream)
+            git_reference_free(upstream);
+        git_reference_free(ref);
+    }
+
+    git_branch_iterator_free(iter);
+    return branches;
+}
+
+void GitBranch::publishBranchStatus(const QList<TrackedBranch> &branches)
+{
+    QVariantMap status;
+    for (const TrackedBranch &branch : branches) {
+        const auto cached = m_aheadBehindCache.constFind(branch.key);
+        if (cached == m_aheadBehindCache.constEnd())
+            continue;
+
+        QVariantMap entry;
+        entry["upstream"] = branch.upstream;
+        entry["ahead"] = cached->ahead;
+        entry["behind"] = cached->behind;
+        status.insert(branch.name, entry);
+    }
+
+    m_branchStatus = status;
+    emit branchStatusChanged();
+}
@@ -1,17 +1,25 @@
 #pragma once
 
+#include "AheadBehind.h"
 #include "GitResult.h"
 #include "IGitController.h"
+#include <QFuture>
+#include <QHash>
 #include <QObject>
 #include <QProcess>
 
+#include <atomic>
+
 class GitBranch : public IGitController
 {
     Q_OBJECT
     QML_ELEMENT
 
+    Q_PROPERTY(QVariantMap branchStatus READ branchStatus NOTIFY branchStatusChanged FINAL)
+
 public:
     explicit GitBranch(QObject *parent = nullptr);
+    ~GitBranch();
 
     /**
      * \brief Get list of branches
@@ -73,5 +81,64 @@ public:
     static git_object * getHead(git_repository *repo, const QString &branchName);
     
     static git_reference * getRef(git_repository *, const QString &branchName);
+
+    /**
+     * \brief Recompute ahead/behind of every local branch against its upstream
+     *
+     * Pairs whose tips did not move since the last refresh are answered from
+     * the cache; the others are counted together in one walk on a worker
+     * thread. branchStatusChanged() is emitted once the counts are known.
+     *
+     * A refresh requested while a walk is running starts when it finishes.
+     * Called when a repository is opened and whenever its refs change
+     * (see GitCommit::refDecorationsChanged()).
+     *
+     * \return GitResult with the number of branches still being counted
+     */
+    Q_INVOKABLE GitResult refreshBranchStatus();
+
+    /**
+     * \brief Ahead/behind of the local branches, as of the last finished refresh
+     * \return Map of branch name to {upstream, ahead, behind}; branches without upstream are left out
+     */
+    QVariantMap branchStatus() const;
+
+    /**
+     * \brief Ahead/behind of one local branch
+     * \return {upstream, ahead, behind}, or an empty map if unknown
+     */
+    Q_INVOKABLE QVariantMap getBranchStatus(const QString &branchName) const;
+
+signals:
+    void branchStatusChanged();
+
+private:
+    /**
+     * \brief A local branch and the upstream it tracks
+     */
+    struct TrackedBranch
+    {
+        QString name;
+        QString upstream;
+        git_oid localTip;
+        git_oid upstreamTip;
+        QByteArray key;         ///< Both tips, the cache key
+    };
+
+    QList<TrackedBranch> trackedBranches() const;
+    void publishBranchStatus(const QList<TrackedBranch> &branches);
+
+    /**
+     * \brief Forget all counts and drop the results of a running walk
+     */
+    void resetBranchStatus();
+
+    QVariantMap m_branchStatus;
+    QString m_statusRepoPath;                       ///< Repository the counts belong to
+    QHash<QByteArray, AheadBehindCount> m_aheadBehindCache;
+    QFuture<void> m_statusFuture;
+    std::atomic<quint64> m_statusGeneration { 0 };
+    bool m_statusRunning = false;
+    bool m_statusRefreshPending = false;
 };
 
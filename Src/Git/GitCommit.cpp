@@ -16,76 +16,259 @@
 #include <QRegularExpression>
 
 GitCommit::GitCommit(QObject *parent)
-    : IGitController{parent}
-{}
+    : IGitController{parent},
+      m_history(new CommitTable(this)),
+      m_historyLoader(new HistoryLoader(m_history, this)),
+      m_queryHistory(new CommitTable(this)),
+      m_queryLoader(new HistoryLoader(m_queryHistory, this)),
+      m_searchIndex(new CommitSearchIndex(this)),
+      m_refMembership(new RefMembershipIndex(m_history, this))
+{
+    // Before the batch is forwarded, so listeners already see the new rows' branches
+    connect(m_historyLoader, &HistoryLoader::batchLoaded, m_refMembership, &RefMembershipIndex::sync);
+    connect(m_historyLoader, &HistoryLoader::batchLoaded, this, &GitCommit::commitsBatchLoaded);
+    connect(m_historyLoader, &HistoryLoader::finished, this, &GitCommit::commitsLoadFinished);
+    connect(m_queryLoader, &HistoryLoader::batchLoaded, this, &GitCommit::queryBatchLoaded);
+    connect(m_queryLoader, &HistoryLoader::finished, this, &GitCommit::queryLoadFinished);
+
+    // A walk belongs to the repository it was started on
+    connect(this, &IGitController::currentRepoChanged, this, [this]() {
+        m_historySession.reset();
+        m_refMembership->setRepositoryPath(QString());
+        m_historyLoader->setRepositoryPath(QString());
+        m_history->clear();
+        m_queryLoader->setRepositoryPath(QString());
+        m_searchIndex->setRepositoryPath(QString());
+        m_refDecorations.clear();
+        emit refDecorationsChanged();
+    });
+}
 
+CommitTable *GitCommit::history() const
+{
+    return m_history;
+}
 
-GitResult GitCommit::getCommits(int limit, int offset)
+CommitTable *GitCommit::queryHistory() const
 {
-    QList<Commit> commits;
+    return m_queryHistory;
+}
+
+CommitSearchIndex *GitCommit::searchIndex() const
+{
+    return m_searchIndex;
+}
+
+RefMembershipIndex *GitCommit::refMembership() const
+{
+    return m_refMembership;
+}
+
+const RefDecoration *GitCommit::refDecoration(const git_oid &oid) const
+{
+    return m_refDecorations.find(oid);
+}
+
+const QVector<git_oid> &GitCommit::changedRefDecorations() const
+{
+    return m_refDecorations.changed();
+}
+
+QVariantMap GitCommit::getRefDecoration(const QString &hash) const
+{
+    RefDecoration decoration;
+    git_oid oid;
+    if (git_oid_fromstr(&oid, hash.toUtf8().constData()) == GIT_OK) {
+        if (const RefDecoration *found = m_refDecorations.find(oid))
+            decoration = *found;
+    }
+
+    QVariantMap data;
+    data["branches"] = decoration.branches;
+    data["remotes"] = decoration.remotes;
+    data["tags"] = decoration.tags;
+    data["head"] = decoration.head;
+    return data;
+}
+
+bool GitCommit::refreshRefDecorations()
+{
+    if (!m_refDecorations.refresh(m_currentRepo ? m_currentRepo->repo : nullptr))
+        return false;
+
+    // Refs moved (commit, fetch, pull, from here or another tool): the graph may lack the new commits
+    refreshCommitGraph();
+
+    emit refDecorationsChanged();
+    return true;
+}
+
 
+GitResult GitCommit::getCommits(int limit, int offset)
+{
     // Check if the repository is open
     if (!m_currentRepo || !m_currentRepo->repo) {
         return GitResult(false, QVariant(), "Repository not found.");
     }
 
-    git_revwalk *walker = nullptr;
-    int result = git_revwalk_new(&walker, m_currentRepo->repo);
+    HistorySession *session = historySessionAt(offset);
 
     // Check if the walker was successfully created
-    if (result != GIT_OK) {
-        git_revwalk_free(walker); // Cleanup in case of failure
+    if (!session) {
         return GitResult(false, QVariant(), "Failed to create revwalk.");
     }
 
-    // Sort by time (newest first)
-    git_revwalk_sorting(walker, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME);
-
-    // Push all branch tips to include commits reachable from any branch
-    {
-        git_branch_iterator* iter = nullptr;
-        if (git_branch_iterator_new(&iter, m_currentRepo->repo, GIT_BRANCH_ALL) == 0) {
-            git_reference* ref = nullptr;
-            git_branch_t type;
-
-            while (git_branch_next(&ref, &type, iter) == 0) {
-                const git_oid* oid = git_reference_target(ref);
-                if (oid) {
-                    git_revwalk_push(walker, oid);
-                } else {
-                    // If symbolic ref, peel to commit
-                    git_object* target = nullptr;
-                    if (git_reference_peel(&target, ref, GIT_OBJECT_COMMIT) == 0 && target) {
-                        const git_oid* peeledOid = git_object_id(target);
-                        if (peeledOid)
-                            git_revwalk_push(walker, peeledOid);
-                        git_object_free(target);
-                    }
-                }
+    QList<Commit> commits = readCommits(session, limit);
 
-                git_reference_free(ref);
-            }
+    // If no commits are found, return a failure result
+    if (commits.isEmpty()) {
+        return GitResult(false, QVariant(), "No commits found.");
+    }
 
-            git_branch_iterator_free(iter);
+    return GitResult(true, QVariant::fromValue(commits), QString("Retrieved %1 commits").arg(commits.size()));
+}
+
+GitResult GitCommit::loadCommitsAsync(const QString &cursor, int limit)
+{
+    if (!m_currentRepo || !m_currentRepo->repo) {
+        return GitResult(false, QVariant(), "Repository not found.");
+    }
+
+    // Reopening another repository in place keeps the Repository object, compare paths
+    const QString repoPath = QString::fromUtf8(git_repository_path(m_currentRepo->repo));
+    if (repoPath != m_historyLoader->repositoryPath()) {
+        m_refMembership->setRepositoryPath(repoPath);
+        m_historyLoader->setRepositoryPath(repoPath);
+        m_searchIndex->setRepositoryPath(repoPath);
+
+        if (!cursor.isEmpty()) {
+            QVariantMap data;
+            data["expired"] = true;
+            return GitResult(false, data, "History changed, the cursor is no longer valid.");
         }
     }
 
-    // Push HEAD as fallback (detached HEAD or repos without branches)
-    git_revwalk_push_head(walker);
+    // A fresh load may follow moved refs
+    if (cursor.isEmpty()) {
+        m_searchIndex->update();
+        refreshRefDecorations();
+    }
 
-    git_oid oid;
-    int count = 0;
+    if (!m_historyLoader->load(cursor, limit)) {
+        return GitResult(false, QVariant(), "History is already loading.");
+    }
+
+    return GitResult(true, QVariant(), "History loading started");
+}
 
-    // Skip `offset` commits (paging)
-    int skipped = 0;
-    while (skipped < offset && git_revwalk_next(&oid, walker) == 0) {
-        skipped++;
+GitResult GitCommit::refreshHistory()
+{
+    if (!m_currentRepo || !m_currentRepo->repo) {
+        return GitResult(false, QVariant(), "Repository not found.");
     }
 
+    const QString repoPath = QString::fromUtf8(git_repository_path(m_currentRepo->repo));
+    if (repoPath != m_historyLoader->repositoryPath()) {
+        return GitResult(false, QVariant(), "No loaded history to refresh.");
+    }
+
+    m_searchIndex->update();
+    m_refMembership->update();
+    refreshRefDecorations();
+
+    if (!m_historyLoader->refresh()) {
+        return GitResult(false, QVariant(), "No loaded history to refresh.");
+    }
+
+    return GitResult(true, QVariant(), "History refresh started");
+}
+
+GitResult GitCommit::queryHistoryAsync(const QVariantMap &query, const QString &cursor, int limit)
+{
+    if (!m_currentRepo || !m_currentRepo->repo) {
+        return GitResult(false, QVariant(), "Repository not found.");
+    }
+
+    HistoryQuery historyQuery;
+    historyQuery.path = PathFilter(query.value("path").toString());
+    if (query.contains("since")) {
+        historyQuery.since = query.value("since").toLongLong();
+        historyQuery.hasSince = true;
+    }
+    if (query.contains("until")) {
+        historyQuery.until = query.value("until").toLongLong();
+        historyQuery.hasUntil = true;
+    }
+
+    const QString repoPath = QString::fromUtf8(git_repository_path(m_currentRepo->repo));
+    const bool sameQuery = repoPath == m_queryLoader->repositoryPath()
+                           && historyQuery == m_queryLoader->query();
+
+    if (!sameQuery) {
+        m_queryLoader->setRepositoryPath(repoPath);
+        m_queryLoader->setQuery(historyQuery);
+
+        if (!cursor.isEmpty()) {
+            QVariantMap data;
+            data["expired"] = true;
+            return GitResult(false, data, "History changed, the cursor is no longer valid.");
+        }
+    }
+
+    if (cursor.isEmpty())
+        refreshRefDecorations();
+
+    if (!m_queryLoader->load(cursor, limit)) {
+        return GitResult(false, QVariant(), "History is already loading.");
+    }
+
+    return GitResult(true, QVariant(), "History query started");
+}
+
+GitResult GitCommit::loadPathHistoryAsync(const QString &path, const QString &cursor, int limit)
+{
+    if (PathFilter(path).isEmpty()) {
+        return GitResult(false, QVariant(), "Path cannot be empty.");
+    }
+
+    QVariantMap query;
+    query["path"] = path;
+    return queryHistoryAsync(query, cursor, limit);
+}
+
+HistorySession *GitCommit::historySessionAt(int offset)
+{
+    // Reuse the live walk when the caller continues exactly where the last page ended
+    bool reusable = m_historySession
+                    && m_historySession->isValid()
+                    && m_historySession->position() == offset
+                    && !m_historySession->isStale(m_currentRepo->repo);
+
+    if (!reusable) {
+        m_historySession = std::make_unique<HistorySession>(m_currentRepo->repo);
+        if (!m_historySession->isValid()) {
+            m_historySession.reset();
+            return nullptr;
+        }
+
+        // Skip `offset` commits (paging)
+        m_historySession->skip(offset);
+    }
+
+    return m_historySession.get();
+}
+
+QList<Commit> GitCommit::readCommits(HistorySession *session, int limit)
+{
+    QList<Commit> commits;
+
+    git_oid oid;
+    int count = 0;
+
     // Walk through commits up to limit
-    while (count < limit && git_revwalk_next(&oid, walker) == 0) {
+    while (count < limit && session->next(&oid)) {
         git_commit *gitCommit = nullptr;
-        result = git_commit_lookup(&gitCommit, m_currentRepo->repo, &oid);
+        int result = git_commit_lookup(&gitCommit, m_currentRepo->repo, &oid);
 
         if (result == 0 && gitCommit) {
             // Wrap the git_commit into a Commit object and append to the list
@@ -94,21 +277,13 @@ GitResult GitCommit::getCommits(int limit, int offset)
 
             commit.setparentHashes(parentHashes);
 
-            commits.append(commit); // Assuming Commit class wraps git_commit
+            commits.append(commit);
             git_commit_free(gitCommit);  // Clean up the git_commit object
             count++;
         }
     }
 
-    // Clean up the walker
-    git_revwalk_free(walker);
-
-    // If no commits are found, return a failure result
-    if (commits.isEmpty()) {
-        return GitResult(false, QVariant(), "No commits found.");
-    }
-
-    return GitResult(true, QVariant::fromValue(commits), QString("Retrieved %1 commits").arg(commits.size()));
+    return commits;
 }
 
 GitResult GitCommit::getCommit(const QString &commitHash)
@@ -169,6 +344,28 @@ GitResult GitCommit::getCommit(const QString &commitHash)
     return GitResult(true, QVariant::fromValue(commit));
 }
 
+GitResult GitCommit::getCommitMessages(const QStringList &commitHashes)
+{
+    if (!m_currentRepo || !m_currentRepo->repo) {
+        return GitResult(false, QVariant(), "Repository not found.");
+    }
+
+    QVariantMap messages;
+
+    for (const QString &commitHash : commitHashes) {
+        git_oid oid;
+        git_commit *gitCommit = nullptr;
+        if (git_oid_fromstr(&oid, commitHash.toUtf8().constData()) != GIT_OK
+            || git_commit_lookup(&gitCommit, m_currentRepo->repo, &oid) != GIT_OK)
+            continue;
+
+        messages.insert(commitHash, QString::fromUtf8(git_commit_message(gitCommit)));
+        git_commit_free(gitCommit);
+    }
+
+    return GitResult(true, messages);
+}
+
 QString GitCommit::getParentHash(const QString &commitHash, int index)
 {
     if (!m_currentRepo || !m_currentRepo->repo || commitHash.isEmpty() || index < 0)
@@ -268,6 +465,7 @@ GitResult GitCommit::commit(const QString& message,
 
     cleanupCommitResources(author, tree, parents);
 
+    refreshCommitGraph();
 
     return GitResult(true, QVariant::fromValue(data));
 }
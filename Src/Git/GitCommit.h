@@ -3,10 +3,19 @@
 
 #include <QObject>
 #include <git2/types.h>
+#include "Commit.h"
+#include "CommitSearchIndex.h"
+#include "RefDecorations.h"
+#include "RefMembershipIndex.h"
+#include "CommitTable.h"
 #include "GitResult.h"
+#include "HistoryLoader.h"
+#include "HistorySession.h"
 #include "IGitController.h"
 #include "Repository.h"
 
+#include <memory>
+
 
 /**
  * \brief Structure to hold parent commit information
@@ -28,10 +37,65 @@ class GitCommit : public IGitController
 
     Q_OBJECT
     QML_ELEMENT
+    Q_PROPERTY(CommitTable* history READ history CONSTANT FINAL)
+    Q_PROPERTY(CommitTable* queryHistory READ queryHistory CONSTANT FINAL)
+    Q_PROPERTY(CommitSearchIndex* searchIndex READ searchIndex CONSTANT FINAL)
+    Q_PROPERTY(RefMembershipIndex* refMembership READ refMembership CONSTANT FINAL)
 
 public:
     explicit GitCommit(QObject *parent = nullptr);
 
+    /**
+     * \brief Commits loaded by loadCommitsAsync() and refreshHistory(), in walk order
+     */
+    CommitTable *history() const;
+
+    /**
+     * \brief Commits loaded by queryHistoryAsync(), in walk order
+     */
+    CommitTable *queryHistory() const;
+
+    /**
+     * \brief Search index over all commits of the current repository
+     *
+     * Follows the repository of loadCommitsAsync() and is updated by
+     * refreshHistory(); it is only built once something calls build().
+     */
+    CommitSearchIndex *searchIndex() const;
+
+    /**
+     * \brief Branches containing each commit of history()
+     *
+     * Computed as history() loads and recomputed by refreshHistory() when
+     * refs moved.
+     */
+    RefMembershipIndex *refMembership() const;
+
+    /**
+     * \brief Refs pointing at a commit, from the current ref snapshot
+     * \return nullptr if no ref points at it
+     */
+    const RefDecoration *refDecoration(const git_oid &oid) const;
+
+    /**
+     * \brief Commits whose refs changed with the last refDecorationsChanged()
+     */
+    const QVector<git_oid> &changedRefDecorations() const;
+
+    /**
+     * \brief Refs pointing at a commit
+     * \return {branches, remotes, tags, head}; empty lists when no ref points at it
+     */
+    Q_INVOKABLE QVariantMap getRefDecoration(const QString &hash) const;
+
+    /**
+     * \brief Snapshot the refs again if packed-refs, a loose ref or HEAD changed
+     *
+     * Done by every fresh load and by refreshHistory(); emits refDecorationsChanged().
+     *
+     * \return Whether the snapshot changed
+     */
+    Q_INVOKABLE bool refreshRefDecorations();
 
     /**
      * \brief Get commit history (paged)
@@ -41,6 +105,61 @@ public:
      */
     Q_INVOKABLE GitResult getCommits(int limit = 50, int offset = 0);
 
+    /**
+     * \brief Load the next commits of history on a worker thread
+     *
+     * Returns immediately. Rows are appended to history() in batches, each
+     * announced by commitsBatchLoaded(); commitsLoadFinished() reports the
+     * cursor for the next request. The walk behind the cursor is kept alive
+     * between calls, so every page costs the same regardless of how deep
+     * into history it is. An empty cursor clears history() and restarts from
+     * the current ref tips, cancelling a running load.
+     *
+     * \param cursor Cursor reported by the previous commitsLoadFinished(), or empty
+     * \param limit Maximum number of commits to load (default: 200)
+     * \return GitResult, fails if a load is already running for a non-empty cursor
+     */
+    Q_INVOKABLE GitResult loadCommitsAsync(const QString &cursor = "", int limit = 200);
+
+    /**
+     * \brief Bring history() up to date after refs moved, without reloading it
+     *
+     * Commits added on top of the loaded refs (commit, pull, checkout of a
+     * new branch, ...) are walked on a worker thread and inserted in front
+     * of the loaded rows (CommitTable::rowsPrepended()); the cursor of the
+     * running load stays valid. commitsLoadFinished() reports the result,
+     * with {expired: true} when loaded commits were rewritten away and
+     * history must be reloaded with loadCommitsAsync("").
+     *
+     * \return Failure if no history of the current repository is loaded
+     *         or a load is running
+     */
+    Q_INVOKABLE GitResult refreshHistory();
+
+    /**
+     * \brief Load the commits matching a query on a worker thread (git log --since --until -- path)
+     *
+     * Works like loadCommitsAsync() on queryHistory(). Rows are announced
+     * by queryBatchLoaded(), the end of a page by queryLoadFinished().
+     *
+     * A time window walks by commit date: commits newer than the window
+     * are skipped without being decoded and the walk stops once it is
+     * behind the window, instead of paging through all later history.
+     *
+     * \param query {path: relative path, since: oldest commit time, until: newest commit time};
+     *        times are seconds since epoch, every key is optional
+     * \param cursor Cursor reported by the previous queryLoadFinished(), or empty
+     * \param limit Maximum number of matching commits to load
+     * \return GitResult with data {"expired": true} if the cursor belongs to another query
+     */
+    Q_INVOKABLE GitResult queryHistoryAsync(const QVariantMap &query, const QString &cursor = "", int limit = 200);
+
+    /**
+     * \brief Load the history of a single file or directory (queryHistoryAsync() with a path only)
+     * \param path Path relative to the repository root
+     */
+    Q_INVOKABLE GitResult loadPathHistoryAsync(const QString &path, const QString &cursor = "", int limit = 200);
+
     /**
      * \brief Get detailed information about a specific commit
      * \param commitHash Full or short commit hash
@@ -48,6 +167,17 @@ public:
      */
     Q_INVOKABLE GitResult getCommit(const QString &commitHash);
 
+    /**
+     * \brief Get the full messages of several commits at once
+     *
+     * History rows only carry the summary; bodies are fetched through this
+     * call when they are actually needed (selection, message search).
+     *
+     * \param commitHashes Full commit hashes
+     * \return GitResult with QVariantMap {hash: message}; unknown hashes are left out
+     */
+    Q_INVOKABLE GitResult getCommitMessages(const QStringList &commitHashes);
+
     /**
     * \brief Get a parent commit hash by index
     *
@@ -137,8 +267,58 @@ public:
 
     void setCurrentRepo(Repository *newCurrentRepo);
 
+signals:
+    /**
+     * \brief Rows [firstRow, firstRow + count) of history() were loaded by loadCommitsAsync()
+     */
+    void commitsBatchLoaded(int firstRow, int count);
+
+    /**
+     * \brief A loadCommitsAsync() request finished
+     * \param result {success, count, cursor, hasMore} or {success: false, expired, error}
+     */
+    void commitsLoadFinished(QVariantMap result);
+
+    /**
+     * \brief Rows [firstRow, firstRow + count) of queryHistory() were loaded by queryHistoryAsync()
+     */
+    void queryBatchLoaded(int firstRow, int count);
+
+    /**
+     * \brief A queryHistoryAsync() request finished
+     * \param result {success, count, cursor, hasMore} or {success: false, expired, error}
+     */
+    void queryLoadFinished(QVariantMap result);
+
+    /**
+     * \brief The ref snapshot behind refDecoration() changed, see changedRefDecorations()
+     */
+    void refDecorationsChanged();
+
 private:
     QStringList getAllParents(git_commit* gitCommit);
 
+    /**
+     * \brief Return the history session positioned at offset, reusing the live one when possible
+     * \param offset Number of commits to skip from the start of the walk
+     * \return Session positioned at offset, or nullptr if the walk could not be created
+     */
+    HistorySession* historySessionAt(int offset);
+
+    /**
+     * \brief Decode up to limit commits from a history session
+     */
+    QList<Commit> readCommits(HistorySession *session, int limit);
+
+    CommitTable *m_history = nullptr;
+    HistoryLoader *m_historyLoader = nullptr;
+    CommitTable *m_queryHistory = nullptr;
+    HistoryLoader *m_queryLoader = nullptr;
+    CommitSearchIndex *m_searchIndex = nullptr;
+    RefMembershipIndex *m_refMembership = nullptr;
+    RefDecorations m_refDecorations;
+
+    std::unique_ptr<HistorySession> m_historySession;
+
 };
 
@@ -148,6 +148,9 @@ GitResult GitRemote::push(const QString &remoteName, const QString &branchName,
     pushResult["force"] = force;
     pushResult["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
 
+    // Remote-tracking refs moved
+    refreshCommitGraph();
+
     return GitResult(true, pushResult);
 }
 
@@ -1,5 +1,6 @@
 #include "GitRepository.h"
 #include "GitResult.h"
+#include "CommitGraph.h"
 
 #include <QDir>
 #include <QtConcurrent>
@@ -81,6 +82,10 @@ GitResult GitRepository::open(const QString &path)
     if (result != 0)
         return GitResult(false, QVariant(), "Failed to open repository");
 
+    // Use an existing commit-graph right away, rewrite it in the background if outdated
+    CommitGraph::attach(m_currentRepo->repo);
+    refreshCommitGraph();
+
     // Store path and emit signal
     m_currentRepoPath = path;
     emit currentRepoChanged();
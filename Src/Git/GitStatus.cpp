@@ -1,13 +1,59 @@
 #include "GitStatus.h"
+#include "FileSystemMonitor.h"
 #include "GitDiff.h"
 #include "GitFileStatus.h"
+#include "UntrackedCache.h"
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
 #include <git2.h>
 
+namespace {
+
+// Beyond this many changed paths one scan of the tree is cheaper than the path list
+constexpr int MaxIncrementalPaths = 2048;
+
+// Streamed working tree batches start small so the first files show up at once, then grow
+constexpr int FirstBatchSize = 32;
+constexpr int MaxBatchSize = 1024;
+
+// A path may come from two scans (e.g. staged from one, modified in the working tree from the other)
+void insertStatus(QMap<QString, GitFileStatus> &cache, const GitFileStatus &fileInfo)
+{
+    const auto it = cache.constFind(fileInfo.path());
+    if (it == cache.constEnd()) {
+        cache.insert(fileInfo.path(), fileInfo);
+        return;
+    }
+
+    cache.insert(fileInfo.path(), it.value().merged(fileInfo));
+}
+
+}
+
 GitStatus::GitStatus(QObject *parent)
-    : IGitController{parent}
-{}
+    : IGitController{parent},
+      m_monitor(new FileSystemMonitor(this)),
+      m_untrackedCache(new UntrackedCache(this))
+{
+    // The cached status belongs to the repository it was computed for
+    connect(this, &IGitController::currentRepoChanged, this, [this]() {
+        cancelStatus();
+        m_monitor->setRootPath(QString());
+        m_untrackedCache->setRepositoryPath(QString());
+        m_statusCache.clear();
+        m_statusValid = false;
+        m_repoStamp.clear();
+        m_indexPaths.clear();
+    });
+}
+
+GitStatus::~GitStatus()
+{
+    // The scan uses the caches owned by this object
+    cancelStatus();
+}
 
 GitResult GitStatus::stageFile(const QString &filePath)
 {
@@ -39,6 +85,7 @@ GitResult GitStatus::unstageFile(const QString &filePath)
     git_strarray array = { paths, 1 };
 
     // Reset the Index entry for this path to match the HEAD version
+    const QByteArray stampBefore = repoStamp();
     error = git_reset_default(m_currentRepo->repo, head_obj, &array);
     git_object_free(head_obj);
 
@@ -46,6 +93,8 @@ GitResult GitStatus::unstageFile(const QString &filePath)
         return GitResult(false, QVariant(), "Failed to reset index for file.");
     }
 
+    indexWritten(stampBefore, { filePath });
+
     return GitResult(true, filePath, "File unstaged successfully.");
 }
 
@@ -99,35 +148,362 @@ GitResult GitStatus::status()
     if (!m_currentRepo || !m_currentRepo->repo)
         return GitResult(false, QVariant(), "No repository available. Please open a repository first.");
 
+    // The scan below shares the caches with a background scan
+    cancelStatus();
+
+    QByteArray stamp;
+    if (!refreshStatus(stamp)) {
+        QList<GitFileStatus> fileInfos;
+        m_untrackedCache->setRepositoryPath(QString::fromUtf8(git_repository_path(m_currentRepo->repo)));
+        m_statusValid = scanStatus(m_currentRepo->repo, [&fileInfos](const QList<GitFileStatus> &batch) {
+            fileInfos += batch;
+        });
+
+        m_statusCache.clear();
+        for (const GitFileStatus &fileInfo : std::as_const(fileInfos))
+            insertStatus(m_statusCache, fileInfo);
+    }
+
+    m_repoStamp = stamp;
+
+    return GitResult(true, QVariant::fromValue(m_statusCache.values()));
+}
+
+bool GitStatus::loadStatus()
+{
+    cancelStatus();
+
+    if (!m_currentRepo || !m_currentRepo->repo)
+        return false;
 
-    QVariantMap statusData;
+    emit statusStarted();
+
+    const quint64 generation = m_statusGeneration;
+
+    QByteArray stamp;
+    if (refreshStatus(stamp)) {
+        const QList<GitFileStatus> fileInfos = m_statusCache.values();
+        deliverStatusBatch(generation, fileInfos);
+        deliverStatusFinished(generation, true, fileInfos, stamp);
+        return true;
+    }
+
+    // Not valid until the scan is done; status() meanwhile cancels it and scans on its own
+    m_statusValid = false;
+
+    const QString repoPath = QString::fromUtf8(git_repository_path(m_currentRepo->repo));
+    m_untrackedCache->setRepositoryPath(repoPath);
+
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_statusCancelled = cancelled;
+
+    m_statusFuture = QtConcurrent::run([this, generation, repoPath, stamp, cancelled]() {
+        // libgit2 repository handles must not be shared between threads
+        git_repository *repo = nullptr;
+        if (git_repository_open(&repo, repoPath.toUtf8().constData()) != GIT_OK) {
+            deliverStatusFinished(generation, false, QList<GitFileStatus>(), stamp);
+            return;
+        }
+
+        QList<GitFileStatus> fileInfos;
+        const bool success = scanStatus(repo, [this, generation, &fileInfos](const QList<GitFileStatus> &batch) {
+            fileInfos += batch;
+            deliverStatusBatch(generation, batch);
+        }, cancelled.get());
+        git_repository_free(repo);
+
+        deliverStatusFinished(generation, success, fileInfos, stamp);
+    });
+
+    return true;
+}
+
+void GitStatus::cancelStatus()
+{
+    // Drop batches still queued for the GUI thread
+    m_statusGeneration++;
+
+    if (m_statusCancelled)
+        *m_statusCancelled = true;
+
+    m_statusFuture.waitForFinished();
+    m_statusCancelled.reset();
+}
+
+bool GitStatus::refreshStatus(QByteArray &stamp)
+{
+    const char *workdir = git_repository_workdir(m_currentRepo->repo);
+    const QString rootPath = workdir ? QString::fromUtf8(workdir) : QString();
+    if (rootPath != m_monitor->rootPath()) {
+        m_monitor->setRootPath(rootPath);
+        m_statusValid = false;
+    }
+
+    // Taken before scanning: whatever changes during the scan is picked up next time
+    QStringList changed;
+    const bool tracked = m_monitor->takeChanges(changed);
+    stamp = repoStamp();
+
+    for (const QString &path : std::as_const(m_indexPaths))
+        changed.append(path);
+    m_indexPaths.clear();
+
+    if (!m_statusValid || !tracked || stamp != m_repoStamp || changed.size() > MaxIncrementalPaths)
+        return false;
+
+    // A changed .gitignore can hide or reveal any untracked file below it
+    for (const QString &path : std::as_const(changed)) {
+        if (path == ".gitignore" || path.endsWith("/.gitignore"))
+            return false;
+    }
+
+    return changed.isEmpty() || updateStatus(changed);
+}
+
+bool GitStatus::scanStatus(git_repository *repo, const StatusBatchHandler &deliver,
+                           const std::atomic<bool> *cancelled)
+{
+    const auto isCancelled = [cancelled]() { return cancelled && *cancelled; };
+
+    // HEAD to index reads no working tree file: the staged changes come first
     QList<GitFileStatus> fileInfos;
+    if (!collectStatus(repo, QStringList(), NoUntracked, fileInfos, GIT_STATUS_SHOW_INDEX_ONLY))
+        return false;
+    deliver(fileInfos);
+
+    // Of the working tree, only files whose stat changed are compared; an empty path list would mean all
+    QStringList changed;
+    if (m_parallelStatus.changedFiles(repo, changed, cancelled)) {
+        qsizetype first = 0;
+        qsizetype batchSize = FirstBatchSize;
+        while (first < changed.size()) {
+            if (isCancelled())
+                return false;
+
+            fileInfos.clear();
+            if (!collectStatus(repo, changed.mid(first, batchSize), NoUntracked, fileInfos,
+                               GIT_STATUS_SHOW_WORKDIR_ONLY)) {
+                return false;
+            }
+            deliver(fileInfos);
 
+            first += batchSize;
+            batchSize = qMin(batchSize * 2, qsizetype(MaxBatchSize));
+        }
+    } else if (isCancelled()) {
+        return false;
+    } else {
+        fileInfos.clear();
+        if (!collectStatus(repo, QStringList(), NoUntracked, fileInfos, GIT_STATUS_SHOW_WORKDIR_ONLY))
+            return false;
+        deliver(fileInfos);
+    }
+
+    QStringList untracked;
+    fileInfos.clear();
+    if (m_untrackedCache->scan(repo, untracked, cancelled)) {
+        for (const QString &path : std::as_const(untracked))
+            fileInfos.append(GitFileStatus(path, GitFileStatus::Untracked, false, true, false));
+    } else if (isCancelled()) {
+        return false;
+    } else {
+        QList<GitFileStatus> workdirInfos;
+        if (!collectStatus(repo, QStringList(), UntrackedDirectories, workdirInfos, GIT_STATUS_SHOW_WORKDIR_ONLY))
+            return false;
+        for (const GitFileStatus &fileInfo : std::as_const(workdirInfos)) {
+            if (fileInfo.isUntracked())
+                fileInfos.append(fileInfo);
+        }
+    }
+    deliver(fileInfos);
+
+    return true;
+}
+
+void GitStatus::deliverStatusBatch(quint64 generation, const QList<GitFileStatus> &files)
+{
+    if (files.isEmpty())
+        return;
+
+    QMetaObject::invokeMethod(this, [this, generation, files]() {
+        if (generation != m_statusGeneration)
+            return;
+
+        emit statusBatchLoaded(files);
+    }, Qt::QueuedConnection);
+}
+
+void GitStatus::deliverStatusFinished(quint64 generation, bool success, const QList<GitFileStatus> &files,
+                                      const QByteArray &stamp)
+{
+    QMetaObject::invokeMethod(this, [this, generation, success, files, stamp]() {
+        if (generation != m_statusGeneration)
+            return;
+
+        QVariantMap result;
+        result["success"] = success;
+
+        if (!success) {
+            result["error"] = "Failed to compute the repository status.";
+            emit statusFinished(result);
+            return;
+        }
+
+        m_statusCache.clear();
+        for (const GitFileStatus &fileInfo : files)
+            insertStatus(m_statusCache, fileInfo);
+        m_statusValid = true;
+        m_repoStamp = stamp;
+
+        result["count"] = m_statusCache.size();
+        emit statusFinished(result);
+    }, Qt::QueuedConnection);
+}
+
+bool GitStatus::collectStatus(git_repository *repo, const QStringList &paths, UntrackedMode untracked,
+                              QList<GitFileStatus> &out, git_status_show_t show)
+{
     // Configure status options
     git_status_options opts = GIT_STATUS_OPTIONS_INIT;
-    opts.show = GIT_STATUS_SHOW_INDEX_AND_WORKDIR;      //Index vs HEAD
-    opts.flags = GIT_STATUS_OPT_INCLUDE_UNTRACKED;
+    opts.show = show;
+    opts.flags = untracked != NoUntracked ? GIT_STATUS_OPT_INCLUDE_UNTRACKED : 0;
+
+    // Listed untracked files are only reported when untracked directories are recursed into
+    if (untracked == UntrackedFiles)
+        opts.flags |= GIT_STATUS_OPT_RECURSE_UNTRACKED_DIRS;
+
+    // Exact paths let the workdir iterator skip every directory not on the list
+    QList<QByteArray> pathsUtf8;
+    std::vector<char *> pathPointers;
+    if (!paths.isEmpty()) {
+        for (const QString &path : paths)
+            pathsUtf8.append(path.toUtf8());
+        for (QByteArray &path : pathsUtf8)
+            pathPointers.push_back(path.data());
+
+        opts.flags |= GIT_STATUS_OPT_DISABLE_PATHSPEC_MATCH;
+        opts.pathspec.strings = pathPointers.data();
+        opts.pathspec.count = pathPointers.size();
+    }
 
     git_status_list *status_list = nullptr;
-    int gitResult = git_status_list_new(&status_list,  m_currentRepo->repo, &opts);
+    if (git_status_list_new(&status_list, repo, &opts) != GIT_OK)
+        return false;
 
-    if (gitResult == 0) {
-        size_t count = git_status_list_entrycount(status_list);
+    size_t count = git_status_list_entrycount(status_list);
+
+    // Process each status entry
+    for (size_t i = 0; i < count; i++) {
+        const git_status_entry *entry = git_status_byindex(status_list, i);
+        if (!entry) continue;
+
+        out.append(GitFileStatus(entry));
+    }
 
-        // Process each status entry
-        for (size_t i = 0; i < count; i++) {
-            const git_status_entry *entry = git_status_byindex(status_list, i);
-            if (!entry) continue;
+    // Clean up status list
+    git_status_list_free(status_list);
+    return true;
+}
 
-            GitFileStatus fileInfo = GitFileStatus(entry);
-            fileInfos.append(fileInfo);
+bool GitStatus::updateStatus(const QStringList &changed)
+{
+    git_index *index = nullptr;
+    if (git_repository_index(&index, m_currentRepo->repo) != GIT_OK)
+        return false;
+    UniqueIndex indexGuard(index);
+
+    const QDir root(m_monitor->rootPath());
+
+    // A full scan reports an untracked directory as one "dir/" entry; rescan changes below
+    // it, and changed directories, as directories so the entries come out the same way
+    QSet<QString> directories;
+    QSet<QString> files;
+    for (const QString &path : changed) {
+        QString untrackedDir;
+        for (int slash = path.indexOf('/'); slash >= 0; slash = path.indexOf('/', slash + 1)) {
+            size_t position = 0;
+            const QByteArray prefix = path.left(slash + 1).toUtf8();
+            if (git_index_find_prefix(&position, index, prefix.constData()) != GIT_OK) {
+                untrackedDir = path.left(slash);
+                break;
+            }
         }
 
-        // Clean up status list
-        git_status_list_free(status_list);
+        const QFileInfo info(root.filePath(path));
+        if (!untrackedDir.isEmpty())
+            directories.insert(untrackedDir);
+        else if (info.isDir() && !info.isSymLink())
+            directories.insert(path);
+        else
+            files.insert(path);
+    }
+
+    const QStringList directoryPaths = directories.values();
+    const QStringList filePaths = files.values();
+    QList<GitFileStatus> fileInfos;
+    if ((!directoryPaths.isEmpty() && !collectStatus(m_currentRepo->repo, directoryPaths, UntrackedDirectories, fileInfos))
+        || (!filePaths.isEmpty() && !collectStatus(m_currentRepo->repo, filePaths, UntrackedFiles, fileInfos))) {
+        return false;
+    }
+
+    for (const QString &path : directoryPaths)
+        forgetStatus(path);
+    for (const QString &path : filePaths)
+        forgetStatus(path);
+    for (const GitFileStatus &fileInfo : std::as_const(fileInfos))
+        insertStatus(m_statusCache, fileInfo);
+
+    return true;
+}
+
+void GitStatus::forgetStatus(const QString &path)
+{
+    m_statusCache.remove(path);
+
+    // Files below a directory and the directory itself as an untracked entry ("dir/")
+    const QString prefix = path + '/';
+    auto it = m_statusCache.lowerBound(prefix);
+    while (it != m_statusCache.end() && it.key().startsWith(prefix))
+        it = m_statusCache.erase(it);
+}
+
+QByteArray GitStatus::repoStamp() const
+{
+    git_repository *repo = m_currentRepo->repo;
+    QByteArray stamp;
+
+    git_oid head;
+    if (git_reference_name_to_id(&head, repo, "HEAD") == GIT_OK) {
+        char headHex[GIT_OID_HEXSZ + 1];
+        git_oid_tostr(headHex, sizeof(headHex), &head);
+        stamp = headHex;
+    }
+
+    // The index ends with a checksum of its contents: exact, unlike its modification time
+    QFile index(QString::fromUtf8(git_repository_path(repo)) + "index");
+    if (index.open(QIODevice::ReadOnly) && index.size() >= GIT_OID_RAWSZ
+        && index.seek(index.size() - GIT_OID_RAWSZ)) {
+        stamp += ':' + index.read(GIT_OID_RAWSZ).toHex();
+    }
+
+    const QFileInfo exclude(QString::fromUtf8(git_repository_commondir(repo)) + "info/exclude");
+    if (exclude.exists()) {
+        stamp += ':' + QByteArray::number(exclude.lastModified().toMSecsSinceEpoch())
+                 + ':' + QByteArray::number(exclude.size());
     }
 
-    return GitResult(true, QVariant::fromValue(fileInfos));
+    return stamp;
+}
+
+void GitStatus::indexWritten(const QByteArray &before, const QStringList &paths)
+{
+    // If someone else wrote the index meanwhile, the next status scans everything anyway
+    if (!m_statusValid || before != m_repoStamp)
+        return;
+
+    m_repoStamp = repoStamp();
+    for (const QString &path : paths)
+        m_indexPaths.insert(path);
 }
 
 GitResult GitStatus::getStagedFiles()
@@ -160,6 +536,7 @@ GitResult GitStatus::addToIndex(const QString& filePath, bool isRemove)
     if (result != GIT_OK)
         return GitResult(false, QVariant(), "Failed to get repository index");
 
+    const QByteArray stampBefore = repoStamp();
     QByteArray filePathUtf8 = filePath.toUtf8();
     result = isRemove ? git_index_remove_bypath(index, filePathUtf8.constData())
                       : git_index_add_bypath(index, filePathUtf8.constData());
@@ -175,6 +552,8 @@ GitResult GitStatus::addToIndex(const QString& filePath, bool isRemove)
     if (result != GIT_OK)
         return GitResult(false, QVariant(), "Failed to write changes to disk");
 
+    indexWritten(stampBefore, { filePath });
+
     return GitResult(true, filePath, "File staged/unstaged successfully");
 }
 
@@ -667,6 +1046,7 @@ GitResult GitStatus::writeIndexFromBuffer(git_repository* repo,
         return GitResult(false, QVariant(), "Failed to open index");
 
     UniqueIndex idx(idxRaw);
+    const QByteArray stampBefore = repoStamp();
 
     git_index_entry entry;
     std::memset(&entry, 0, sizeof(entry));
@@ -686,6 +1066,8 @@ GitResult GitStatus::writeIndexFromBuffer(git_repository* repo,
     if (git_index_write(idx.get()) != GIT_OK)
         return GitResult(false, QVariant(), "Failed to write index");
 
+    indexWritten(stampBefore, { filePath });
+
     return GitResult(true, QVariant(), "Selected lines staged into index");
 }
 
@@ -890,7 +1272,8 @@ GitResult GitStatus::revertFile(const QString &filePath)
     opts.paths.strings = &path;
     opts.paths.count = 1;
 
-    // Perform checkout from the index to the working directory
+    // Perform checkout from the index to the working directory (it may refresh the index entry)
+    const QByteArray stampBefore = repoStamp();
     int error = git_checkout_index(m_currentRepo->repo, nullptr, &opts);
 
     if (error != GIT_OK) {
@@ -899,6 +1282,8 @@ GitResult GitStatus::revertFile(const QString &filePath)
         return GitResult(false, QVariant(), "Failed to revert file: " + errorMsg);
     }
 
+    indexWritten(stampBefore, { filePath });
+
     return GitResult(true, filePath, "File reverted successfully to index state.");
 }
 
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <QFuture>
+#include <QMap>
 #include <QObject>
+#include <QSet>
+#include <QVariantMap>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <QString>
@@ -9,10 +15,15 @@
 #include <git2/diff.h>
 #include <git2/patch.h>
 #include <git2/index.h>
+#include <git2/status.h>
 
 #include "GitFileStatus.h"
 #include "GitResult.h"
 #include "IGitController.h"
+#include "ParallelStatus.h"
+
+class FileSystemMonitor;
+class UntrackedCache;
 
 // Smart pointer deleters for libgit2 types
 struct IndexDeleter { void operator()(git_index* p) const { git_index_free(p); } };
@@ -32,6 +43,7 @@ class GitStatus : public IGitController
 
 public:
     explicit GitStatus(QObject *parent = nullptr);
+    ~GitStatus();
 
     /**
      * \brief Stage a file for commit
@@ -62,10 +74,43 @@ public:
 
     /**
      * \brief Get repository status (staged/unstaged/untracked files)
+     *
+     * The first call scans the whole working tree; untracked files come from
+     * an UntrackedCache, which skips directories unchanged since the last
+     * scan (also across restarts), and the tracked files are stat'ed on all
+     * cores by ParallelStatus so libgit2 only compares the few whose stat
+     * changed. Later calls only rescan
+     * the paths a FileSystemMonitor saw change since, and the paths this
+     * controller staged or unstaged. The whole tree is scanned again when
+     * the monitor may have missed changes, HEAD moved, the index or the
+     * exclude file was written by someone else or a .gitignore changed.
+     *
      * \return GitResult with status information
      */
     Q_INVOKABLE GitResult status();
 
+    /**
+     * \brief Compute the status in the background, delivering it in batches
+     *
+     * Works like status(), but a full scan runs on a worker thread with its
+     * own repository handle and hands over the files as they are found:
+     * staged changes first, then the modified tracked files in small, growing
+     * batches, then the untracked files. statusBatchLoaded() is emitted for
+     * each batch and statusFinished() at the end. When only a few paths
+     * changed the whole status comes in a single batch.
+     *
+     * A running scan is cancelled first; so are scans still running when the
+     * repository changes or status() is called.
+     *
+     * \return false if no repository is open
+     */
+    Q_INVOKABLE bool loadStatus();
+
+    /**
+     * \brief Stop the scan started by loadStatus(), if any; its pending batches are dropped
+     */
+    Q_INVOKABLE void cancelStatus();
+
     /**
      * \brief Stage or unstage a file in the repository index
      *
@@ -159,7 +204,95 @@ public:
      */
     Q_INVOKABLE GitResult revertAll();
 
+signals:
+    /**
+     * \brief loadStatus() started a new status; the batches that follow make up all of it
+     */
+    void statusStarted();
+
+    /**
+     * \brief Files found by loadStatus(); a path staged and modified again comes in two batches
+     */
+    void statusBatchLoaded(QList<GitFileStatus> files);
+
+    /**
+     * \brief The scan started by loadStatus() finished
+     * \param result {success, count} or {success: false, error}
+     */
+    void statusFinished(QVariantMap result);
+
 private:
+    using StatusBatchHandler = std::function<void(const QList<GitFileStatus> &)>;
+
+    /**
+     * \brief How collectStatus() reports untracked files
+     */
+    enum UntrackedMode {
+        NoUntracked,            ///< Tracked files only
+        UntrackedDirectories,   ///< A wholly untracked directory as one "dir/" entry, like git status
+        UntrackedFiles          ///< Every untracked file; needed to see listed untracked files at all
+    };
+
+    /**
+     * \brief Run git status, limited to some paths
+     * \param repo Repository to scan
+     * \param paths Exact paths relative to the working tree (a directory covers its contents), empty for all
+     * \param untracked How untracked files are reported
+     * \param out Receives one entry per changed file or untracked directory
+     * \param show Which comparisons to run (HEAD to index, index to working tree or both)
+     * \return false if the status could not be computed
+     */
+    static bool collectStatus(git_repository *repo, const QStringList &paths, UntrackedMode untracked,
+                              QList<GitFileStatus> &out, git_status_show_t show = GIT_STATUS_SHOW_INDEX_AND_WORKDIR);
+
+    /**
+     * \brief Bring the cached status up to date with the paths changed since it was computed
+     * \param stamp Receives repoStamp(), taken before looking at the working tree
+     * \return false if the whole working tree has to be scanned
+     */
+    bool refreshStatus(QByteArray &stamp);
+
+    /**
+     * \brief Scan the whole working tree, staged changes first, then tracked files, then untracked files
+     *
+     * May run on a worker thread: only m_parallelStatus and m_untrackedCache
+     * are used, and the untracked cache must already be set to the repository.
+     *
+     * \param repo Repository to scan, not used by another thread meanwhile
+     * \param deliver Called with every batch found, on the scanning thread
+     * \param cancelled Checked between batches; the scan stops early once it is set
+     * \return false if the status could not be computed or the scan was cancelled
+     */
+    bool scanStatus(git_repository *repo, const StatusBatchHandler &deliver,
+                    const std::atomic<bool> *cancelled = nullptr);
+
+    void deliverStatusBatch(quint64 generation, const QList<GitFileStatus> &files);
+    void deliverStatusFinished(quint64 generation, bool success, const QList<GitFileStatus> &files,
+                               const QByteArray &stamp);
+
+    /**
+     * \brief Rescan changed paths and merge them into the cached status
+     * \return false if the status could not be computed; the cache is left as it was
+     */
+    bool updateStatus(const QStringList &changed);
+
+    /**
+     * \brief Drop the cached entries of a path and everything below it
+     */
+    void forgetStatus(const QString &path);
+
+    /**
+     * \brief Fingerprint of HEAD, the index and the exclude file
+     */
+    QByteArray repoStamp() const;
+
+    /**
+     * \brief Keep the cached status usable after this controller wrote the index
+     * \param before repoStamp() taken before the write
+     * \param paths Paths whose index entries were written
+     */
+    void indexWritten(const QByteArray &before, const QStringList &paths);
+
     /**
      * @brief Get unstaged diff view (index to workdir).
      * @param filePath Path to the file to inspect.
@@ -261,4 +394,16 @@ private:
     * @return GitResult success status.
     */
     GitResult writeIndexFromBuffer(git_repository *repo, const QString &filePath, const QByteArray &contentUtf8, uint32_t modeIfKnown);
+
+    FileSystemMonitor *m_monitor = nullptr;
+    UntrackedCache *m_untrackedCache = nullptr;
+    ParallelStatus m_parallelStatus;
+    QMap<QString, GitFileStatus> m_statusCache;     ///< Status of the last call, by path
+    bool m_statusValid = false;
+    QByteArray m_repoStamp;                         ///< repoStamp() when m_statusCache was computed
+    QSet<QString> m_indexPaths;                     ///< Paths staged or unstaged here since then
+
+    QFuture<void> m_statusFuture;                   ///< Scan started by loadStatus()
+    std::shared_ptr<std::atomic<bool>> m_statusCancelled;
+    std::atomic<quint64> m_statusGeneration { 0 };  ///< Batches of older scans are dropped
 };
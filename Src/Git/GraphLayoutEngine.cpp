@@ -0,0 +1,281 @@
+#include "GraphLayoutEngine.h"
+
+#include <algorithm>
+
+GraphLayoutEngine::GraphLayoutEngine(QObject *parent)
+    : QObject{parent}
+{}
+
+GraphLayout GraphLayoutEngine::compute(const CommitTable &table, const QVector<int> &rows)
+{
+    GraphLayoutEngine engine;
+    engine.append(table, rows);
+    return engine.m_layout;
+}
+
+CommitHistoryModel *GraphLayoutEngine::model() const
+{
+    return m_model;
+}
+
+void GraphLayoutEngine::setModel(CommitHistoryModel *model)
+{
+    if (m_model == model)
+        return;
+
+    if (m_model)
+        disconnect(m_model, nullptr, this, nullptr);
+
+    m_model = model;
+    m_stale = true;
+
+    if (m_model) {
+        // Only rows added at the bottom keep the rows above (and the open lanes) valid
+        auto invalidate = [this]() { m_stale = true; };
+        connect(m_model, &QAbstractItemModel::rowsAboutToBeInserted, this,
+                [this](const QModelIndex &, int first, int) {
+            if (first < m_model->rowCount())
+                m_stale = true;
+        });
+        connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, invalidate);
+        connect(m_model, &QAbstractItemModel::rowsAboutToBeMoved, this, invalidate);
+        connect(m_model, &QAbstractItemModel::modelAboutToBeReset, this, invalidate);
+        connect(m_model, &QAbstractItemModel::layoutAboutToBeChanged, this, invalidate);
+    }
+
+    emit modelChanged();
+}
+
+void GraphLayoutEngine::append(const CommitTable &table, const QVector<int> &rows)
+{
+    if (m_displayRows.size() < table.count())
+        m_displayRows.resize(table.count(), -1);
+
+    m_layout.lanes.reserve(rows.size());
+    m_layout.colorRows.reserve(rows.size());
+    for (int row = m_layout.lanes.size(); row < rows.size(); ++row)
+        layoutRow(table, row, rows.at(row));
+
+    m_layout.laneCount = m_freeLanes.size();
+
+    // Lanes reserved by a first parent still run on below the last row
+    m_layout.openRows.clear();
+    for (const PendingCommit &pending : std::as_const(m_pending)) {
+        for (const auto &child : pending.children) {
+            if (child.second == 0)
+                m_layout.openRows.append(child.first);
+        }
+    }
+    std::sort(m_layout.openRows.begin(), m_layout.openRows.end());
+}
+
+void GraphLayoutEngine::clear()
+{
+    m_layout = GraphLayout();
+    m_edgeOffsets.clear();
+    m_rowFlags.clear();
+    m_displayRows.clear();
+    m_lastTableRow = -1;
+    m_lastOid = {};
+
+    m_freeLanes.clear();
+    m_laneSegments.clear();
+    m_freeLaneQueue = {};
+    m_pending.clear();
+}
+
+const GraphLayout &GraphLayoutEngine::result() const
+{
+    return m_layout;
+}
+
+QVariantMap GraphLayoutEngine::layout(int first)
+{
+    sync();
+
+    const int count = m_layout.lanes.size();
+    const int from = m_restarted ? 0 : qBound(0, first, count);
+    const int firstEdge = from < count ? m_edgeOffsets.at(from) : m_layout.edges.size();
+    m_restarted = false;
+
+    QVariantMap map;
+    map["first"] = from;
+    map["lanes"] = QVariant::fromValue(m_layout.lanes.mid(from));
+    map["colorRows"] = QVariant::fromValue(m_layout.colorRows.mid(from));
+    map["edges"] = QVariant::fromValue(m_layout.edges.mid(firstEdge));
+    map["openRows"] = QVariant::fromValue(m_layout.openRows);
+    map["laneCount"] = m_layout.laneCount;
+    return map;
+}
+
+void GraphLayoutEngine::sync()
+{
+    const CommitTable *table = m_model ? m_model->table() : nullptr;
+    if (!table) {
+        if (!m_layout.lanes.isEmpty()) {
+            m_restarted = true;
+            clear();
+            emit layoutUpdated();
+        }
+        m_table = nullptr;
+        return;
+    }
+
+    // Commits prepended to the table shift its rows even when none of them is shown
+    const QVector<int> &rows = m_model->tableRows();
+    const int done = m_layout.lanes.size();
+    const bool moved = done > 0
+                       && (rows.size() < done || rows.at(done - 1) != m_lastTableRow
+                           || m_lastTableRow >= table->count() || table->oid(m_lastTableRow) != m_lastOid);
+
+    bool restarted = false;
+    if (m_stale || table != m_table || moved) {
+        restarted = done > 0;
+        m_restarted = m_restarted || restarted;
+        clear();
+        m_table = table;
+        m_stale = false;
+    }
+
+    append(*table, rows);
+
+    if (restarted || m_layout.lanes.size() != done)
+        emit layoutUpdated();
+}
+
+void GraphLayoutEngine::layoutRow(const CommitTable &table, int row, int tableRow)
+{
+    m_edgeOffsets.append(m_layout.edges.size());
+
+    // Commits skipped since the previous row are filtered out: lanes waiting for them are done
+    for (int hidden = m_lastTableRow + 1; hidden < tableRow; ++hidden) {
+        const auto it = m_pending.constFind(table.oid(hidden));
+        if (it != m_pending.constEnd()) {
+            for (int lane : it.value().lanes)
+                releaseLane(lane);
+            m_pending.erase(it);
+        }
+    }
+
+    const git_oid &oid = table.oid(tableRow);
+    m_displayRows[tableRow] = row;
+    m_lastTableRow = tableRow;
+    m_lastOid = oid;
+
+    // The lowest lane a child reserved, otherwise the lowest free one
+    const PendingCommit waiting = m_pending.take(oid);
+    int lane = -1;
+    int colorRow = row;
+    if (waiting.lanes.isEmpty()) {
+        lane = claimLane();
+    } else {
+        lane = *std::min_element(waiting.lanes.cbegin(), waiting.lanes.cend());
+        if (m_laneSegments.at(lane) >= 0)
+            colorRow = m_laneSegments.at(lane);
+    }
+
+    const int parentCount = table.parentCount(tableRow);
+    m_layout.lanes.append(lane);
+    m_layout.colorRows.append(colorRow);
+    m_rowFlags.append(parentCount > 1 ? MergeRow : 0);
+
+    for (const auto &child : waiting.children)
+        addEdge(child.first, row);
+
+    // Parents walked before this row are either shown above or filtered out
+    auto shownAbove = [&](int index, bool *known) {
+        const int parentRow = table.parentRow(tableRow, index);
+        *known = parentRow >= 0 && parentRow < tableRow;
+        return *known ? m_displayRows.at(parentRow) : -1;
+    };
+
+    // First parent continues in this lane; one shown above only ends it after the merged parents
+    bool continues = false;
+    bool settled = false;
+    if (parentCount > 0) {
+        bool known = false;
+        const int parent = shownAbove(0, &known);
+        if (known) {
+            if (parent >= 0) {
+                addEdge(row, parent);
+                settled = true;
+            }
+        } else {
+            PendingCommit &pending = m_pending[table.parentOid(tableRow, 0)];
+            pending.lanes.append(lane);
+            pending.children.append(qMakePair(row, 0));
+            m_laneSegments[lane] = colorRow;
+            continues = true;
+        }
+    }
+    if (!continues && !settled)
+        releaseLane(lane);
+
+    // Merged parents: keep the lane they already have, or take a free one
+    for (int index = 1; index < parentCount; ++index) {
+        bool known = false;
+        const int parent = shownAbove(index, &known);
+        if (known) {
+            if (parent >= 0)
+                addEdge(row, parent);
+            continue;
+        }
+
+        PendingCommit &pending = m_pending[table.parentOid(tableRow, index)];
+        pending.children.append(qMakePair(row, index));
+        if (pending.lanes.isEmpty()) {
+            const int mergedLane = claimLane();
+            m_laneSegments[mergedLane] = -1;
+            pending.lanes.append(mergedLane);
+        }
+    }
+
+    // Other lanes that were waiting for this commit are done
+    for (int other : waiting.lanes) {
+        if (other != lane)
+            releaseLane(other);
+    }
+    if (settled)
+        releaseLane(lane);
+}
+
+void GraphLayoutEngine::addEdge(int child, int parent)
+{
+    quint8 &flags = m_rowFlags[child];
+
+    int kind = (flags & MergeRow) ? MergeEdge : ForkEdge;
+    if (m_layout.lanes.at(child) == m_layout.lanes.at(parent)) {
+        // One straight line per child is enough
+        if (flags & HasStraightEdge)
+            return;
+        flags |= HasStraightEdge;
+        kind = StraightEdge;
+    }
+
+    m_layout.edges << child << parent << kind;
+}
+
+int GraphLayoutEngine::claimLane()
+{
+    while (!m_freeLaneQueue.empty()) {
+        const int lane = m_freeLaneQueue.top();
+        m_freeLaneQueue.pop();
+        if (m_freeLanes.at(lane)) {
+            m_freeLanes[lane] = false;
+            return lane;
+        }
+    }
+
+    m_freeLanes.append(false);
+    m_laneSegments.append(-1);
+    return int(m_freeLanes.size()) - 1;
+}
+
+void GraphLayoutEngine::releaseLane(int lane)
+{
+    if (m_freeLanes.at(lane))
+        return;
+
+    m_freeLanes[lane] = true;
+    m_freeLaneQueue.push(lane);
+}
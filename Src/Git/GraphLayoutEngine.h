@@ -0,0 +1,146 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QVarLengthArray>
+#include <QVariantMap>
+#include <QVector>
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "CommitHistoryModel.h"
+#include "CommitTable.h"
+#include "OidHash.h"
+
+/**
+ * \brief Lane assignment of the commit graph, as packed arrays indexed by display row
+ */
+struct GraphLayout
+{
+    QVector<int> lanes;         ///< Lane of each row
+    QVector<int> colorRows;     ///< Row that starts the color segment of each row
+    QVector<int> edges;         ///< (child row, parent row, GraphLayoutEngine::EdgeKind) triples
+    QVector<int> openRows;      ///< Rows whose lane runs on to a parent that is not shown yet
+    int laneCount = 0;
+};
+
+/**
+ * \brief Assigns commits to graph lanes (columns), one page at a time
+ *
+ * Rows are walked top to bottom. A commit takes the lowest lane that
+ * expects it (a child reserved the lane for it), otherwise the lowest free
+ * lane. Its first parent continues in the same lane; other parents not
+ * expected anywhere yet get the lowest free lane.
+ *
+ * The open lanes at the bottom of the laid out rows are kept, keyed by the
+ * commit they wait for, so a page appended to the model is laid out on its
+ * own: O(page) whatever the depth, and rows above never move. A lane waiting
+ * for a parent that is not loaded yet stays reserved until the parent shows
+ * up or turns out to be filtered out. Rows inserted anywhere else, resets
+ * and a change of table start over.
+ */
+class GraphLayoutEngine : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(CommitHistoryModel* model READ model WRITE setModel NOTIFY modelChanged FINAL)
+
+public:
+    /**
+     * \brief How an edge from a commit to one of its parents is drawn
+     */
+    enum EdgeKind {
+        StraightEdge = 0,   ///< Parent in the same lane, straight line
+        ForkEdge = 1,       ///< Parent in another lane, curve from the child to the parent
+        MergeEdge = 2       ///< Merged parent in another lane, curve from the parent to the merge
+    };
+    Q_ENUM(EdgeKind)
+
+    explicit GraphLayoutEngine(QObject *parent = nullptr);
+
+    /**
+     * \brief Lay out rows of a commit table in one go
+     * \param table Table holding the commits
+     * \param rows Table row of each display row, children before parents
+     */
+    static GraphLayout compute(const CommitTable &table, const QVector<int> &rows);
+
+    CommitHistoryModel *model() const;
+    void setModel(CommitHistoryModel *model);
+
+    /**
+     * \brief Lay out the rows after the ones already laid out
+     * \param rows Table row of each display row; rows laid out before must be unchanged
+     */
+    void append(const CommitTable &table, const QVector<int> &rows);
+
+    /**
+     * \brief Forget all rows
+     */
+    void clear();
+
+    /**
+     * \brief Layout of all rows laid out so far
+     */
+    const GraphLayout &result() const;
+
+    /**
+     * \brief Bring the layout up to date with the model and return the rows from first on
+     * \return {first, lanes, colorRows, edges, openRows, laneCount}. lanes and colorRows
+     * start at row first, edges are the ones added since; openRows and laneCount cover
+     * all rows. first is 0 when the layout had to start over.
+     */
+    Q_INVOKABLE QVariantMap layout(int first);
+
+signals:
+    void modelChanged();
+
+    /**
+     * \brief Rows were laid out, or the layout started over
+     */
+    void layoutUpdated();
+
+private:
+    /**
+     * \brief Lanes and children waiting for a commit that is not laid out yet
+     */
+    struct PendingCommit
+    {
+        QVarLengthArray<int, 2> lanes;
+        QVarLengthArray<QPair<int, int>, 2> children;   ///< (child row, parent index)
+    };
+
+    enum RowFlag : quint8 {
+        MergeRow = 1,
+        HasStraightEdge = 2
+    };
+
+    void sync();
+    void layoutRow(const CommitTable &table, int row, int tableRow);
+    void addEdge(int child, int parent);
+    int claimLane();
+    void releaseLane(int lane);
+
+    QPointer<CommitHistoryModel> m_model;
+    const CommitTable *m_table = nullptr;
+    bool m_stale = true;                    ///< Rows changed other than by appending
+    bool m_restarted = false;               ///< Started over since the last layout() call
+
+    GraphLayout m_layout;
+    QVector<int> m_edgeOffsets;             ///< Row -> first edge added while laying it out
+    QVector<quint8> m_rowFlags;
+    QVector<int> m_displayRows;             ///< Table row -> display row, -1 if not shown
+    int m_lastTableRow = -1;
+    git_oid m_lastOid = {};
+
+    QVector<bool> m_freeLanes;
+    QVector<int> m_laneSegments;            ///< Lane -> color row it continues, -1 for a new segment
+    std::priority_queue<int, std::vector<int>, std::greater<int>> m_freeLaneQueue;
+    QHash<git_oid, PendingCommit> m_pending;
+};
@@ -0,0 +1,611 @@
+#include "HistoryLoader.h"
+#include "CommitDecoder.h"
+#include "CommitGraph.h"
+#include "PathFilter.h"
+#include "HistorySession.h"
+
+#include <git2/commit.h>
+#include <git2/errors.h>
+#include <git2/graph.h>
+#include <git2/repository.h>
+#include <git2/revwalk.h>
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
+
+namespace {
+// Flush decoded commits at least this often, so rows show up within a frame
+constexpr qint64 FlushIntervalMs = 8;
+constexpr int MaxBatchSize = 256;
+
+// Commits older than the time window in a row before the walk stops; allows
+// for parents committed with a clock behind their children's (as git's SLOP)
+constexpr int TimeWindowSlop = 5;
+
+// Ids handed to the decoder at once: small first, so the first rows arrive quickly
+constexpr int FirstDecodeBlock = 64;
+constexpr int MaxDecodeBlock = 1024;
+
+// Loaded history is written to the cache once loading settles
+constexpr int CacheSaveDelayMs = 2000;
+}
+
+/**
+ * \brief Worker side of the loader: only touched from the running task
+ */
+struct HistoryLoader::WalkState
+{
+    ~WalkState()
+    {
+        session.reset();
+        if (repo)
+            git_repository_free(repo);
+    }
+
+    QString repoPath;
+    QString cachePath;
+    git_repository *repo = nullptr;
+    std::unique_ptr<HistorySession> session;
+    std::unique_ptr<CommitDecoder> decoder;
+    CommitGraphReader graph;            ///< Commit dates without inflating objects
+    HistoryQuery query;                 ///< Only commits matching this query, if not empty
+    int olderInARow = 0;                ///< Commits older than the time window seen in a row
+    bool pastWindow = false;            ///< No remaining commit can be in the time window
+    bool cachedExhausted = false;       ///< The cached walk already reached the root commits
+    std::atomic<bool> cancelled { false };
+};
+
+HistoryLoader::HistoryLoader(CommitTable *table, QObject *parent)
+    : QObject{parent},
+      m_table(table)
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(CacheSaveDelayMs);
+    connect(&m_saveTimer, &QTimer::timeout, this, [this]() {
+        if (isLoading())
+            m_saveTimer.start();
+        else
+            saveCache();
+    });
+}
+
+HistoryLoader::~HistoryLoader()
+{
+    cancel();
+
+    // Flush synchronously, the application may be shutting down
+    CommitCacheState state;
+    const QByteArray snapshot = takeCacheSnapshot(state);
+    m_saveFuture.waitForFinished();
+    if (!snapshot.isEmpty())
+        CommitCache::write(CommitCache::pathFor(m_repoPath), state, snapshot);
+}
+
+void HistoryLoader::setRepositoryPath(const QString &repoPath)
+{
+    if (repoPath == m_repoPath)
+        return;
+
+    cancel();
+    saveCache();
+
+    m_state.reset();
+    m_repoPath = repoPath;
+    m_table->clear();
+}
+
+bool HistoryQuery::operator==(const HistoryQuery &other) const
+{
+    return path.path() == other.path.path()
+           && hasSince == other.hasSince && (!hasSince || since == other.since)
+           && hasUntil == other.hasUntil && (!hasUntil || until == other.until);
+}
+
+void HistoryLoader::setQuery(const HistoryQuery &query)
+{
+    if (query == m_query)
+        return;
+
+    cancel();
+    m_state.reset();
+    m_cacheState = CommitCacheState();
+    m_query = query;
+    m_table->clear();
+}
+
+const HistoryQuery &HistoryLoader::query() const
+{
+    return m_query;
+}
+
+QString HistoryLoader::repositoryPath() const
+{
+    return m_repoPath;
+}
+
+bool HistoryLoader::isLoading() const
+{
+    return m_requestCount > 0;
+}
+
+void HistoryLoader::cancel()
+{
+    // Drop batches still queued for the GUI thread
+    m_generation++;
+
+    if (m_state)
+        m_state->cancelled = true;
+
+    m_future.waitForFinished();
+    m_requestCount = 0;
+}
+
+bool HistoryLoader::load(const QString &cursor, int limit)
+{
+    if (m_repoPath.isEmpty() || limit <= 0)
+        return false;
+
+    // Rows loaded so far are handed to the worker, which caches them before reading the cache back
+    CommitCacheState snapshotState;
+    QByteArray snapshot;
+
+    if (cursor.isEmpty()) {
+        cancel();
+        snapshot = takeCacheSnapshot(snapshotState);
+        m_table->clear();
+    } else if (isLoading()) {
+        return false;
+    }
+
+    if (!m_state) {
+        m_state = std::make_shared<WalkState>();
+        m_state->repoPath = m_repoPath;
+        m_state->cachePath = CommitCache::pathFor(m_repoPath);
+        m_state->query = m_query;
+    }
+    m_state->cancelled = false;
+
+    const quint64 generation = m_generation;
+    std::shared_ptr<WalkState> state = m_state;
+    QThread *guiThread = thread();
+    m_requestCount++;
+
+    m_future = QtConcurrent::run([this, state, generation, cursor, limit, snapshot, snapshotState, guiThread]() {
+        QVariantMap result;
+        CommitCacheState cacheState;
+
+        if (!state->repo) {
+            if (git_repository_open(&state->repo, state->repoPath.toUtf8().constData()) != GIT_OK) {
+                state->repo = nullptr;
+                result["success"] = false;
+                result["error"] = "Failed to open repository";
+                deliverFinished(generation, result, cacheState, false);
+                return;
+            }
+            CommitGraph::attach(state->repo);
+            if (state->query.hasTimeWindow())
+                state->graph.open(CommitGraph::objectsDir(state->repo));
+            state->decoder = std::make_unique<CommitDecoder>(state->repoPath);
+        }
+
+        if (cursor.isEmpty()) {
+            state->session.reset();
+            state->cachedExhausted = false;
+            state->olderInARow = 0;
+            state->pastWindow = false;
+
+            if (!snapshot.isEmpty())
+                CommitCache::write(state->cachePath, snapshotState, snapshot);
+
+            // Warm start: serve the cached rows, then put what was committed since in front of them
+            CommitCache cache;
+            QVector<git_oid> freshCommits;
+            if (state->query.isEmpty() && cache.open(state->cachePath)
+                && resumeFromCache(*state, cache, freshCommits)) {
+                auto table = std::make_shared<CommitTable>();
+                if (table->deserialize(cache.tableData(), cache.tableSize())) {
+                    if (state->cancelled)
+                        return;
+
+                    const int cachedCount = table->count();
+
+                    // The GUI thread takes the rows over and releases the table
+                    table->moveToThread(guiThread);
+                    deliverTable(generation, table);
+
+                    int freshCount = 0;
+                    if (!prependNewCommits(*state, generation, freshCommits, freshCount))
+                        return;
+
+                    result["success"] = true;
+                    result["count"] = cachedCount + freshCount;
+                    result["cached"] = true;
+                    result["cursor"] = state->session->cursor();
+                    result["hasMore"] = !state->cachedExhausted;
+
+                    cacheState.refTips = state->session->tips();
+                    cacheState.walkTips = state->session->walkTips();
+                    cacheState.walkPosition = state->session->position();
+                    cacheState.exhausted = state->cachedExhausted;
+
+                    deliverFinished(generation, result, cacheState, freshCount > 0);
+                    return;
+                }
+                state->session.reset();
+            }
+
+            state->session = std::make_unique<HistorySession>(state->repo);
+
+            // Date order lets the walk stop behind the window; topological order would read all history first
+            if (state->query.hasTimeWindow())
+                state->session->setSorting(GIT_SORT_TIME);
+        } else {
+            quint64 sessionId = 0;
+            int position = 0;
+            bool expired = !HistorySession::parseCursor(cursor, sessionId, position)
+                           || !state->session
+                           || state->session->id() != sessionId
+                           || state->session->position() != position
+                           || state->session->isStale(state->repo);
+
+            if (expired) {
+                state->session.reset();
+                result["success"] = false;
+                result["expired"] = true;
+                result["error"] = "History changed, the cursor is no longer valid.";
+                deliverFinished(generation, result, cacheState, false);
+                return;
+            }
+        }
+
+        if (!state->session->isValid()) {
+            state->session.reset();
+            result["success"] = false;
+            result["error"] = "Failed to create revwalk.";
+            deliverFinished(generation, result, cacheState, false);
+            return;
+        }
+
+        // Pipeline: this thread walks the next block of ids while the
+        // decoder inflates the previous one on the other cores
+        QVector<CommitRecord> batch;
+        QElapsedTimer sinceFlush;
+        sinceFlush.start();
+
+        QFuture<QVector<CommitRecord>> decoding;
+        bool decodingBlock = false;
+        QVector<git_oid> block;
+        int blockSize = FirstDecodeBlock;
+        int count = 0;
+        QElapsedTimer sinceBlock;
+
+        auto collectDecoded = [&]() {
+            if (!decodingBlock)
+                return;
+
+            batch += CommitDecoder::take(decoding);
+            decodingBlock = false;
+
+            if (batch.size() >= MaxBatchSize || sinceFlush.elapsed() >= FlushIntervalMs) {
+                deliverBatch(generation, batch);
+                batch.clear();
+                sinceFlush.restart();
+            }
+        };
+
+        git_oid oid;
+        while (count < limit && !state->cancelled) {
+            block.clear();
+            sinceBlock.start();
+            while (block.size() < blockSize && count < limit && !state->cancelled
+                   && !state->pastWindow && state->session->next(&oid)) {
+                // Queries: most commits are dropped here, without being decoded
+                if (!accepts(*state, oid)) {
+                    if (sinceBlock.elapsed() >= FlushIntervalMs) {
+                        // Sparse matches: show what was found instead of waiting for a full block
+                        if (!block.isEmpty())
+                            break;
+                        collectDecoded();
+                    }
+                    continue;
+                }
+
+                block.append(oid);
+                count++;
+            }
+
+            collectDecoded();
+            if (block.isEmpty())
+                break;
+
+            decoding = state->decoder->decodeAsync(block);
+            decodingBlock = true;
+            blockSize = qMin(blockSize * 2, MaxDecodeBlock);
+        }
+        collectDecoded();
+
+        if (state->cancelled) {
+            // Positions of a cancelled walk no longer match any cursor
+            state->session.reset();
+            return;
+        }
+
+        if (!batch.isEmpty())
+            deliverBatch(generation, batch);
+
+        result["success"] = true;
+        result["count"] = count;
+        result["cursor"] = state->session->cursor();
+        result["hasMore"] = !state->session->isExhausted() && !state->pastWindow && count == limit;
+
+        cacheState.refTips = state->session->tips();
+        cacheState.walkTips = state->session->walkTips();
+        cacheState.walkPosition = state->session->position();
+        cacheState.exhausted = state->session->isExhausted();
+
+        deliverFinished(generation, result, cacheState, count > 0);
+    });
+
+    return true;
+}
+
+bool HistoryLoader::refresh()
+{
+    // Only a table matching the last finished walk can be extended; new
+    // commits are not necessarily newer than a time window, reload instead
+    if (m_repoPath.isEmpty() || isLoading() || !m_state || m_query.hasTimeWindow()
+        || !m_cacheState.isValid() || m_table->count() != m_cacheState.rowCount)
+        return false;
+
+    const quint64 generation = m_generation;
+    std::shared_ptr<WalkState> state = m_state;
+    const QList<RefTip> previous = m_cacheState.refTips;
+    state->cancelled = false;
+    m_requestCount++;
+
+    m_future = QtConcurrent::run([this, state, generation, previous]() {
+        QVariantMap result;
+        CommitCacheState cacheState;
+
+        if (!state->repo || !state->session || !state->session->isValid()) {
+            result["success"] = false;
+            result["expired"] = true;
+            result["error"] = "History changed, the cursor is no longer valid.";
+            deliverFinished(generation, result, cacheState, false);
+            return;
+        }
+
+        const QList<RefTip> current = HistorySession::readRefTips(state->repo);
+        int freshCount = 0;
+
+        if (current != previous) {
+            if (!HistorySession::containsHistory(state->repo, current, previous)) {
+                result["success"] = false;
+                result["expired"] = true;
+                result["error"] = "History was rewritten, it must be reloaded.";
+                deliverFinished(generation, result, cacheState, false);
+                return;
+            }
+
+            QVector<git_oid> freshCommits;
+            if (!walkNewCommits(*state, current, previous, freshCommits)) {
+                if (state->cancelled)
+                    return;
+
+                result["success"] = false;
+                result["error"] = "Failed to create revwalk.";
+                deliverFinished(generation, result, cacheState, false);
+                return;
+            }
+
+            if (!prependNewCommits(*state, generation, freshCommits, freshCount))
+                return;
+
+            // The running walk continues behind the new rows
+            state->session->setTips(current);
+        }
+
+        const bool exhausted = state->session->isExhausted() || state->cachedExhausted;
+
+        result["success"] = true;
+        result["refreshed"] = true;
+        result["count"] = freshCount;
+        result["cursor"] = state->session->cursor();
+        result["hasMore"] = !exhausted;
+
+        cacheState.refTips = current;
+        cacheState.walkTips = state->session->walkTips();
+        cacheState.walkPosition = state->session->position();
+        cacheState.exhausted = exhausted;
+
+        deliverFinished(generation, result, cacheState, freshCount > 0);
+    });
+
+    return true;
+}
+
+bool HistoryLoader::accepts(WalkState &state, const git_oid &oid)
+{
+    const HistoryQuery &query = state.query;
+
+    if (query.hasTimeWindow()) {
+        // Most commits of a windowed walk are outside the window: read their date from the
+        // commit-graph, only commits written after the graph are inflated
+        qint64 time = 0;
+        if (!state.graph.lookup(oid, time)) {
+            git_commit *gitCommit = nullptr;
+            if (git_commit_lookup(&gitCommit, state.repo, &oid) != GIT_OK)
+                return false;
+
+            time = git_commit_time(gitCommit);
+            git_commit_free(gitCommit);
+        }
+
+        if (query.hasUntil && time > query.until)
+            return false;
+
+        if (query.hasSince && time < query.since) {
+            // The walk pops commits newest first: once it is behind the window it stays there
+            if (++state.olderInARow >= TimeWindowSlop)
+                state.pastWindow = true;
+            return false;
+        }
+
+        state.olderInARow = 0;
+    }
+
+    return query.path.touches(state.repo, oid);
+}
+
+bool HistoryLoader::resumeFromCache(WalkState &state, const CommitCache &cache,
+                                    QVector<git_oid> &freshCommits)
+{
+    const CommitCacheState &cached = cache.state();
+    if (!cached.isValid())
+        return false;
+
+    const QList<RefTip> current = HistorySession::readRefTips(state.repo);
+    if (!HistorySession::containsHistory(state.repo, current, cached.refTips))
+        return false;
+
+    state.session = std::make_unique<HistorySession>(state.repo, cached.walkTips);
+    if (!state.session->isValid())
+        return false;
+
+    state.session->skipLazily(cached.walkPosition);
+    state.cachedExhausted = cached.exhausted;
+
+    return walkNewCommits(state, current, cached.refTips, freshCommits);
+}
+
+bool HistoryLoader::walkNewCommits(WalkState &state, const QList<RefTip> &current,
+                                   const QList<RefTip> &previous, QVector<git_oid> &out)
+{
+    // Commits reachable from the current refs but not from the previous ones
+    git_revwalk *walker = nullptr;
+    if (git_revwalk_new(&walker, state.repo) != GIT_OK)
+        return false;
+
+    git_revwalk_sorting(walker, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME);
+    for (const RefTip &tip : current)
+        git_revwalk_push(walker, &tip.oid);
+    for (const RefTip &tip : previous)
+        git_revwalk_hide(walker, &tip.oid);
+
+    git_oid oid;
+    while (!state.cancelled && git_revwalk_next(&oid, walker) == GIT_OK) {
+        if (state.query.path.touches(state.repo, oid))
+            out.append(oid);
+    }
+
+    git_revwalk_free(walker);
+
+    return !state.cancelled;
+}
+
+bool HistoryLoader::prependNewCommits(WalkState &state, quint64 generation,
+                                      const QVector<git_oid> &oids, int &count)
+{
+    // Oldest block first: a block only goes in front of rows it descends from, as prepend() expects
+    count = 0;
+    for (qsizetype end = oids.size(); end > 0;) {
+        if (state.cancelled)
+            return false;
+
+        const qsizetype begin = qMax(qsizetype(0), end - MaxDecodeBlock);
+        const QVector<CommitRecord> records = state.decoder->decode(oids.mid(begin, end - begin));
+        if (!records.isEmpty())
+            deliverPrepend(generation, records);
+
+        count += records.size();
+        end = begin;
+    }
+
+    return !state.cancelled;
+}
+
+QByteArray HistoryLoader::takeCacheSnapshot(CommitCacheState &state)
+{
+    // Rows of a request that did not finish are not described by the walk state
+    if (!m_cacheDirty || m_repoPath.isEmpty() || !m_query.isEmpty()
+        || m_table->count() != m_cacheState.rowCount)
+        return QByteArray();
+
+    m_cacheDirty = false;
+    m_saveTimer.stop();
+    state = m_cacheState;
+    return m_table->serialize();
+}
+
+void HistoryLoader::saveCache()
+{
+    CommitCacheState state;
+    const QByteArray snapshot = takeCacheSnapshot(state);
+    if (snapshot.isEmpty())
+        return;
+
+    const QString path = CommitCache::pathFor(m_repoPath);
+    m_saveFuture.waitForFinished();
+    m_saveFuture = QtConcurrent::run([path, state, snapshot]() {
+        CommitCache::write(path, state, snapshot);
+    });
+}
+
+void HistoryLoader::deliverBatch(quint64 generation, const QVector<CommitRecord> &records)
+{
+    QMetaObject::invokeMethod(this, [this, generation, records]() {
+        if (generation != m_generation)
+            return;
+
+        const int firstRow = m_table->count();
+        m_table->reserve(records.size());
+        for (const CommitRecord &record : records)
+            m_table->append(record);
+
+        emit batchLoaded(firstRow, m_table->count() - firstRow);
+    }, Qt::QueuedConnection);
+}
+
+void HistoryLoader::deliverPrepend(quint64 generation, const QVector<CommitRecord> &records)
+{
+    QMetaObject::invokeMethod(this, [this, generation, records]() {
+        if (generation != m_generation)
+            return;
+
+        m_table->prepend(records);
+    }, Qt::QueuedConnection);
+}
+
+void HistoryLoader::deliverTable(quint64 generation, const std::shared_ptr<CommitTable> &table)
+{
+    QMetaObject::invokeMethod(this, [this, generation, table]() {
+        if (generation != m_generation)
+            return;
+
+        m_table->swap(*table);
+        emit batchLoaded(0, m_table->count());
+    }, Qt::QueuedConnection);
+}
+
+void HistoryLoader::deliverFinished(quint64 generation, const QVariantMap &result,
+                                    const CommitCacheState &cacheState, bool rowsAdded)
+{
+    QMetaObject::invokeMethod(this, [this, generation, result, cacheState, rowsAdded]() {
+        if (generation != m_generation)
+            return;
+
+        m_requestCount--;
+
+        if (result.value("success").toBool()) {
+            m_cacheState = cacheState;
+            m_cacheState.rowCount = m_table->count();
+            if (rowsAdded) {
+                m_cacheDirty = true;
+                m_saveTimer.start();
+            }
+        }
+
+        emit finished(result);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "CommitCache.h"
+#include "CommitTable.h"
+#include "PathFilter.h"
+
+/**
+ * \brief Restricts the commits a HistoryLoader produces
+ */
+struct HistoryQuery
+{
+    PathFilter path;            ///< Only commits changing this path, if not empty
+    qint64 since = 0;           ///< Oldest commit time to include (seconds since epoch), if hasSince
+    qint64 until = 0;           ///< Newest commit time to include, if hasUntil
+    bool hasSince = false;
+    bool hasUntil = false;
+
+    bool isEmpty() const { return path.isEmpty() && !hasTimeWindow(); }
+    bool hasTimeWindow() const { return hasSince || hasUntil; }
+
+    bool operator==(const HistoryQuery &other) const;
+    bool operator!=(const HistoryQuery &other) const { return !(*this == other); }
+};
+
+/**
+ * \brief Streams commit history into a CommitTable from a worker thread
+ *
+ * The walk runs on a thread pool thread with its own git_repository handle,
+ * so the GUI thread never blocks on libgit2. Decoded commits are delivered
+ * in small batches: the first one after a few milliseconds, so the first
+ * rows can be painted immediately, the rest as the walk continues.
+ * Commit objects are decoded by a CommitDecoder on the other cores while
+ * the walk moves on to the next block of ids.
+ *
+ * The walk is kept alive between requests (see HistorySession) and resumed
+ * from the cursor returned by the previous request. Changing the repository
+ * or starting a fresh load cancels the running walk; batches of a cancelled
+ * request are dropped.
+ *
+ * Loaded history is persisted in a CommitCache. A fresh load first tries
+ * the cache: if every cached ref tip still exists and only moved forward,
+ * the cached rows are delivered first, as they are, and the commits added
+ * since are then decoded and put in front of them block by block
+ * (CommitTable::rowsPrepended()). Further requests resume the cached walk
+ * where it stopped.
+ *
+ * refresh() applies the same idea to the loaded table after refs moved:
+ * only commits reachable from the new tips but not from the tips the rows
+ * were loaded for are walked, and spliced onto the front of the table.
+ */
+class HistoryLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HistoryLoader(CommitTable *table, QObject *parent = nullptr);
+    ~HistoryLoader();
+
+    /**
+     * \brief Switch to another repository, cancelling any running walk
+     *
+     * The history of the previous repository is saved to its cache first.
+     *
+     * \param repoPath Path of the repository, or empty to unload
+     */
+    void setRepositoryPath(const QString &repoPath);
+
+    QString repositoryPath() const;
+
+    /**
+     * \brief Only load commits matching a query (git log --since --until -- path)
+     *
+     * Path-limited history keeps the commits that changed the path (see
+     * PathFilter). A time window compares committer dates, like git log,
+     * and walks by commit date only (no topological order), so the walk can
+     * skip everything newer than the window and stop once it is past the
+     * window. Dates of skipped commits come from the commit-graph
+     * (CommitGraphReader); only commits missing from it are inflated.
+     *
+     * Cancels the running walk and clears the table. Query results are
+     * never cached.
+     *
+     * \param query Query, empty for all commits
+     */
+    void setQuery(const HistoryQuery &query);
+
+    const HistoryQuery &query() const;
+
+    /**
+     * \brief Whether a request is currently running
+     */
+    bool isLoading() const;
+
+    /**
+     * \brief Start loading the next commits
+     *
+     * An empty cursor clears the table and restarts from the current ref
+     * tips (or the cache), cancelling a running request. A non-empty cursor
+     * must be the one reported by the previous finished() signal.
+     *
+     * \param cursor Cursor of the previous request, or empty
+     * \param limit Maximum number of commits to load
+     * \return false if a request is already running for a non-empty cursor
+     */
+    bool load(const QString &cursor, int limit);
+
+    /**
+     * \brief Put commits added since the last request in front of the loaded rows
+     *
+     * Walks the current ref tips, hiding the tips the table was loaded for,
+     * and prepends the commits found (CommitTable::rowsPrepended()). The
+     * running walk and its cursor stay valid. finished() reports
+     * {success, refreshed, count, cursor, hasMore}, or {success: false,
+     * expired} if previously loaded commits are no longer reachable (e.g.
+     * after a force push or reset) and history must be reloaded.
+     *
+     * \return false if nothing was loaded yet, a request is running or the
+     *         query has a time window
+     */
+    bool refresh();
+
+    /**
+     * \brief Cancel the running request, if any, and wait for the worker to stop
+     */
+    void cancel();
+
+signals:
+    /**
+     * \brief Rows [firstRow, firstRow + count) were appended to the table
+     */
+    void batchLoaded(int firstRow, int count);
+
+    /**
+     * \brief A request finished
+     * \param result {success, count, cursor, hasMore, cached} or {success: false, expired, error}
+     */
+    void finished(QVariantMap result);
+
+private:
+    struct WalkState;
+
+    void deliverBatch(quint64 generation, const QVector<CommitRecord> &records);
+    void deliverPrepend(quint64 generation, const QVector<CommitRecord> &records);
+    void deliverTable(quint64 generation, const std::shared_ptr<CommitTable> &table);
+    void deliverFinished(quint64 generation, const QVariantMap &result,
+                         const CommitCacheState &cacheState, bool rowsAdded);
+
+    /**
+     * \brief Snapshot of the table for the cache, empty if nothing new is loaded
+     */
+    QByteArray takeCacheSnapshot(CommitCacheState &state);
+    void saveCache();
+
+    /**
+     * \brief Whether the query keeps a commit; marks the walk finished once it is past the time window
+     */
+    static bool accepts(WalkState &state, const git_oid &oid);
+
+    /**
+     * \brief Resume the cached walk and list the commits added on top of the cached rows
+     */
+    static bool resumeFromCache(WalkState &state, const CommitCache &cache,
+                                QVector<git_oid> &freshCommits);
+
+    /**
+     * \brief List the commits reachable from current but not from previous, in walk order
+     * \return false if the walk failed or was cancelled
+     */
+    static bool walkNewCommits(WalkState &state, const QList<RefTip> &current,
+                               const QList<RefTip> &previous, QVector<git_oid> &out);
+
+    /**
+     * \brief Decode new commits block by block and put each block in front of the table
+     * \param oids New commits in walk order
+     * \param count Receives the number of rows prepended
+     * \return false if the request was cancelled
+     */
+    bool prependNewCommits(WalkState &state, quint64 generation, const QVector<git_oid> &oids, int &count);
+
+    CommitTable *m_table = nullptr;
+    QString m_repoPath;
+    HistoryQuery m_query;
+    std::shared_ptr<WalkState> m_state;
+    QFuture<void> m_future;
+    std::atomic<quint64> m_generation { 0 };
+    int m_requestCount = 0;
+
+    CommitCacheState m_cacheState;          ///< Walk state at the last finished request
+    bool m_cacheDirty = false;
+    QTimer m_saveTimer;
+    QFuture<void> m_saveFuture;
+};
@@ -0,0 +1,241 @@
+#include "HistorySession.h"
+#include "Reachability.h"
+
+#include <git2/branch.h>
+#include <git2/errors.h>
+#include <git2/object.h>
+#include <git2/refs.h>
+#include <git2/repository.h>
+#include <git2/revparse.h>
+#include <git2/revwalk.h>
+
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+std::atomic<quint64> s_nextSessionId { 1 };
+}
+
+bool RefTip::operator==(const RefTip &other) const
+{
+    return name == other.name && git_oid_equal(&oid, &other.oid);
+}
+
+HistorySession::HistorySession(git_repository *repo)
+    : HistorySession(repo, readRefTips(repo))
+{}
+
+HistorySession::HistorySession(git_repository *repo, const QList<RefTip> &walkTips)
+    : m_repo(repo),
+      m_walkTips(walkTips),
+      m_id(s_nextSessionId++)
+{
+    if (!m_repo)
+        return;
+
+    if (git_revwalk_new(&m_walker, m_repo) != GIT_OK) {
+        m_walker = nullptr;
+        return;
+    }
+
+    // Sort by time (newest first)
+    git_revwalk_sorting(m_walker, GIT_SORT_TOPOLOGICAL | GIT_SORT_TIME);
+
+    // Remember the current refs so moved refs can be detected later
+    m_tips = readRefTips(m_repo);
+    for (const RefTip &tip : m_walkTips) {
+        if (git_revwalk_push(m_walker, &tip.oid) != GIT_OK) {
+            // A recorded tip no longer exists (e.g. garbage collected)
+            git_revwalk_free(m_walker);
+            m_walker = nullptr;
+            return;
+        }
+    }
+}
+
+HistorySession::~HistorySession()
+{
+    if (m_walker)
+        git_revwalk_free(m_walker);
+}
+
+bool HistorySession::isValid() const
+{
+    return m_walker != nullptr;
+}
+
+bool HistorySession::isStale(git_repository *repo) const
+{
+    if (repo != m_repo)
+        return true;
+
+    return readRefTips(repo) != m_tips;
+}
+
+bool HistorySession::isExhausted() const
+{
+    return m_exhausted;
+}
+
+quint64 HistorySession::id() const
+{
+    return m_id;
+}
+
+int HistorySession::position() const
+{
+    return m_position;
+}
+
+const QList<RefTip> &HistorySession::tips() const
+{
+    return m_tips;
+}
+
+const QList<RefTip> &HistorySession::walkTips() const
+{
+    return m_walkTips;
+}
+
+void HistorySession::setTips(const QList<RefTip> &tips)
+{
+    m_tips = tips;
+}
+
+void HistorySession::setSorting(unsigned int sortMode)
+{
+    if (m_walker)
+        git_revwalk_sorting(m_walker, sortMode);
+}
+
+bool HistorySession::next(git_oid *out)
+{
+    if (!m_walker || m_exhausted)
+        return false;
+
+    for (; m_pendingSkip > 0; --m_pendingSkip) {
+        if (git_revwalk_next(out, m_walker) != GIT_OK) {
+            m_exhausted = true;
+            return false;
+        }
+    }
+
+    if (git_revwalk_next(out, m_walker) != GIT_OK) {
+        m_exhausted = true;
+        return false;
+    }
+
+    m_position++;
+    return true;
+}
+
+int HistorySession::skip(int count)
+{
+    git_oid oid;
+    int skipped = 0;
+    while (skipped < count && next(&oid))
+        skipped++;
+
+    return skipped;
+}
+
+void HistorySession::skipLazily(int count)
+{
+    m_pendingSkip += count;
+    m_position += count;
+}
+
+QString HistorySession::cursor() const
+{
+    return QString("%1:%2").arg(m_id).arg(m_position);
+}
+
+bool HistorySession::parseCursor(const QString &cursor, quint64 &sessionId, int &position)
+{
+    const QStringList parts = cursor.split(':');
+    if (parts.size() != 2)
+        return false;
+
+    bool idOk = false;
+    bool positionOk = false;
+    sessionId = parts.at(0).toULongLong(&idOk);
+    position = parts.at(1).toInt(&positionOk);
+
+    return idOk && positionOk && position >= 0;
+}
+
+QList<RefTip> HistorySession::readRefTips(git_repository *repo)
+{
+    QList<RefTip> tips;
+
+    if (!repo)
+        return tips;
+
+    git_branch_iterator *iter = nullptr;
+    if (git_branch_iterator_new(&iter, repo, GIT_BRANCH_ALL) == GIT_OK) {
+        git_reference *ref = nullptr;
+        git_branch_t type;
+
+        while (git_branch_next(&ref, &type, iter) == GIT_OK) {
+            RefTip tip;
+            tip.name = git_reference_name(ref);
+
+            const git_oid *oid = git_reference_target(ref);
+            if (oid) {
+                git_oid_cpy(&tip.oid, oid);
+                tips.append(tip);
+            } else {
+                // If symbolic ref, peel to commit
+                git_object *target = nullptr;
+                if (git_reference_peel(&target, ref, GIT_OBJECT_COMMIT) == GIT_OK && target) {
+                    git_oid_cpy(&tip.oid, git_object_id(target));
+                    tips.append(tip);
+                    git_object_free(target);
+                }
+            }
+
+            git_reference_free(ref);
+        }
+
+        git_branch_iterator_free(iter);
+    }
+
+    std::sort(tips.begin(), tips.end(), [](const RefTip &a, const RefTip &b) {
+        return a.name < b.name;
+    });
+
+    // HEAD as fallback (detached HEAD or repos without branches)
+    git_object *head = nullptr;
+    if (git_revparse_single(&head, repo, "HEAD^{commit}") == GIT_OK && head) {
+        RefTip tip;
+        tip.name = "HEAD";
+        git_oid_cpy(&tip.oid, git_object_id(head));
+        tips.append(tip);
+        git_object_free(head);
+    }
+
+    return tips;
+}
+
+bool HistorySession::containsHistory(git_repository *repo, const QList<RefTip> &current,
+                                     const QList<RefTip> &previous)
+{
+    QVector<git_oid> currentOids;
+    currentOids.reserve(current.size());
+    for (const RefTip &tip : current)
+        currentOids.append(tip.oid);
+
+    QVector<git_oid> previousOids;
+    previousOids.reserve(previous.size());
+    for (const RefTip &tip : previous)
+        previousOids.append(tip.oid);
+
+    // Every previous tip must still be reachable (branch moved forward,
+    // merged or deleted after merging), otherwise loaded rows could belong
+    // to history that is gone (force push, reset, rebase)
+    const QVector<bool> reachable = Reachability::reachableFrom(repo, currentOids, previousOids);
+    return std::all_of(reachable.cbegin(), reachable.cend(), [](bool found) { return found; });
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <git2/oid.h>
+#include <git2/types.h>
+
+/**
+ * \brief Snapshot of a single reference tip walked by a history session
+ */
+struct RefTip
+{
+    QByteArray name;    ///< Full reference name (e.g. "refs/heads/main", "HEAD")
+    git_oid oid;        ///< Commit the reference pointed to when the snapshot was taken
+
+    bool operator==(const RefTip &other) const;
+    bool operator!=(const RefTip &other) const { return !(*this == other); }
+};
+
+/**
+ * \brief Long-lived revision walk used to page through commit history
+ *
+ * A session owns a configured git_revwalk (all branch tips + HEAD, sorted
+ * topologically and by time) and keeps it alive between pages, so fetching
+ * page N resumes where page N-1 stopped instead of re-walking the first
+ * N * limit commits.
+ *
+ * The session remembers the ref tips it was started from. When any branch
+ * or HEAD moves the session becomes stale and must be replaced.
+ */
+class HistorySession
+{
+public:
+    explicit HistorySession(git_repository *repo);
+
+    /**
+     * \brief Start a walk from a given set of tips instead of the current refs
+     *
+     * Used to resume a walk recorded earlier (e.g. in the commit cache).
+     * Staleness is still checked against the refs at construction time.
+     */
+    HistorySession(git_repository *repo, const QList<RefTip> &walkTips);
+    ~HistorySession();
+
+    HistorySession(const HistorySession &) = delete;
+    HistorySession &operator=(const HistorySession &) = delete;
+
+    /**
+     * \brief Whether the underlying revwalk was created successfully
+     */
+    bool isValid() const;
+
+    /**
+     * \brief Whether the repository refs moved since the session started
+     *
+     * Re-reads the ref tips and compares them with the snapshot; also returns
+     * true when the session was started on a different repository handle.
+     */
+    bool isStale(git_repository *repo) const;
+
+    /**
+     * \brief Whether the walk reached the root commits
+     */
+    bool isExhausted() const;
+
+    /**
+     * \brief Unique id of this session, embedded in history cursors
+     */
+    quint64 id() const;
+
+    /**
+     * \brief Number of commits handed out so far
+     */
+    int position() const;
+
+    /**
+     * \brief Ref tips the session was started from
+     */
+    const QList<RefTip> &tips() const;
+
+    /**
+     * \brief Tips the revwalk was seeded with (equal to tips() unless given explicitly)
+     */
+    const QList<RefTip> &walkTips() const;
+
+    /**
+     * \brief Replace the ref snapshot used by isStale()
+     *
+     * For callers that loaded the commits added on top of the walked refs
+     * separately: the walk itself goes on unchanged.
+     */
+    void setTips(const QList<RefTip> &tips);
+
+    /**
+     * \brief Change the walk order (git_sort_t flags); only before the first next()
+     *
+     * Sessions walk topologically and by time by default.
+     */
+    void setSorting(unsigned int sortMode);
+
+    /**
+     * \brief Advance the walk by one commit
+     * \param out Receives the next commit id
+     * \return true if a commit was produced, false once the walk is exhausted
+     */
+    bool next(git_oid *out);
+
+    /**
+     * \brief Skip commits without decoding them
+     * \param count Number of commits to skip
+     * \return Number of commits actually skipped
+     */
+    int skip(int count);
+
+    /**
+     * \brief Advance the position now, but only walk past the commits on the next call to next()
+     *
+     * Lets a session resume behind commits that are already known (e.g.
+     * loaded from a cache) without paying for the walk until more history
+     * is actually requested.
+     */
+    void skipLazily(int count);
+
+    /**
+     * \brief Build an opaque cursor pointing at the current position
+     */
+    QString cursor() const;
+
+    /**
+     * \brief Parse a cursor created by cursor()
+     * \param cursor Cursor string
+     * \param sessionId Receives the session id
+     * \param position Receives the position
+     * \return false if the cursor is malformed
+     */
+    static bool parseCursor(const QString &cursor, quint64 &sessionId, int &position);
+
+    /**
+     * \brief Read all branch tips and HEAD of a repository
+     */
+    static QList<RefTip> readRefTips(git_repository *repo);
+
+    /**
+     * \brief Whether every commit reachable from previous is still reachable from current
+     *
+     * True when refs only moved forward, were merged or deleted after
+     * merging; false after history was rewritten (force push, reset, rebase).
+     */
+    static bool containsHistory(git_repository *repo, const QList<RefTip> &current,
+                                const QList<RefTip> &previous);
+
+private:
+    git_repository *m_repo = nullptr;
+    git_revwalk *m_walker = nullptr;
+    QList<RefTip> m_tips;
+    QList<RefTip> m_walkTips;
+    quint64 m_id = 0;
+    int m_position = 0;
+    int m_pendingSkip = 0;
+    bool m_exhausted = false;
+};
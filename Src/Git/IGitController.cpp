@@ -1,4 +1,14 @@
 #include "IGitController.h"
+#include "CommitGraph.h"
+
+#include <QFutureWatcher>
+#include <QSet>
+#include <QtConcurrent>
+
+namespace {
+// Repositories whose commit-graph is being written; every controller may ask for one
+QSet<QString> commitGraphWrites;
+}
 
 IGitController::IGitController(QObject *parent)
     : QObject{parent}
@@ -29,3 +39,34 @@ QString IGitController::gitOidToString(const git_oid *oid)
 
     return QString::fromUtf8(oidStr, GIT_OID_HEXSZ);
 }
+
+void IGitController::refreshCommitGraph()
+{
+    if (!m_currentRepo || !m_currentRepo->repo)
+        return;
+
+    git_repository *repo = m_currentRepo->repo;
+    const QString repoPath = QString::fromUtf8(git_repository_path(repo));
+    if (commitGraphWrites.contains(repoPath) || !CommitGraph::needsRefresh(CommitGraph::objectsDir(repo)))
+        return;
+
+    commitGraphWrites.insert(repoPath);
+
+    auto future = QtConcurrent::run([=]() -> bool {
+        return CommitGraph::write(repoPath);
+    });
+
+    auto *watcher = new QFutureWatcher<bool>(this);
+
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [=]() {
+        commitGraphWrites.remove(repoPath);
+
+        // Only attach if the same repository is still open
+        if (watcher->result() && m_currentRepo && m_currentRepo->repo == repo)
+            CommitGraph::attach(repo);
+
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(future);
+}
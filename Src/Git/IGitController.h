@@ -22,5 +22,17 @@ public:
 signals:
     void currentRepoChanged();
 protected:
+    /**
+     * \brief Rewrite the commit-graph of the current repository in the background
+     *
+     * Called whenever refs or packs may have moved (opening the repository,
+     * creating a commit, pushing, refs seen to change). Skipped when the
+     * existing graph is newer than refs and packs, or a write for the same
+     * repository is still running. The new graph is attached once written,
+     * so following history and merge-base queries read parents and
+     * generation numbers from it.
+     */
+    void refreshCommitGraph();
+
     Repository *m_currentRepo = nullptr;
 };
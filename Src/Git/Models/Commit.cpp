@@ -35,9 +35,8 @@ Commit::Commit(const git_commit *gitCommit)
     m_message = QString::fromUtf8(git_commit_message(gitCommit));
 
     // Get summary (first line of message)
-    QString fullMessage = m_message;
-    QStringList lines = fullMessage.split("\n");
-    m_summary = lines.first();
+    const qsizetype newline = m_message.indexOf('\n');
+    m_summary = newline >= 0 ? m_message.left(newline) : m_message;
 
     // Get author information
     const git_signature *author = git_commit_author(gitCommit);
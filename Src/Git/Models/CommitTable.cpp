@@ -0,0 +1,558 @@
+#include "CommitTable.h"
+
+#include <git2/commit.h>
+#include <git2/oid.h>
+
+#include <QDateTime>
+
+#include <cstring>
+#include <numeric>
+
+CommitTable::CommitTable(QObject *parent)
+    : QObject{parent}
+{
+    m_summaryOffsets.append(0);
+    m_parentOffsets.append(0);
+}
+
+void CommitTable::clear()
+{
+    m_headRows.clear();
+    m_tailRows.clear();
+    m_positions.clear();
+    m_oids.clear();
+    m_times.clear();
+    m_commitTimes.clear();
+    m_authorIds.clear();
+    m_emailIds.clear();
+    m_summaryOffsets = { 0 };
+    m_parentOffsets = { 0 };
+    m_parents.clear();
+    m_pendingOids.clear();
+    m_freePending.clear();
+    m_pending.clear();
+    m_indexByOid.clear();
+    m_text.clear();
+    m_strings.clear();
+    m_stringIds.clear();
+
+    emit rowsReset();
+}
+
+void CommitTable::reserve(int rows)
+{
+    const int total = m_oids.size() + rows;
+    m_tailRows.reserve(m_tailRows.size() + rows);
+    m_positions.reserve(total);
+    m_oids.reserve(total);
+    m_times.reserve(total);
+    m_commitTimes.reserve(total);
+    m_authorIds.reserve(total);
+    m_emailIds.reserve(total);
+    m_summaryOffsets.reserve(total + 1);
+    m_parentOffsets.reserve(total + 1);
+    m_indexByOid.reserve(total);
+}
+
+CommitRecord CommitRecord::fromCommit(const git_commit *commit)
+{
+    CommitRecord record;
+    git_oid_cpy(&record.oid, git_commit_id(commit));
+
+    const git_signature *author = git_commit_author(commit);
+    record.commitTime = git_commit_time(commit);
+    record.time = author ? author->when.time : record.commitTime;
+    if (author) {
+        record.author = author->name;
+        record.email = author->email;
+    }
+
+    // Only the first line is kept, bodies can be kilobytes long
+    const char *message = git_commit_message(commit);
+    if (message) {
+        const char *newline = strchr(message, '\n');
+        record.summary = newline ? QByteArray(message, newline - message) : QByteArray(message);
+    }
+
+    const unsigned int parentCount = git_commit_parentcount(commit);
+    record.parents.resize(parentCount);
+    for (unsigned int i = 0; i < parentCount; ++i)
+        git_oid_cpy(&record.parents[i], git_commit_parent_id(commit, i));
+
+    return record;
+}
+
+int CommitTable::append(const git_commit *commit)
+{
+    if (!commit)
+        return -1;
+
+    const int existing = rowOf(*git_commit_id(commit));
+    if (existing >= 0)
+        return existing;
+
+    return append(CommitRecord::fromCommit(commit));
+}
+
+int CommitTable::append(const CommitRecord &record)
+{
+    const int existing = rowOf(record.oid);
+    if (existing >= 0)
+        return existing;
+
+    m_tailRows.append(store(record, m_tailRows.size()));
+    return count() - 1;
+}
+
+void CommitTable::prepend(const QVector<CommitRecord> &records)
+{
+    // Stored like appended rows; only their place in row order differs
+    QVector<qint32> added;
+    added.reserve(records.size());
+    reserve(records.size());
+    for (const CommitRecord &record : records) {
+        if (!m_indexByOid.contains(record.oid))
+            added.append(store(record, 0));
+    }
+
+    if (added.isEmpty())
+        return;
+
+    // The first record becomes row 0, i.e. the last entry of the head
+    for (qsizetype i = added.size() - 1; i >= 0; --i) {
+        m_headRows.append(added.at(i));
+        m_positions[added.at(i)] = -qint32(m_headRows.size());
+    }
+
+    emit rowsPrepended(added.size());
+}
+
+qint32 CommitTable::store(const CommitRecord &record, qint32 position)
+{
+    const qint32 index = m_oids.size();
+    m_oids.append(record.oid);
+    m_indexByOid.insert(record.oid, index);
+    m_positions.append(position);
+
+    m_times.append(record.time);
+    m_commitTimes.append(record.commitTime);
+    m_authorIds.append(intern(record.author));
+    m_emailIds.append(intern(record.email));
+
+    m_text.append(record.summary);
+    m_summaryOffsets.append(m_text.size());
+
+    appendParents(record.parents);
+    m_parentOffsets.append(m_parents.size());
+
+    // Children loaded earlier may have been waiting for this commit
+    resolvePending(record.oid, index);
+
+    return index;
+}
+
+void CommitTable::swap(CommitTable &other)
+{
+    m_headRows.swap(other.m_headRows);
+    m_tailRows.swap(other.m_tailRows);
+    m_positions.swap(other.m_positions);
+    m_oids.swap(other.m_oids);
+    m_times.swap(other.m_times);
+    m_commitTimes.swap(other.m_commitTimes);
+    m_authorIds.swap(other.m_authorIds);
+    m_emailIds.swap(other.m_emailIds);
+    m_summaryOffsets.swap(other.m_summaryOffsets);
+    m_parentOffsets.swap(other.m_parentOffsets);
+    m_parents.swap(other.m_parents);
+    m_pendingOids.swap(other.m_pendingOids);
+    m_freePending.swap(other.m_freePending);
+    m_pending.swap(other.m_pending);
+    m_indexByOid.swap(other.m_indexByOid);
+    m_text.swap(other.m_text);
+    m_strings.swap(other.m_strings);
+    m_stringIds.swap(other.m_stringIds);
+
+    emit rowsReset();
+}
+
+namespace {
+struct ImageHeader
+{
+    quint32 rows;
+    quint32 parents;
+    quint32 pendingOids;
+    quint32 strings;
+    quint64 textSize;
+    quint64 stringBytes;
+};
+
+template <typename T>
+void writeColumn(QByteArray &out, const QVector<T> &column)
+{
+    out.append(reinterpret_cast<const char *>(column.constData()), column.size() * qsizetype(sizeof(T)));
+}
+
+template <typename T>
+bool readColumn(const char *&cursor, const char *end, QVector<T> &column, qsizetype count)
+{
+    const qsizetype bytes = count * qsizetype(sizeof(T));
+    if (count < 0 || end - cursor < bytes)
+        return false;
+
+    column.resize(count);
+    memcpy(column.data(), cursor, bytes);
+    cursor += bytes;
+    return true;
+}
+}
+
+QByteArray CommitTable::serialize() const
+{
+    QByteArray strings;
+    QVector<quint32> stringOffsets { 0 };
+    for (const QString &string : m_strings) {
+        strings.append(string.toUtf8());
+        stringOffsets.append(strings.size());
+    }
+
+    // The image lists rows in row order, whatever order they were stored in
+    const int rows = count();
+    QVector<git_oid> oids(rows);
+    QVector<qint64> times(rows);
+    QVector<qint64> commitTimes(rows);
+    QVector<qint32> authorIds(rows);
+    QVector<qint32> emailIds(rows);
+    QVector<qint64> summaryOffsets { 0 };
+    QVector<qint32> parentOffsets { 0 };
+    QVector<qint32> parents;
+    QByteArray text;
+    summaryOffsets.reserve(rows + 1);
+    parentOffsets.reserve(rows + 1);
+    parents.reserve(m_parents.size());
+    text.reserve(m_text.size());
+
+    for (int row = 0; row < rows; ++row) {
+        const qint32 index = indexOfRow(row);
+        oids[row] = m_oids.at(index);
+        times[row] = m_times.at(index);
+        commitTimes[row] = m_commitTimes.at(index);
+        authorIds[row] = m_authorIds.at(index);
+        emailIds[row] = m_emailIds.at(index);
+
+        const qint64 begin = m_summaryOffsets.at(index);
+        text.append(m_text.constData() + begin, m_summaryOffsets.at(index + 1) - begin);
+        summaryOffsets.append(text.size());
+
+        for (qint32 slot = m_parentOffsets.at(index); slot < m_parentOffsets.at(index + 1); ++slot) {
+            const qint32 value = m_parents.at(slot);
+            parents.append(value >= 0 ? rowOfIndex(value) : value);
+        }
+        parentOffsets.append(parents.size());
+    }
+
+    ImageHeader header;
+    header.rows = rows;
+    header.parents = parents.size();
+    header.pendingOids = m_pendingOids.size();
+    header.strings = m_strings.size();
+    header.textSize = text.size();
+    header.stringBytes = strings.size();
+
+    QByteArray out;
+    out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    writeColumn(out, oids);
+    writeColumn(out, times);
+    writeColumn(out, commitTimes);
+    writeColumn(out, authorIds);
+    writeColumn(out, emailIds);
+    writeColumn(out, summaryOffsets);
+    writeColumn(out, parentOffsets);
+    writeColumn(out, parents);
+    writeColumn(out, m_pendingOids);
+    writeColumn(out, stringOffsets);
+    out.append(strings);
+    out.append(text);
+
+    return out;
+}
+
+bool CommitTable::deserialize(const char *data, qsizetype size)
+{
+    clear();
+
+    if (!data || size < qsizetype(sizeof(ImageHeader)))
+        return false;
+
+    ImageHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    const char *cursor = data + sizeof(header);
+    const char *end = data + size;
+
+    QVector<quint32> stringOffsets;
+    bool ok = readColumn(cursor, end, m_oids, header.rows)
+              && readColumn(cursor, end, m_times, header.rows)
+              && readColumn(cursor, end, m_commitTimes, header.rows)
+              && readColumn(cursor, end, m_authorIds, header.rows)
+              && readColumn(cursor, end, m_emailIds, header.rows)
+              && readColumn(cursor, end, m_summaryOffsets, qsizetype(header.rows) + 1)
+              && readColumn(cursor, end, m_parentOffsets, qsizetype(header.rows) + 1)
+              && readColumn(cursor, end, m_parents, header.parents)
+              && readColumn(cursor, end, m_pendingOids, header.pendingOids)
+              && readColumn(cursor, end, stringOffsets, qsizetype(header.strings) + 1)
+              && quint64(end - cursor) == header.stringBytes + header.textSize;
+
+    if (ok) {
+        const char *strings = cursor;
+        for (quint32 i = 0; ok && i < header.strings; ++i) {
+            ok = stringOffsets.at(i) <= stringOffsets.at(i + 1) && stringOffsets.at(i + 1) <= header.stringBytes;
+            if (ok) {
+                const QByteArray string(strings + stringOffsets.at(i), stringOffsets.at(i + 1) - stringOffsets.at(i));
+                m_stringIds.insert(string, m_strings.size());
+                m_strings.append(QString::fromUtf8(string));
+            }
+        }
+        m_text = QByteArray(cursor + header.stringBytes, header.textSize);
+    }
+
+    // Guard the accessors against a corrupted image: offsets start in range and never go back
+    ok = ok && m_summaryOffsets.first() >= 0 && m_parentOffsets.first() >= 0;
+    for (qsizetype row = 0; ok && row < m_oids.size(); ++row) {
+        ok = m_authorIds.at(row) >= 0 && m_authorIds.at(row) < m_strings.size()
+             && m_emailIds.at(row) >= 0 && m_emailIds.at(row) < m_strings.size()
+             && m_summaryOffsets.at(row) <= m_summaryOffsets.at(row + 1)
+             && m_parentOffsets.at(row) <= m_parentOffsets.at(row + 1);
+    }
+    ok = ok && m_summaryOffsets.last() == m_text.size() && m_parentOffsets.last() == m_parents.size();
+
+    if (!ok) {
+        clear();
+        return false;
+    }
+
+    // Stored in row order
+    m_tailRows.resize(m_oids.size());
+    std::iota(m_tailRows.begin(), m_tailRows.end(), 0);
+    m_positions = m_tailRows;
+
+    m_indexByOid.reserve(m_oids.size());
+    for (qint32 row = 0; row < m_oids.size(); ++row)
+        m_indexByOid.insert(m_oids.at(row), row);
+
+    // Rebuild the pending parent bookkeeping
+    QVector<bool> used(m_pendingOids.size(), false);
+    for (qint32 slot = 0; slot < m_parents.size(); ++slot) {
+        const qint32 value = m_parents.at(slot);
+        if (value >= m_oids.size() || -value - 1 >= m_pendingOids.size()) {
+            clear();
+            return false;
+        }
+        if (value >= 0)
+            continue;
+
+        PendingParent &pending = m_pending[m_pendingOids.at(-value - 1)];
+        pending.index = -value - 1;
+        pending.children.append(slot);
+        used[pending.index] = true;
+    }
+    for (qint32 i = 0; i < used.size(); ++i) {
+        if (!used.at(i))
+            m_freePending.append(i);
+    }
+
+    return true;
+}
+
+void CommitTable::appendParents(const QVector<git_oid> &parents)
+{
+    // Link to loaded rows, remember the others until they show up
+    for (const git_oid &parentId : parents) {
+        const qint32 slot = m_parents.size();
+        const qint32 parentIndex = m_indexByOid.value(parentId, -1);
+
+        if (parentIndex >= 0) {
+            m_parents.append(parentIndex);
+            continue;
+        }
+
+        PendingParent &pending = m_pending[parentId];
+        if (pending.index < 0) {
+            if (!m_freePending.isEmpty()) {
+                pending.index = m_freePending.takeLast();
+                m_pendingOids[pending.index] = parentId;
+            } else {
+                pending.index = m_pendingOids.size();
+                m_pendingOids.append(parentId);
+            }
+        }
+        pending.children.append(slot);
+        m_parents.append(-(pending.index + 1));
+    }
+}
+
+void CommitTable::resolvePending(const git_oid &oid, qint32 index)
+{
+    auto waiting = m_pending.find(oid);
+    if (waiting == m_pending.end())
+        return;
+
+    for (qint32 slot : std::as_const(waiting->children))
+        m_parents[slot] = index;
+    m_freePending.append(waiting->index);
+    m_pending.erase(waiting);
+}
+
+int CommitTable::rowOf(const git_oid &oid) const
+{
+    const qint32 index = m_indexByOid.value(oid, -1);
+    return index >= 0 ? rowOfIndex(index) : -1;
+}
+
+const git_oid &CommitTable::oid(int row) const
+{
+    return m_oids.at(indexOfRow(row));
+}
+
+qint64 CommitTable::time(int row) const
+{
+    return m_times.at(indexOfRow(row));
+}
+
+qint64 CommitTable::commitTime(int row) const
+{
+    return m_commitTimes.at(indexOfRow(row));
+}
+
+int CommitTable::parentCount(int row) const
+{
+    if (!isValidRow(row))
+        return 0;
+
+    const qint32 index = indexOfRow(row);
+    return m_parentOffsets.at(index + 1) - m_parentOffsets.at(index);
+}
+
+int CommitTable::parentRow(int row, int index) const
+{
+    const qint32 slot = m_parents.at(m_parentOffsets.at(indexOfRow(row)) + index);
+    return slot >= 0 ? rowOfIndex(slot) : -1;
+}
+
+const git_oid &CommitTable::parentOid(int row, int index) const
+{
+    const qint32 slot = m_parents.at(m_parentOffsets.at(indexOfRow(row)) + index);
+    return slot >= 0 ? m_oids.at(slot) : m_pendingOids.at(-slot - 1);
+}
+
+int CommitTable::count() const
+{
+    return m_oids.size();
+}
+
+QString CommitTable::hash(int row) const
+{
+    if (!isValidRow(row))
+        return QString();
+
+    char hash[GIT_OID_SHA1_HEXSIZE + 1];
+    git_oid_tostr(hash, sizeof(hash), &m_oids.at(indexOfRow(row)));
+    return QString::fromLatin1(hash);
+}
+
+QString CommitTable::shortHash(int row) const
+{
+    return hash(row).left(7);
+}
+
+QString CommitTable::summary(int row) const
+{
+    if (!isValidRow(row))
+        return QString();
+
+    const qint32 index = indexOfRow(row);
+    const qsizetype begin = m_summaryOffsets.at(index);
+    return QString::fromUtf8(m_text.constData() + begin, m_summaryOffsets.at(index + 1) - begin);
+}
+
+QString CommitTable::author(int row) const
+{
+    return isValidRow(row) ? m_strings.at(m_authorIds.at(indexOfRow(row))) : QString();
+}
+
+QString CommitTable::authorEmail(int row) const
+{
+    return isValidRow(row) ? m_strings.at(m_emailIds.at(indexOfRow(row))) : QString();
+}
+
+QString CommitTable::authorDate(int row) const
+{
+    if (!isValidRow(row))
+        return QString();
+
+    return QDateTime::fromSecsSinceEpoch(time(row)).toString(Qt::ISODate);
+}
+
+qint64 CommitTable::timestamp(int row) const
+{
+    return isValidRow(row) ? time(row) : 0;
+}
+
+QStringList CommitTable::parentHashes(int row) const
+{
+    QStringList hashes;
+    const int parents = parentCount(row);
+    for (int i = 0; i < parents; ++i) {
+        char hash[GIT_OID_SHA1_HEXSIZE + 1];
+        git_oid_tostr(hash, sizeof(hash), &parentOid(row, i));
+        hashes.append(QString::fromLatin1(hash));
+    }
+
+    return hashes;
+}
+
+QVariantList CommitTable::parentRows(int row) const
+{
+    QVariantList rows;
+    const int parents = parentCount(row);
+    for (int i = 0; i < parents; ++i)
+        rows.append(parentRow(row, i));
+
+    return rows;
+}
+
+int CommitTable::indexOf(const QString &hash) const
+{
+    git_oid oid;
+    if (git_oid_fromstr(&oid, hash.toLatin1().constData()) != 0)
+        return -1;
+
+    return rowOf(oid);
+}
+
+qint32 CommitTable::intern(const QByteArray &text)
+{
+    auto it = m_stringIds.constFind(text);
+    if (it != m_stringIds.constEnd())
+        return it.value();
+
+    const qint32 id = m_strings.size();
+    m_strings.append(QString::fromUtf8(text));
+    m_stringIds.insert(text, id);
+    return id;
+}
+
+bool CommitTable::isValidRow(int row) const
+{
+    return row >= 0 && row < m_oids.size();
+}
+
+qint32 CommitTable::indexOfRow(int row) const
+{
+    const int head = m_headRows.size();
+    return row < head ? m_headRows.at(head - 1 - row) : m_tailRows.at(row - head);
+}
+
+int CommitTable::rowOfIndex(qint32 index) const
+{
+    return m_positions.at(index) + m_headRows.size();
+}
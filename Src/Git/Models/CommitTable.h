@@ -0,0 +1,229 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QQmlEngine>
+#include <QStringList>
+#include <QVector>
+
+#include <git2/types.h>
+
+#include "OidHash.h"
+
+/**
+ * \brief Decoded commit fields, detached from libgit2 objects
+ *
+ * Produced on worker threads and appended to a CommitTable on the thread
+ * that owns it.
+ */
+struct CommitRecord
+{
+    git_oid oid;
+    qint64 time = 0;            ///< Author time
+    qint64 commitTime = 0;      ///< Committer time, what git log --since/--until compare
+    QByteArray author;
+    QByteArray email;
+    QByteArray summary;     ///< First line of the message; the body is fetched on demand
+    QVector<git_oid> parents;
+
+    static CommitRecord fromCommit(const git_commit *commit);
+};
+
+/**
+ * \brief Columnar, append-only store of commit history
+ *
+ * Replaces a QList<Commit> of boxed strings with one array per field:
+ * binary object ids, integer timestamps, interned author names/emails,
+ * UTF-8 summaries (first message line) in a single blob and a flat
+ * parent-row array. Message bodies are not stored, see
+ * GitCommit::getCommitMessages().
+ * Rows are appended in walk order (children before parents); parents that
+ * are not loaded yet are tracked as pending and resolved to a row index
+ * when they arrive.
+ *
+ * Columns keep rows in the order they were added, so prepend() costs only
+ * the new rows: row numbers map to storage through the appended rows and
+ * a head of prepended rows kept in reverse. Parent links and the id lookup
+ * refer to storage indices, which never shift.
+ *
+ * QML reads rows through the Q_INVOKABLE accessors, C++ callers use the
+ * raw accessors (oid(), time(), parentRow(), ...).
+ */
+class CommitTable : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("CommitTable is owned by GitCommit")
+
+public:
+    explicit CommitTable(QObject *parent = nullptr);
+
+    /**
+     * \brief Remove all rows and interned strings
+     */
+    void clear();
+
+    /**
+     * \brief Reserve room for additional rows
+     */
+    void reserve(int rows);
+
+    /**
+     * \brief Append a commit
+     * \return Row of the commit, or the existing row if it is already stored
+     */
+    int append(const git_commit *commit);
+    int append(const CommitRecord &record);
+
+    /**
+     * \brief Insert commits in front of all existing rows
+     *
+     * Records must be in walk order and must not be ancestors of any loaded
+     * row (e.g. commits added on top of the loaded ref tips). Commits that
+     * are loaded already are skipped. Existing rows shift down by the number
+     * of new rows; rowsPrepended() is emitted. Costs O(records.size()).
+     */
+    void prepend(const QVector<CommitRecord> &records);
+
+    /**
+     * \brief Exchange all rows with another table
+     */
+    void swap(CommitTable &other);
+
+    /**
+     * \brief Serialize all columns into a flat binary image
+     */
+    QByteArray serialize() const;
+
+    /**
+     * \brief Replace the table contents with an image created by serialize()
+     * \return false (leaving the table empty) if the image is malformed
+     */
+    bool deserialize(const char *data, qsizetype size);
+
+    /**
+     * \brief Row of a commit id, -1 if not loaded
+     */
+    int rowOf(const git_oid &oid) const;
+
+    const git_oid &oid(int row) const;
+    qint64 time(int row) const;
+
+    /**
+     * \brief Committer time in seconds since epoch
+     */
+    qint64 commitTime(int row) const;
+
+    int parentCount(int row) const;
+
+    /**
+     * \brief Row of a parent, -1 while the parent is not loaded
+     */
+    int parentRow(int row, int index) const;
+
+    /**
+     * \brief Object id of a parent (loaded or pending)
+     */
+    const git_oid &parentOid(int row, int index) const;
+
+    /**
+     * \brief Number of rows
+     */
+    Q_INVOKABLE int count() const;
+
+    Q_INVOKABLE QString hash(int row) const;
+    Q_INVOKABLE QString shortHash(int row) const;
+    Q_INVOKABLE QString summary(int row) const;
+    Q_INVOKABLE QString author(int row) const;
+    Q_INVOKABLE QString authorEmail(int row) const;
+
+    /**
+     * \brief Author date in ISO 8601, formatted on demand
+     */
+    Q_INVOKABLE QString authorDate(int row) const;
+
+    /**
+     * \brief Author time in seconds since epoch
+     */
+    Q_INVOKABLE qint64 timestamp(int row) const;
+
+    Q_INVOKABLE QStringList parentHashes(int row) const;
+
+    /**
+     * \brief Parent rows, -1 for parents that are not loaded yet
+     */
+    Q_INVOKABLE QVariantList parentRows(int row) const;
+
+    /**
+     * \brief Row of a full hash, -1 if not loaded
+     */
+    Q_INVOKABLE int indexOf(const QString &hash) const;
+
+signals:
+    /**
+     * \brief All rows were removed or replaced (clear(), swap(), deserialize())
+     */
+    void rowsReset();
+
+    /**
+     * \brief count rows were inserted in front of the existing ones by prepend()
+     */
+    void rowsPrepended(int count);
+
+private:
+    qint32 intern(const QByteArray &text);
+
+    /**
+     * \brief Add a commit to the columns
+     * \return Storage index of the commit
+     */
+    qint32 store(const CommitRecord &record, qint32 position);
+
+    void appendParents(const QVector<git_oid> &parents);
+    void resolvePending(const git_oid &oid, qint32 index);
+    bool isValidRow(int row) const;
+
+    /**
+     * \brief Storage index of a row
+     */
+    qint32 indexOfRow(int row) const;
+
+    /**
+     * \brief Row of a storage index
+     */
+    int rowOfIndex(qint32 index) const;
+
+    // Row order: m_headRows from the back, then m_tailRows
+    QVector<qint32> m_headRows;             ///< Storage indices of prepended rows, the last one is row 0
+    QVector<qint32> m_tailRows;             ///< Storage indices of appended rows
+    QVector<qint32> m_positions;            ///< Storage index -> index in m_tailRows, or -(index in m_headRows + 1)
+
+    // One entry per row, in storage order
+    QVector<git_oid> m_oids;
+    QVector<qint64> m_times;
+    QVector<qint64> m_commitTimes;
+    QVector<qint32> m_authorIds;
+    QVector<qint32> m_emailIds;
+    QVector<qint64> m_summaryOffsets;       ///< count + 1 entries into m_text
+
+    // Parents: slots [m_parentOffsets[index], m_parentOffsets[index + 1])
+    // A slot >= 0 is a storage index, a slot < 0 is -(pending index + 1)
+    QVector<qint32> m_parentOffsets;
+    QVector<qint32> m_parents;
+
+    // Parents referenced by loaded rows but not loaded themselves
+    struct PendingParent
+    {
+        qint32 index = -1;          ///< Index into m_pendingOids
+        QVector<qint32> children;   ///< Parent slots waiting for this commit
+    };
+    QVector<git_oid> m_pendingOids;
+    QVector<qint32> m_freePending;
+    QHash<git_oid, PendingParent> m_pending;
+
+    QHash<git_oid, qint32> m_indexByOid;
+
+    QByteArray m_text;
+    QStringList m_strings;
+    QHash<QByteArray, qint32> m_stringIds;
+};
@@ -94,3 +94,11 @@ GitFileStatus::DeltaStatus GitFileStatus::deltaStatus() const
 {
     return m_deltaStatus;
 }
+
+GitFileStatus GitFileStatus::merged(const GitFileStatus &other) const
+{
+    return GitFileStatus(m_path, static_cast<Status>(int(m_status) | int(other.m_status)),
+                         m_isStaged || other.m_isStaged,
+                         m_isUntracked || other.m_isUntracked,
+                         m_isUnstaged || other.m_isUnstaged);
+}
@@ -72,6 +72,11 @@ public:
 
     DeltaStatus deltaStatus() const;
 
+    /**
+     * \brief The same file with the flags of both entries (e.g. staged in one scan, modified in another)
+     */
+    GitFileStatus merged(const GitFileStatus &other) const;
+
 private:
     QString m_path;
     Status m_status;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QHashFunctions>
+
+#include <git2/oid.h>
+
+/**
+ * \brief Hashing support so git_oid can be used as a QHash/QSet key
+ */
+inline bool operator==(const git_oid &a, const git_oid &b)
+{
+    return git_oid_equal(&a, &b);
+}
+
+inline bool operator!=(const git_oid &a, const git_oid &b)
+{
+    return !git_oid_equal(&a, &b);
+}
+
+inline size_t qHash(const git_oid &oid, size_t seed = 0)
+{
+    // Object ids are already uniformly distributed, hashing a prefix is enough
+    return qHashBits(oid.id, sizeof(quint64), seed);
+}
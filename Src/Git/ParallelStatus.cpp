@@ -0,0 +1,236 @@
+#include "ParallelStatus.h"
+
+#include <git2/config.h>
+#include <git2/errors.h>
+#include <git2/repository.h>
+
+#include <QThread>
+#include <QtConcurrent>
+
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+// Fewer, larger shards pay less scheduling overhead; a few per thread balance uneven directories
+constexpr int MinShardSize = 512;
+constexpr int ShardsPerThread = 4;
+
+// A directory larger than this is split after all, so one huge folder does not run on one thread
+constexpr int MaxShardFactor = 4;
+
+#ifdef Q_OS_UNIX
+#ifdef Q_OS_DARWIN
+inline const timespec &modificationTime(const struct stat &st) { return st.st_mtimespec; }
+inline const timespec &changeTime(const struct stat &st) { return st.st_ctimespec; }
+#else
+inline const timespec &modificationTime(const struct stat &st) { return st.st_mtim; }
+inline const timespec &changeTime(const struct stat &st) { return st.st_ctim; }
+#endif
+
+bool sameTime(const git_index_time &time, const timespec &spec)
+{
+    return time.seconds == int32_t(spec.tv_sec) && time.nanoseconds == uint32_t(spec.tv_nsec);
+}
+#endif
+
+size_t directoryLength(const char *path)
+{
+    const char *slash = std::strrchr(path, '/');
+    return slash ? size_t(slash - path) : 0;
+}
+
+bool sameDirectory(const git_index_entry *a, const git_index_entry *b)
+{
+    const size_t length = directoryLength(a->path);
+    return length == directoryLength(b->path) && std::strncmp(a->path, b->path, length) == 0;
+}
+
+bool configFlag(git_config *config, const char *name, bool defaultValue)
+{
+    int value = 0;
+    return config && git_config_get_bool(&value, config, name) == GIT_OK ? value != 0 : defaultValue;
+}
+}
+
+struct ParallelStatus::Options
+{
+    bool fileMode = true;           ///< core.filemode: the executable bit is meaningful
+    bool trustCtime = true;         ///< core.trustctime
+    bool minimalStat = false;       ///< core.checkStat=minimal: only size and mtime
+    git_index_time indexTime = {0, 0};  ///< Modification time of the index file
+};
+
+struct ParallelStatus::Shard
+{
+    qsizetype first = 0;
+    qsizetype last = 0;             ///< One past the end
+    QVector<qsizetype> changed;     ///< Entries to compare by content
+};
+
+ParallelStatus::ParallelStatus(int threadCount)
+{
+    m_pool.setMaxThreadCount(threadCount > 0 ? threadCount : QThread::idealThreadCount());
+}
+
+ParallelStatus::~ParallelStatus()
+{
+    m_pool.waitForDone();
+}
+
+bool ParallelStatus::changedFiles(git_repository *repo, QStringList &paths, const std::atomic<bool> *cancelled)
+{
+    paths.clear();
+
+#ifdef Q_OS_UNIX
+    const char *workdir = git_repository_workdir(repo);
+    if (!workdir)
+        return false;
+
+    git_index *index = nullptr;
+    if (git_repository_index(&index, repo) != GIT_OK)
+        return false;
+
+    // The same index libgit2 compares against when it checks the candidates
+    if (git_index_read(index, false) != GIT_OK) {
+        git_index_free(index);
+        return false;
+    }
+
+    Options options;
+    git_config *config = nullptr;
+    if (git_repository_config_snapshot(&config, repo) == GIT_OK) {
+        options.fileMode = configFlag(config, "core.filemode", true);
+        options.trustCtime = configFlag(config, "core.trustctime", true);
+
+        const char *checkStat = nullptr;
+        if (git_config_get_string(&checkStat, config, "core.checkStat") == GIT_OK)
+            options.minimalStat = checkStat && std::strcmp(checkStat, "minimal") == 0;
+        git_config_free(config);
+    }
+
+    // Entries written in the same timestamp as the index may have changed again unnoticed
+    struct stat indexStat;
+    const QByteArray indexPath = QByteArray(git_repository_path(repo)) + "index";
+    if (::stat(indexPath.constData(), &indexStat) == 0) {
+        options.indexTime.seconds = int32_t(modificationTime(indexStat).tv_sec);
+        options.indexTime.nanoseconds = uint32_t(modificationTime(indexStat).tv_nsec);
+    }
+
+    const size_t count = git_index_entrycount(index);
+    QVector<const git_index_entry *> entries;
+    entries.reserve(qsizetype(count));
+    for (size_t i = 0; i < count; ++i)
+        entries.append(git_index_get_byindex(index, i));
+
+    // Index paths are bytes, like file names on disk: no need to round-trip through QString
+    const QByteArray root(workdir);
+    QVector<Shard> shards = split(entries);
+    QtConcurrent::blockingMap(&m_pool, shards, [&entries, &root, &options, cancelled](Shard &shard) {
+        for (qsizetype i = shard.first; i < shard.last; ++i) {
+            if (cancelled && *cancelled)
+                return;
+            if (needsCheck(entries[i], root, options))
+                shard.changed.append(i);
+        }
+    });
+
+    if (cancelled && *cancelled) {
+        git_index_free(index);
+        return false;
+    }
+
+    for (const Shard &shard : std::as_const(shards)) {
+        for (qsizetype i : shard.changed) {
+            // Conflicts have up to three entries for one path
+            const QString path = QString::fromUtf8(entries[i]->path);
+            if (paths.isEmpty() || paths.constLast() != path)
+                paths.append(path);
+        }
+    }
+
+    git_index_free(index);
+    return true;
+#else
+    Q_UNUSED(repo)
+    Q_UNUSED(cancelled)
+    return false;
+#endif
+}
+
+QVector<ParallelStatus::Shard> ParallelStatus::split(const QVector<const git_index_entry *> &entries) const
+{
+    const int threads = qMax(1, m_pool.maxThreadCount());
+    const qsizetype shardSize = qMax(qsizetype(MinShardSize), entries.size() / (threads * ShardsPerThread));
+
+    // The index is sorted by path, so a directory's files are contiguous
+    QVector<Shard> shards;
+    Shard shard;
+    for (qsizetype i = 1; i <= entries.size(); ++i) {
+        const qsizetype size = i - shard.first;
+        const bool end = i == entries.size()
+                         || (size >= shardSize && !sameDirectory(entries[i - 1], entries[i]))
+                         || size >= shardSize * MaxShardFactor;
+        if (!end)
+            continue;
+
+        shard.last = i;
+        shards.append(shard);
+        shard = Shard();
+        shard.first = i;
+    }
+
+    return shards;
+}
+
+bool ParallelStatus::needsCheck(const git_index_entry *entry, const QByteArray &workdir, const Options &options)
+{
+#ifdef Q_OS_UNIX
+    // libgit2 has its own rules for these; leave them to it
+    if (git_index_entry_stage(entry) != 0 || entry->mode == GIT_FILEMODE_COMMIT
+        || (entry->flags & GIT_INDEX_ENTRY_VALID)
+        || (entry->flags_extended & (GIT_INDEX_ENTRY_INTENT_TO_ADD | GIT_INDEX_ENTRY_SKIP_WORKTREE))) {
+        return true;
+    }
+
+    struct stat st;
+    if (::lstat((workdir + entry->path).constData(), &st) != 0)
+        return true;    // Deleted, or hidden behind a file that replaced a directory
+
+    if (S_ISLNK(st.st_mode)) {
+        if (entry->mode != GIT_FILEMODE_LINK)
+            return true;
+    } else if (S_ISREG(st.st_mode)) {
+        if (entry->mode == GIT_FILEMODE_LINK)
+            return true;
+        if (options.fileMode && bool(st.st_mode & S_IXUSR) != (entry->mode == GIT_FILEMODE_BLOB_EXECUTABLE))
+            return true;
+    } else {
+        return true;    // Replaced by a directory
+    }
+
+    if (entry->file_size != uint32_t(st.st_size) || !sameTime(entry->mtime, modificationTime(st)))
+        return true;
+
+    if (!options.minimalStat) {
+        if (options.trustCtime && !sameTime(entry->ctime, changeTime(st)))
+            return true;
+        if (entry->ino != uint32_t(st.st_ino) || entry->uid != uint32_t(st.st_uid)
+            || entry->gid != uint32_t(st.st_gid)) {
+            return true;
+        }
+    }
+
+    // Racily clean: the file may have changed after it was staged without moving its mtime
+    return entry->mtime.seconds > options.indexTime.seconds
+           || (entry->mtime.seconds == options.indexTime.seconds
+               && entry->mtime.nanoseconds >= options.indexTime.nanoseconds);
+#else
+    Q_UNUSED(entry)
+    Q_UNUSED(workdir)
+    Q_UNUSED(options)
+    return true;
+#endif
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include <git2/index.h>
+
+#include <atomic>
+
+/**
+ * \brief Finds the tracked files of a working tree whose stat no longer matches the index, on a pool of threads
+ *
+ * libgit2 stats every tracked file on the calling thread before it decides
+ * what to hash. On a large tree that lstat() pass is most of the status
+ * time, and it parallelizes well: the index is split into shards of whole
+ * directories, each shard is stat'ed on a pool thread against the cached
+ * stat data of its entries, and the results are merged in index order.
+ *
+ * What comes out are the candidates git would look at more closely: files
+ * whose size, times, inode or mode differ, missing files, and "racily
+ * clean" entries written in the same timestamp as the index. Everything
+ * else is unchanged in the working tree and needs neither reading nor
+ * hashing. Entries libgit2 treats specially (conflicts, submodules,
+ * intent-to-add, assume-unchanged, skip-worktree) are always candidates.
+ */
+class ParallelStatus
+{
+public:
+    /**
+     * \param threadCount Stat threads, 0 for one per core
+     */
+    explicit ParallelStatus(int threadCount = 0);
+    ~ParallelStatus();
+
+    ParallelStatus(const ParallelStatus &) = delete;
+    ParallelStatus &operator=(const ParallelStatus &) = delete;
+
+    /**
+     * \brief List the tracked files that may differ between the index and the working tree
+     * \param repo Repository whose working tree is checked
+     * \param paths Receives the candidate paths relative to the working tree, in index order
+     * \param cancelled Checked between files on every thread; the pass stops early once it is set
+     * \return false if the stat data cannot be relied on (no working tree, unreadable index,
+     *         unsupported platform) or the pass was cancelled
+     */
+    bool changedFiles(git_repository *repo, QStringList &paths, const std::atomic<bool> *cancelled = nullptr);
+
+private:
+    struct Options;
+    struct Shard;
+
+    /**
+     * \brief Split the index into contiguous shards that do not cut a directory in two
+     */
+    QVector<Shard> split(const QVector<const git_index_entry *> &entries) const;
+
+    /**
+     * \brief Whether the working tree file of an entry has to be compared by content
+     */
+    static bool needsCheck(const git_index_entry *entry, const QByteArray &workdir, const Options &options);
+
+    QThreadPool m_pool;
+};
@@ -0,0 +1,136 @@
+#include "PathFilter.h"
+
+#include <git2/commit.h>
+#include <git2/errors.h>
+#include <git2/tree.h>
+
+#include <QStringList>
+
+PathFilter::PathFilter(const QString &path)
+{
+    const QStringList parts = QString(path).replace('\\', '/').split('/', Qt::SkipEmptyParts);
+    for (const QString &part : parts)
+        m_components.append(part.toUtf8());
+}
+
+bool PathFilter::isEmpty() const
+{
+    return m_components.isEmpty();
+}
+
+QString PathFilter::path() const
+{
+    QStringList parts;
+    for (const QByteArray &component : m_components)
+        parts.append(QString::fromUtf8(component));
+
+    return parts.join('/');
+}
+
+bool PathFilter::touches(git_repository *repo, const git_oid &commitId) const
+{
+    if (isEmpty())
+        return true;
+
+    git_commit *commit = nullptr;
+    if (git_commit_lookup(&commit, repo, &commitId) != GIT_OK)
+        return false;
+
+    git_tree *tree = nullptr;
+    const unsigned int parentCount = git_commit_parentcount(commit);
+    bool changed = true;
+
+    if (parentCount == 0) {
+        // Root commit: it introduced the path if it has it
+        if (git_commit_tree(&tree, commit) == GIT_OK)
+            changed = differs(repo, tree, nullptr);
+    }
+
+    for (unsigned int i = 0; i < parentCount && changed; ++i) {
+        // Same root tree: nothing changed anywhere, no need to read it
+        git_commit *parent = nullptr;
+        if (git_commit_parent(&parent, commit, i) != GIT_OK)
+            continue;
+
+        if (git_oid_equal(git_commit_tree_id(commit), git_commit_tree_id(parent))) {
+            changed = false;
+        } else {
+            git_tree *parentTree = nullptr;
+            if (!tree && git_commit_tree(&tree, commit) != GIT_OK)
+                tree = nullptr;
+
+            if (tree && git_commit_tree(&parentTree, parent) == GIT_OK) {
+                changed = differs(repo, tree, parentTree);
+                git_tree_free(parentTree);
+            }
+        }
+
+        git_commit_free(parent);
+    }
+
+    if (tree)
+        git_tree_free(tree);
+    git_commit_free(commit);
+
+    return changed;
+}
+
+bool PathFilter::differs(git_repository *repo, const git_tree *tree, const git_tree *parentTree) const
+{
+    // Subtrees looked up on the way down, owned by this call
+    git_tree *ownedTree = nullptr;
+    git_tree *ownedParentTree = nullptr;
+    bool result = false;
+
+    for (int i = 0; i < m_components.size(); ++i) {
+        const char *name = m_components.at(i).constData();
+        const git_tree_entry *entry = tree ? git_tree_entry_byname(tree, name) : nullptr;
+        const git_tree_entry *parentEntry = parentTree ? git_tree_entry_byname(parentTree, name) : nullptr;
+
+        if (!entry || !parentEntry) {
+            // Added or removed; absent on both sides means unchanged
+            result = entry || parentEntry;
+            break;
+        }
+
+        if (git_oid_equal(git_tree_entry_id(entry), git_tree_entry_id(parentEntry))) {
+            result = false;
+            break;
+        }
+
+        const bool last = i == m_components.size() - 1;
+        if (last || git_tree_entry_type(entry) != GIT_OBJECT_TREE
+            || git_tree_entry_type(parentEntry) != GIT_OBJECT_TREE) {
+            result = true;
+            break;
+        }
+
+        git_tree *subtree = nullptr;
+        git_tree *parentSubtree = nullptr;
+        if (git_tree_lookup(&subtree, repo, git_tree_entry_id(entry)) != GIT_OK
+            || git_tree_lookup(&parentSubtree, repo, git_tree_entry_id(parentEntry)) != GIT_OK) {
+            if (subtree)
+                git_tree_free(subtree);
+            result = true;
+            break;
+        }
+
+        // Entries of the previous level belong to the trees freed here
+        if (ownedTree)
+            git_tree_free(ownedTree);
+        if (ownedParentTree)
+            git_tree_free(ownedParentTree);
+
+        ownedTree = subtree;
+        ownedParentTree = parentSubtree;
+        tree = subtree;
+        parentTree = parentSubtree;
+    }
+
+    if (ownedTree)
+        git_tree_free(ownedTree);
+    if (ownedParentTree)
+        git_tree_free(ownedParentTree);
+
+    return result;
+}
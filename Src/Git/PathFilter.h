@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <git2/oid.h>
+#include <git2/types.h>
+
+/**
+ * \brief Decides whether a commit changed a file or directory (git log -- path)
+ *
+ * Only the tree entries along the path are compared between a commit and
+ * its parents. The walk down stops at the first level whose entries have
+ * the same oid, so unchanged subtrees are never read, and the whole check
+ * is skipped when the root trees match.
+ *
+ * A commit is kept when it differs from every parent (for merges: when it
+ * is not TREESAME to any parent), and a root commit when it contains the
+ * path.
+ */
+class PathFilter
+{
+public:
+    PathFilter() = default;
+
+    /**
+     * \param path Path relative to the repository root, '/' separated
+     */
+    explicit PathFilter(const QString &path);
+
+    bool isEmpty() const;
+
+    /**
+     * \brief Normalized path (no leading, trailing or doubled separators)
+     */
+    QString path() const;
+
+    /**
+     * \brief Whether the commit changed the path relative to its parents
+     */
+    bool touches(git_repository *repo, const git_oid &commitId) const;
+
+private:
+    /**
+     * \brief Whether the entry at the path differs between two trees (either may be null)
+     */
+    bool differs(git_repository *repo, const git_tree *tree, const git_tree *parentTree) const;
+
+    QList<QByteArray> m_components;
+};
@@ -0,0 +1,185 @@
+#include "Reachability.h"
+#include "OidHash.h"
+
+#include <git2/commit.h>
+#include <git2/errors.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+
+#include <algorithm>
+#include <queue>
+
+namespace {
+// Commits older than every candidate left in a row before the walk gives up;
+// allows for parents committed with a clock behind their children's (as git's SLOP)
+constexpr int ReachSlop = 5;
+
+// Source sets kept in the cache before it is dropped
+constexpr int MaxCachedSourceSets = 256;
+
+QMutex s_cacheMutex;
+QHash<QByteArray, QHash<git_oid, bool>> s_cache;
+
+QByteArray sourceKey(QVector<git_oid> sources)
+{
+    std::sort(sources.begin(), sources.end(), [](const git_oid &a, const git_oid &b) {
+        return git_oid_cmp(&a, &b) < 0;
+    });
+    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+    QByteArray key;
+    key.reserve(sources.size() * GIT_OID_SHA1_SIZE);
+    for (const git_oid &oid : sources)
+        key.append(reinterpret_cast<const char *>(oid.id), GIT_OID_SHA1_SIZE);
+    return key;
+}
+
+struct WalkedCommit
+{
+    git_oid oid;
+    git_time_t time = 0;
+    QVector<git_oid> parents;
+};
+
+bool readCommit(git_repository *repo, const git_oid &oid, WalkedCommit &out)
+{
+    git_commit *commit = nullptr;
+    if (git_commit_lookup(&commit, repo, &oid) != GIT_OK)
+        return false;
+
+    out.oid = oid;
+    out.time = git_commit_time(commit);
+    const unsigned int parentCount = git_commit_parentcount(commit);
+    out.parents.clear();
+    out.parents.reserve(parentCount);
+    for (unsigned int i = 0; i < parentCount; ++i)
+        out.parents.append(*git_commit_parent_id(commit, i));
+
+    git_commit_free(commit);
+    return true;
+}
+
+struct Candidate
+{
+    git_oid oid;
+    git_time_t time = 0;
+    bool found = false;
+};
+}
+
+QVector<bool> Reachability::reachableFrom(git_repository *repo, const QVector<git_oid> &sources,
+                                          const QVector<git_oid> &candidates)
+{
+    QVector<bool> result(candidates.size(), false);
+    if (!repo || sources.isEmpty() || candidates.isEmpty())
+        return result;
+
+    const QByteArray key = sourceKey(sources);
+
+    // Candidate -> positions in result still unanswered
+    QHash<git_oid, QVector<int>> pending;
+    {
+        QMutexLocker locker(&s_cacheMutex);
+        const auto cached = s_cache.constFind(key);
+        for (int i = 0; i < candidates.size(); ++i) {
+            if (cached != s_cache.constEnd()) {
+                const auto answer = cached->constFind(candidates.at(i));
+                if (answer != cached->constEnd()) {
+                    result[i] = answer.value();
+                    continue;
+                }
+            }
+            pending[candidates.at(i)].append(i);
+        }
+    }
+
+    if (pending.isEmpty())
+        return result;
+
+    // Oldest first, so the walk knows when it is behind all of them. Commits
+    // that can't be read stay unanswered and uncached (they may be fetched later)
+    QVector<Candidate> byTime;
+    byTime.reserve(pending.size());
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        WalkedCommit commit;
+        if (readCommit(repo, it.key(), commit))
+            byTime.append({ it.key(), commit.time, false });
+    }
+    std::sort(byTime.begin(), byTime.end(), [](const Candidate &a, const Candidate &b) {
+        return a.time < b.time;
+    });
+
+    QHash<git_oid, int> candidateIndex;
+    for (int i = 0; i < byTime.size(); ++i)
+        candidateIndex.insert(byTime.at(i).oid, i);
+
+    QVector<WalkedCommit> walked;
+    QSet<git_oid> seen;
+    std::priority_queue<std::pair<git_time_t, int>> queue;     // Newest first
+
+    auto enqueue = [&](const git_oid &oid) {
+        if (seen.contains(oid))
+            return;
+        seen.insert(oid);
+
+        WalkedCommit commit;
+        if (!readCommit(repo, oid, commit))
+            return;
+
+        queue.push({ commit.time, int(walked.size()) });
+        walked.append(commit);
+    };
+
+    for (const git_oid &source : sources)
+        enqueue(source);
+
+    if (walked.isEmpty())
+        return result;
+
+    int remaining = byTime.size();
+    int oldest = 0;
+    int olderInARow = 0;
+    while (remaining > 0 && !queue.empty()) {
+        const int index = queue.top().second;
+        queue.pop();
+        const WalkedCommit commit = walked.at(index);
+
+        const auto candidate = candidateIndex.constFind(commit.oid);
+        if (candidate != candidateIndex.constEnd() && !byTime.at(candidate.value()).found) {
+            byTime[candidate.value()].found = true;
+            remaining--;
+        }
+
+        while (oldest < byTime.size() && byTime.at(oldest).found)
+            oldest++;
+
+        // Every candidate left is newer than the walk: they can only be reached
+        // through parents dated after their children
+        if (oldest < byTime.size() && commit.time < byTime.at(oldest).time) {
+            if (++olderInARow >= ReachSlop)
+                break;
+        } else {
+            olderInARow = 0;
+        }
+
+        for (const git_oid &parent : commit.parents)
+            enqueue(parent);
+    }
+
+    QMutexLocker locker(&s_cacheMutex);
+    if (s_cache.size() >= MaxCachedSourceSets && !s_cache.contains(key))
+        s_cache.clear();
+
+    QHash<git_oid, bool> &answers = s_cache[key];
+    for (const Candidate &candidate : byTime) {
+        answers.insert(candidate.oid, candidate.found);
+        for (int i : pending.value(candidate.oid))
+            result[i] = candidate.found;
+    }
+
+    return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QVector>
+
+#include <git2/oid.h>
+#include <git2/types.h>
+
+/**
+ * \brief Which of many commits are reachable from a set of sources, in one walk
+ *
+ * Asking git_merge_base or git_graph_reachable_from_any per candidate walks
+ * the shared history once per candidate. Here the walk starts from the
+ * sources, pops commits newest first and checks each against the whole
+ * candidate set. It ends when every candidate was found or the walk is
+ * older than every candidate left (with the same slop git uses for skewed
+ * commit dates).
+ *
+ * Commits never change, so answers are kept in a process-wide cache keyed
+ * by source set and candidate, shared by all callers and threads.
+ */
+class Reachability
+{
+public:
+    /**
+     * \brief Whether each candidate is reachable from (or equal to) one of the sources
+     * \param repo Repository to walk; not shared with other threads while running
+     * \param sources Commits to walk from
+     * \param candidates Commits to look for
+     * \return One flag per candidate, in the same order; false for commits that can't be read
+     */
+    static QVector<bool> reachableFrom(git_repository *repo, const QVector<git_oid> &sources,
+                                       const QVector<git_oid> &candidates);
+};
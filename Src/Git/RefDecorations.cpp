@@ -0,0 +1,147 @@
+#include "RefDecorations.h"
+
+#include <git2/errors.h>
+#include <git2/object.h>
+#include <git2/refs.h>
+#include <git2/repository.h>
+#include <git2/revparse.h>
+
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+
+#include <utility>
+
+bool RefDecoration::operator==(const RefDecoration &other) const
+{
+    return head == other.head && branches == other.branches && remotes == other.remotes && tags == other.tags;
+}
+
+bool RefDecorations::refresh(git_repository *repo)
+{
+    if (!repo) {
+        const bool hadRefs = !m_decorations.isEmpty();
+        clear();
+        return hadRefs;
+    }
+
+    const QString repoPath = QString::fromUtf8(git_repository_path(repo));
+    const QByteArray current = stamp(repo);
+    if (repoPath == m_repoPath && current == m_stamp)
+        return false;
+
+    const QHash<git_oid, RefDecoration> previous = std::exchange(m_decorations, {});
+    m_repoPath = repoPath;
+    m_stamp = current;
+
+    git_reference_iterator *iter = nullptr;
+    if (git_reference_iterator_new(&iter, repo) == GIT_OK) {
+        git_reference *ref = nullptr;
+        while (git_reference_next(&ref, iter) == GIT_OK) {
+            // Symbolic refs (e.g. origin/HEAD) only repeat the ref they point to
+            git_object *target = nullptr;
+            if (git_reference_type(ref) == GIT_REFERENCE_DIRECT
+                && git_reference_peel(&target, ref, GIT_OBJECT_COMMIT) == GIT_OK && target) {
+                RefDecoration &decoration = m_decorations[*git_object_id(target)];
+                const QString name = QString::fromUtf8(git_reference_shorthand(ref));
+
+                if (git_reference_is_branch(ref))
+                    decoration.branches.append(name);
+                else if (git_reference_is_remote(ref))
+                    decoration.remotes.append(name);
+                else if (git_reference_is_tag(ref))
+                    decoration.tags.append(name);
+
+                git_object_free(target);
+            }
+
+            git_reference_free(ref);
+        }
+
+        git_reference_iterator_free(iter);
+    }
+
+    // Loose and packed refs are iterated in no useful order
+    for (RefDecoration &decoration : m_decorations) {
+        decoration.branches.sort();
+        decoration.remotes.sort();
+        decoration.tags.sort();
+    }
+
+    git_object *head = nullptr;
+    if (git_revparse_single(&head, repo, "HEAD^{commit}") == GIT_OK && head) {
+        m_decorations[*git_object_id(head)].head = true;
+        git_object_free(head);
+    }
+
+    diff(previous);
+    return true;
+}
+
+void RefDecorations::clear()
+{
+    const QHash<git_oid, RefDecoration> previous = std::exchange(m_decorations, {});
+    m_repoPath.clear();
+    m_stamp.clear();
+    diff(previous);
+}
+
+const QVector<git_oid> &RefDecorations::changed() const
+{
+    return m_changed;
+}
+
+void RefDecorations::diff(const QHash<git_oid, RefDecoration> &previous)
+{
+    m_changed.clear();
+    for (auto it = previous.constBegin(); it != previous.constEnd(); ++it) {
+        const auto current = m_decorations.constFind(it.key());
+        if (current == m_decorations.constEnd() || current.value() != it.value())
+            m_changed.append(it.key());
+    }
+    for (auto it = m_decorations.constBegin(); it != m_decorations.constEnd(); ++it) {
+        if (!previous.contains(it.key()))
+            m_changed.append(it.key());
+    }
+}
+
+const RefDecoration *RefDecorations::find(const git_oid &oid) const
+{
+    const auto it = m_decorations.constFind(oid);
+    return it != m_decorations.constEnd() ? &it.value() : nullptr;
+}
+
+QByteArray RefDecorations::stamp(git_repository *repo)
+{
+    const QString gitDir = QString::fromUtf8(git_repository_path(repo));
+    const QString commonDir = QString::fromUtf8(git_repository_commondir(repo));
+
+    qint64 newest = 0;
+    qint64 entries = 0;
+    auto consider = [&newest, &entries](const QFileInfo &info) {
+        newest = qMax(newest, info.lastModified().toMSecsSinceEpoch());
+        entries++;
+    };
+
+    // Directories too: deleting a loose ref only touches its directory
+    QDirIterator refs(commonDir + "refs", QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot,
+                      QDirIterator::Subdirectories);
+    while (refs.hasNext()) {
+        refs.next();
+        consider(refs.fileInfo());
+    }
+
+    const QFileInfo packedRefs(commonDir + "packed-refs");
+    if (packedRefs.exists())
+        newest = qMax(newest, packedRefs.lastModified().toMSecsSinceEpoch());
+
+    // HEAD is tiny; its contents catch checkouts within the timestamp resolution
+    QByteArray head;
+    QFile headFile(gitDir + "HEAD");
+    if (headFile.open(QIODevice::ReadOnly))
+        head = headFile.readAll();
+
+    return QByteArray::number(newest) + ':' + QByteArray::number(entries) + ':'
+           + QByteArray::number(packedRefs.exists() ? packedRefs.size() : -1) + ':' + head;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <git2/oid.h>
+#include <git2/types.h>
+
+#include "OidHash.h"
+
+/**
+ * \brief Refs pointing at one commit
+ */
+struct RefDecoration
+{
+    QStringList branches;   ///< Local branches ("main")
+    QStringList remotes;    ///< Remote-tracking branches ("origin/main")
+    QStringList tags;       ///< Tags, annotated ones peeled to their commit
+    bool head = false;      ///< HEAD points at the commit
+
+    bool operator==(const RefDecoration &other) const;
+    bool operator!=(const RefDecoration &other) const { return !(*this == other); }
+};
+
+/**
+ * \brief Snapshot of all refs of a repository, by commit
+ *
+ * Reading every ref for each page of history (or each row) is replaced by
+ * one hash lookup. The snapshot is taken again only when packed-refs, a
+ * loose ref or HEAD changed on disk, detected by their modification times
+ * and the number of loose refs, so refresh() is a few stat calls while
+ * refs stay put.
+ */
+class RefDecorations
+{
+public:
+    /**
+     * \brief Take a new snapshot if the refs of repo changed since the last one
+     * \return true if the snapshot was replaced
+     */
+    bool refresh(git_repository *repo);
+
+    /**
+     * \brief Drop the snapshot
+     */
+    void clear();
+
+    /**
+     * \brief Refs pointing at a commit, nullptr if there are none
+     */
+    const RefDecoration *find(const git_oid &oid) const;
+
+    /**
+     * \brief Commits that gained, lost or changed refs with the last refresh() or clear()
+     */
+    const QVector<git_oid> &changed() const;
+
+private:
+    /**
+     * \brief Cheap fingerprint of the ref storage of a repository
+     */
+    static QByteArray stamp(git_repository *repo);
+
+    /**
+     * \brief Record the commits whose decoration differs between previous and the snapshot
+     */
+    void diff(const QHash<git_oid, RefDecoration> &previous);
+
+    QHash<git_oid, RefDecoration> m_decorations;
+    QVector<git_oid> m_changed;
+    QString m_repoPath;
+    QByteArray m_stamp;
+};
@@ -0,0 +1,531 @@
+#include "RefMembershipIndex.h"
+#include "CommitCache.h"
+
+#include <git2/errors.h>
+#include <git2/repository.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include <map>
+
+namespace {
+constexpr quint32 MembershipMagic = 0x4745524d; // "GERM"
+constexpr quint32 MembershipVersion = 1;
+
+// Delay before computed sets are written, so a page load is saved once
+constexpr int SaveDelayMs = 2000;
+
+QString shortRefName(const QByteArray &name)
+{
+    QString shortName = QString::fromUtf8(name);
+    if (shortName.startsWith("refs/heads/"))
+        shortName.remove(0, 11);
+    else if (shortName.startsWith("refs/remotes/"))
+        shortName.remove(0, 13);
+    return shortName;
+}
+
+bool hasBit(const QByteArray &set, int bit)
+{
+    return set.at(bit / 8) & (1 << (bit % 8));
+}
+
+void setBit(QByteArray &set, int bit)
+{
+    set[bit / 8] = char(set.at(bit / 8) | (1 << (bit % 8)));
+}
+
+void unite(QByteArray &set, const QByteArray &other)
+{
+    char *bytes = set.data();
+    for (int i = 0; i < other.size(); ++i)
+        bytes[i] |= other.at(i);
+}
+
+void writeOid(QDataStream &stream, const git_oid &oid)
+{
+    stream.writeRawData(reinterpret_cast<const char *>(oid.id), GIT_OID_SHA1_SIZE);
+}
+
+bool readOid(QDataStream &stream, git_oid &oid)
+{
+    memset(&oid, 0, sizeof(oid));
+    return stream.readRawData(reinterpret_cast<char *>(oid.id), GIT_OID_SHA1_SIZE) == GIT_OID_SHA1_SIZE;
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+}
+
+RefMembershipIndex::RefMembershipIndex(CommitTable *table, QObject *parent)
+    : QObject{parent},
+      m_table(table)
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SaveDelayMs);
+    connect(&m_saveTimer, &QTimer::timeout, this, &RefMembershipIndex::save);
+
+    // Cleared, replaced or restored from the history cache: adopt saved sets if they still fit
+    connect(m_table, &CommitTable::rowsReset, this, [this]() {
+        m_sets.clear();
+        m_setIds.clear();
+        m_rowSets.clear();
+        m_pending.clear();
+        resetRefs();
+
+        if (m_table->count() > 0 && !m_repoPath.isEmpty()) {
+            QFile file(CommitCache::pathFor(m_repoPath, "refs"));
+            if (file.open(QIODevice::ReadOnly) && !restore(file.readAll())) {
+                m_sets.clear();
+                m_setIds.clear();
+                m_rowSets.clear();
+                m_pending.clear();
+            }
+        }
+
+        sync();
+        emit membershipChanged();
+    });
+
+    // Commits on top of the loaded ones: rows shifted and refs moved
+    connect(m_table, &CommitTable::rowsPrepended, this, [this](int count) {
+        const QList<RefTip> previous = m_refs;
+        resetRefs();
+        if (!propagate(previous, count))
+            rebuild();
+    });
+}
+
+RefMembershipIndex::~RefMembershipIndex()
+{
+    // Flush synchronously, the application may be shutting down (the table may be gone already)
+    m_saveFuture.waitForFinished();
+    if (m_dirty && !m_repoPath.isEmpty() && !m_rowSets.isEmpty())
+        writeFile(CommitCache::pathFor(m_repoPath, "refs"), serialize());
+
+    if (m_repo)
+        git_repository_free(m_repo);
+}
+
+void RefMembershipIndex::setRepositoryPath(const QString &repoPath)
+{
+    if (repoPath == m_repoPath)
+        return;
+
+    save();
+
+    if (m_repo) {
+        git_repository_free(m_repo);
+        m_repo = nullptr;
+    }
+
+    m_repoPath = repoPath;
+    if (!m_repoPath.isEmpty()
+        && git_repository_open(&m_repo, m_repoPath.toUtf8().constData()) != GIT_OK)
+        m_repo = nullptr;
+
+    resetRefs();
+    rebuild();
+}
+
+void RefMembershipIndex::update()
+{
+    const QList<RefTip> previous = m_refs;
+    resetRefs();
+    if (m_refs != previous && !propagate(previous, 0))
+        rebuild();
+}
+
+void RefMembershipIndex::sync()
+{
+    const int count = m_table->count();
+    if (m_rowSets.size() >= count)
+        return;
+
+    m_rowSets.reserve(count);
+    for (int row = m_rowSets.size(); row < count; ++row) {
+        const git_oid &oid = m_table->oid(row);
+
+        // Children came first and already pushed their sets down to this row
+        QByteArray set = m_pending.take(oid);
+        if (set.isEmpty())
+            set = QByteArray(m_bytes, 0);
+
+        const auto tip = m_tipSets.constFind(oid);
+        if (tip != m_tipSets.constEnd())
+            unite(set, tip.value());
+
+        m_rowSets.append(intern(set));
+
+        for (int i = 0; i < m_table->parentCount(row); ++i) {
+            QByteArray &parentSet = m_pending[m_table->parentOid(row, i)];
+            if (parentSet.isEmpty())
+                parentSet = set;
+            else if (parentSet != set)
+                unite(parentSet, set);
+        }
+    }
+
+    m_firstOid = m_table->oid(0);
+    m_lastOid = m_table->oid(count - 1);
+
+    m_dirty = true;
+    scheduleSave();
+}
+
+QStringList RefMembershipIndex::refsContainingRow(int row)
+{
+    if (row < 0 || row >= m_table->count())
+        return QStringList();
+
+    sync();
+    return namesOf(m_sets.at(m_rowSets.at(row)));
+}
+
+QStringList RefMembershipIndex::refsContaining(const QString &hash)
+{
+    return refsContainingRow(m_table->indexOf(hash));
+}
+
+bool RefMembershipIndex::rowInRef(int row, const QString &refName)
+{
+    const int bit = m_refNames.indexOf(refName);
+    if (bit < 0 || row < 0 || row >= m_table->count())
+        return false;
+
+    sync();
+    const QByteArray &set = m_sets.at(m_rowSets.at(row));
+    return set.at(bit / 8) & (1 << (bit % 8));
+}
+
+void RefMembershipIndex::rebuild()
+{
+    m_sets.clear();
+    m_setIds.clear();
+    m_rowSets.clear();
+    m_pending.clear();
+
+    sync();
+    emit membershipChanged();
+}
+
+bool RefMembershipIndex::propagate(const QList<RefTip> &previous, int prepended)
+{
+    const int oldRows = m_rowSets.size();
+    const int rows = oldRows + prepended;
+    if (oldRows == 0 || rows > m_table->count())
+        return false;
+
+    QHash<QByteArray, int> bits;
+    for (int i = 0; i < m_refs.size(); ++i)
+        bits.insert(m_refs.at(i).name, i);
+
+    // A deleted ref leaves its bit behind in every set that had it
+    QVector<int> bitMap(previous.size(), -1);
+    bool remapped = m_refs.size() != previous.size();
+    for (int i = 0; i < previous.size(); ++i) {
+        bitMap[i] = bits.value(previous.at(i).name, -1);
+        if (bitMap.at(i) < 0)
+            return false;
+        remapped = remapped || bitMap.at(i) != i;
+    }
+
+    // Old tips of moved refs must be reached from the new ones, or the ref did not move forward
+    QMultiHash<int, int> movedTips;
+    for (int i = 0; i < previous.size(); ++i) {
+        if (previous.at(i).oid == m_refs.at(bitMap.at(i)).oid)
+            continue;
+
+        const int row = m_table->rowOf(previous.at(i).oid);
+        if (row < 0 || row >= rows)
+            return false;
+        movedTips.insert(row, bitMap.at(i));
+    }
+
+    // New refs took bits in between: move the old bits to their new place
+    if (remapped) {
+        const auto remap = [this, &bitMap](const QByteArray &set) {
+            QByteArray mapped(m_bytes, 0);
+            for (int i = 0; i < bitMap.size(); ++i) {
+                if (hasBit(set, i))
+                    setBit(mapped, bitMap.at(i));
+            }
+            return mapped;
+        };
+
+        m_setIds.clear();
+        for (int id = 0; id < m_sets.size(); ++id) {
+            m_sets[id] = remap(m_sets.at(id));
+            m_setIds.insert(m_sets.at(id), id);
+        }
+        for (auto it = m_pending.begin(); it != m_pending.end(); ++it)
+            it.value() = remap(it.value());
+    }
+
+    m_rowSets.insert(0, prepended, -1);
+
+    // Rows ascend from children to parents: visiting them in order pushes each set down once
+    std::map<int, QByteArray> incoming;
+    for (int row = 0; row < prepended; ++row)
+        incoming.emplace(row, QByteArray(m_bytes, 0));
+    for (auto it = m_tipSets.constBegin(); it != m_tipSets.constEnd(); ++it) {
+        const int row = m_table->rowOf(it.key());
+        if (row >= 0 && row < rows)
+            incoming.try_emplace(row, QByteArray(m_bytes, 0));
+    }
+
+    int reached = 0;
+    int firstChanged = -1;
+    int lastChanged = -1;
+    while (!incoming.empty()) {
+        const int row = incoming.begin()->first;
+        QByteArray set = std::move(incoming.begin()->second);
+        incoming.erase(incoming.begin());
+
+        for (auto it = movedTips.constFind(row); it != movedTips.constEnd() && it.key() == row; ++it) {
+            if (hasBit(set, it.value()))
+                ++reached;
+        }
+
+        const auto tip = m_tipSets.constFind(m_table->oid(row));
+        if (tip != m_tipSets.constEnd())
+            unite(set, tip.value());
+
+        // Nothing new for an old row: its ancestors have all these bits already
+        if (row >= prepended) {
+            const QByteArray &old = m_sets.at(m_rowSets.at(row));
+            unite(set, old);
+            if (set == old)
+                continue;
+        }
+
+        m_rowSets[row] = intern(set);
+
+        // Views insert the prepended rows on their own; rows ascend, so the first one is the smallest
+        if (row >= prepended) {
+            if (firstChanged < 0)
+                firstChanged = row;
+            lastChanged = row;
+        }
+
+        for (int i = 0; i < m_table->parentCount(row); ++i) {
+            const int parentRow = m_table->parentRow(row, i);
+            if (parentRow >= 0 && parentRow < rows) {
+                const auto [it, inserted] = incoming.try_emplace(parentRow, set);
+                if (!inserted)
+                    unite(it->second, set);
+                continue;
+            }
+
+            // Not processed yet: sync() picks the set up with the row
+            QByteArray &parentSet = m_pending[m_table->parentOid(row, i)];
+            if (parentSet.isEmpty())
+                parentSet = set;
+            else if (parentSet != set)
+                unite(parentSet, set);
+        }
+    }
+
+    if (reached < movedTips.size())
+        return false;
+
+    m_firstOid = m_table->oid(0);
+    m_lastOid = m_table->oid(rows - 1);
+
+    m_dirty = true;
+    scheduleSave();
+
+    if (firstChanged < 0)
+        return true;
+
+    // Views connected after this index still number rows as before the prepend: report by commit, later
+    const git_oid first = m_table->oid(firstChanged);
+    const git_oid last = m_table->oid(lastChanged);
+    QMetaObject::invokeMethod(this, [this, first, last]() {
+        const int firstRow = m_table->rowOf(first);
+        const int lastRow = m_table->rowOf(last);
+        if (firstRow >= 0 && lastRow >= firstRow)
+            emit rowsMembershipChanged(firstRow, lastRow);
+    }, Qt::QueuedConnection);
+    return true;
+}
+
+void RefMembershipIndex::resetRefs()
+{
+    m_refs.clear();
+    m_refNames.clear();
+    m_tipSets.clear();
+
+    // HEAD is not a branch; the branch it points to carries its bit
+    const QList<RefTip> tips = HistorySession::readRefTips(m_repo);
+    for (const RefTip &tip : tips) {
+        if (tip.name != "HEAD")
+            m_refs.append(tip);
+    }
+
+    m_bytes = (m_refs.size() + 7) / 8;
+    for (int i = 0; i < m_refs.size(); ++i) {
+        m_refNames.append(shortRefName(m_refs.at(i).name));
+
+        QByteArray &set = m_tipSets[m_refs.at(i).oid];
+        if (set.isEmpty())
+            set = QByteArray(m_bytes, 0);
+        set[i / 8] = char(set.at(i / 8) | (1 << (i % 8)));
+    }
+}
+
+qint32 RefMembershipIndex::intern(const QByteArray &set)
+{
+    const auto it = m_setIds.constFind(set);
+    if (it != m_setIds.constEnd())
+        return it.value();
+
+    const qint32 id = m_sets.size();
+    m_sets.append(set);
+    m_setIds.insert(set, id);
+    return id;
+}
+
+QStringList RefMembershipIndex::namesOf(const QByteArray &set) const
+{
+    QStringList names;
+    for (int i = 0; i < m_refNames.size(); ++i) {
+        if (set.at(i / 8) & (1 << (i % 8)))
+            names.append(m_refNames.at(i));
+    }
+    return names;
+}
+
+QByteArray RefMembershipIndex::serialize() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    stream << MembershipMagic << MembershipVersion << qint32(m_refs.size());
+    for (const RefTip &tip : m_refs) {
+        stream << tip.name;
+        writeOid(stream, tip.oid);
+    }
+
+    // First and last row identify the table the sets belong to
+    stream << qint32(m_rowSets.size());
+    writeOid(stream, m_firstOid);
+    writeOid(stream, m_lastOid);
+
+    stream << m_sets;
+    stream.writeRawData(reinterpret_cast<const char *>(m_rowSets.constData()),
+                        m_rowSets.size() * sizeof(qint32));
+
+    stream << qint32(m_pending.size());
+    for (auto it = m_pending.constBegin(); it != m_pending.constEnd(); ++it) {
+        writeOid(stream, it.key());
+        stream << it.value();
+    }
+
+    return data;
+}
+
+bool RefMembershipIndex::restore(const QByteArray &data)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 refCount = 0;
+    stream >> magic >> version >> refCount;
+    if (magic != MembershipMagic || version != MembershipVersion || refCount != m_refs.size())
+        return false;
+
+    // Sets are only valid for the refs they were computed from
+    for (const RefTip &ref : m_refs) {
+        RefTip tip;
+        stream >> tip.name;
+        if (!readOid(stream, tip.oid) || tip != ref)
+            return false;
+    }
+
+    qint32 rowCount = 0;
+    git_oid first;
+    git_oid last;
+    stream >> rowCount;
+    if (!readOid(stream, first) || !readOid(stream, last)
+        || rowCount <= 0 || rowCount > m_table->count()
+        || m_table->oid(0) != first || m_table->oid(rowCount - 1) != last)
+        return false;
+
+    stream >> m_sets;
+    for (int id = 0; id < m_sets.size(); ++id) {
+        if (m_sets.at(id).size() != m_bytes)
+            return false;
+        m_setIds.insert(m_sets.at(id), id);
+    }
+
+    m_rowSets.resize(rowCount);
+    const qsizetype rowBytes = rowCount * qsizetype(sizeof(qint32));
+    if (stream.readRawData(reinterpret_cast<char *>(m_rowSets.data()), rowBytes) != rowBytes)
+        return false;
+    for (qint32 id : std::as_const(m_rowSets)) {
+        if (id < 0 || id >= m_sets.size())
+            return false;
+    }
+
+    qint32 pendingCount = 0;
+    stream >> pendingCount;
+    for (qint32 i = 0; i < pendingCount; ++i) {
+        git_oid oid;
+        QByteArray set;
+        if (!readOid(stream, oid))
+            return false;
+        stream >> set;
+        if (set.size() != m_bytes)
+            return false;
+        m_pending.insert(oid, set);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    m_firstOid = first;
+    m_lastOid = last;
+    m_dirty = false;
+    return true;
+}
+
+void RefMembershipIndex::scheduleSave()
+{
+    if (!m_repoPath.isEmpty())
+        m_saveTimer.start();
+}
+
+void RefMembershipIndex::save()
+{
+    if (!m_dirty || m_repoPath.isEmpty() || m_rowSets.isEmpty())
+        return;
+
+    m_dirty = false;
+    m_saveTimer.stop();
+
+    const QString path = CommitCache::pathFor(m_repoPath, "refs");
+    const QByteArray data = serialize();
+    m_saveFuture.waitForFinished();
+    m_saveFuture = QtConcurrent::run([path, data]() {
+        writeFile(path, data);
+    });
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QQmlEngine>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include <git2/oid.h>
+#include <git2/types.h>
+
+#include "CommitTable.h"
+#include "HistorySession.h"
+
+/**
+ * \brief Which branches contain each loaded commit
+ *
+ * Every branch gets a bit; a commit's set is the bits of the branches
+ * pointing at it plus the sets of its children. Rows of a CommitTable
+ * arrive in walk order (children before parents), so sets are computed as
+ * history loads, by pushing each row's set down to its parents once.
+ *
+ * Consecutive commits mostly belong to the same branches, so distinct sets
+ * are interned and a row only stores the index of its set.
+ *
+ * The sets are saved next to the history cache together with the refs
+ * they were computed for, and adopted again when the cached history is
+ * restored with the same refs. When commits are prepended or refs move
+ * forward, only the new rows and the ancestors whose sets grow are
+ * visited; a pushed-down set that adds nothing stops the walk. A deleted
+ * ref or one moved to a commit that does not contain its old tip clears
+ * bits, and the sets are recomputed from the table (still without
+ * touching the object database).
+ */
+class RefMembershipIndex : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("RefMembershipIndex is owned by GitCommit")
+
+public:
+    explicit RefMembershipIndex(CommitTable *table, QObject *parent = nullptr);
+    ~RefMembershipIndex();
+
+    /**
+     * \brief Switch to another repository
+     * \param repoPath Path of the repository, or empty to unload
+     */
+    void setRepositoryPath(const QString &repoPath);
+
+    /**
+     * \brief Re-read the refs and recompute the sets if any of them moved
+     */
+    Q_INVOKABLE void update();
+
+    /**
+     * \brief Compute the sets of rows appended to the table since the last call
+     *
+     * Queries call it as needed; calling it as rows arrive spreads the work.
+     */
+    void sync();
+
+    /**
+     * \brief Branches containing a row of the table
+     * \return Short branch names ("main", "origin/main"), in ref order
+     */
+    Q_INVOKABLE QStringList refsContainingRow(int row);
+
+    /**
+     * \brief Branches containing a commit, empty if it is not loaded
+     */
+    Q_INVOKABLE QStringList refsContaining(const QString &hash);
+
+    /**
+     * \brief Whether a branch contains a row of the table
+     * \param refName Short branch name, as returned by refsContainingRow()
+     */
+    Q_INVOKABLE bool rowInRef(int row, const QString &refName);
+
+signals:
+    /**
+     * \brief Sets of rows computed earlier changed (refs moved or history was reloaded)
+     */
+    void membershipChanged();
+
+    /**
+     * \brief Sets of some rows computed earlier changed, after an incremental update
+     *
+     * Emitted from the event loop, once views have taken in the rows
+     * prepended with the update.
+     *
+     * \param firstRow First changed row of the table
+     * \param lastRow Last changed row; rows in between may be unchanged
+     */
+    void rowsMembershipChanged(int firstRow, int lastRow);
+
+private:
+    void rebuild();
+
+    /**
+     * \brief Update the sets for new refs and rows prepended to the table
+     * \param previous Refs the sets were computed for
+     * \param prepended Rows inserted in front since then
+     * \return false if a bit has to be cleared, or the sets do not cover the
+     *         moved refs; the sets are then inconsistent and must be rebuilt
+     */
+    bool propagate(const QList<RefTip> &previous, int prepended);
+    void resetRefs();
+    qint32 intern(const QByteArray &set);
+    QStringList namesOf(const QByteArray &set) const;
+
+    QByteArray serialize() const;
+    bool restore(const QByteArray &data);
+    void scheduleSave();
+    void save();
+
+    CommitTable *m_table = nullptr;
+    QString m_repoPath;
+    git_repository *m_repo = nullptr;
+
+    QList<RefTip> m_refs;                   ///< Bit i is m_refs[i]
+    QStringList m_refNames;                 ///< Short names of m_refs
+    QHash<git_oid, QByteArray> m_tipSets;   ///< Commit -> refs pointing at it
+    int m_bytes = 0;                        ///< Size of a set
+
+    QVector<QByteArray> m_sets;             ///< Distinct sets
+    QHash<QByteArray, qint32> m_setIds;
+    QVector<qint32> m_rowSets;              ///< Set of each processed row
+    QHash<git_oid, QByteArray> m_pending;   ///< Sets pushed down to commits not processed yet
+    git_oid m_firstOid;                     ///< First and last processed row, identify the table when saved
+    git_oid m_lastOid;
+
+    QTimer m_saveTimer;
+    QFuture<void> m_saveFuture;
+    bool m_dirty = false;
+};
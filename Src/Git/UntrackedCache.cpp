@@ -0,0 +1,371 @@
+#include "UntrackedCache.h"
+#include "CommitCache.h"
+
+#include <git2/buffer.h>
+#include <git2/config.h>
+#include <git2/errors.h>
+#include <git2/ignore.h>
+#include <git2/index.h>
+#include <git2/repository.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <mutex>
+
+namespace {
+constexpr quint32 UntrackedMagic = 0x47455543; // "GEUC"
+constexpr quint32 UntrackedVersion = 1;
+
+constexpr int SaveDelayMs = 2000;
+
+// A directory changed this recently may change again within its timestamp; read it again next time
+constexpr qint64 RacyWindowMs = 1000;
+
+bool tracked(git_index *index, const QString &path)
+{
+    size_t position = 0;
+    return git_index_find(&position, index, path.toUtf8().constData()) == GIT_OK;
+}
+
+bool trackedBelow(git_index *index, const QString &directory)
+{
+    size_t position = 0;
+    return git_index_find_prefix(&position, index, (directory + '/').toUtf8().constData()) == GIT_OK;
+}
+
+QByteArray fileHash(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    return hash.result();
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+}
+
+struct UntrackedCache::ScanState
+{
+    git_repository *repo = nullptr;
+    git_index *index = nullptr;
+    QString workdir;
+    qint64 racyAfter = 0;       ///< Modification times after this are not trusted
+    const std::atomic<bool> *cancelled = nullptr;
+    QSet<QString> visited;
+
+    bool isCancelled() const { return cancelled && *cancelled; }
+};
+
+UntrackedCache::UntrackedCache(QObject *parent)
+    : QObject{parent}
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SaveDelayMs);
+    connect(&m_saveTimer, &QTimer::timeout, this, &UntrackedCache::save);
+}
+
+UntrackedCache::~UntrackedCache()
+{
+    // Flush synchronously, the application may be shutting down
+    m_saveFuture.waitForFinished();
+    if (m_dirty && !m_repoPath.isEmpty())
+        writeFile(CommitCache::pathFor(m_repoPath, "untracked"), serialize());
+}
+
+void UntrackedCache::setRepositoryPath(const QString &repoPath)
+{
+    if (repoPath == m_repoPath)
+        return;
+
+    save();
+
+    m_directories.clear();
+    m_dirty = false;
+    m_repoPath = repoPath;
+
+    if (!m_repoPath.isEmpty()) {
+        QFile file(CommitCache::pathFor(m_repoPath, "untracked"));
+        if (file.open(QIODevice::ReadOnly) && !restore(file.readAll()))
+            m_directories.clear();
+    }
+}
+
+bool UntrackedCache::scan(git_repository *repo, QStringList &untracked, const std::atomic<bool> *cancelled)
+{
+    const char *workdir = git_repository_workdir(repo);
+    if (!workdir)
+        return false;
+
+    git_index *index = nullptr;
+    if (git_repository_index(&index, repo) != GIT_OK)
+        return false;
+
+    // Staged or unstaged by someone else since the index was loaded
+    if (git_index_read(index, false) != GIT_OK) {
+        git_index_free(index);
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    ScanState state;
+    state.repo = repo;
+    state.index = index;
+    state.workdir = QString::fromUtf8(workdir);
+    state.racyAfter = QDateTime::currentMSecsSinceEpoch() - RacyWindowMs;
+    state.cancelled = cancelled;
+
+    collect(state, QString(), globalRules(repo), untracked);
+    git_index_free(index);
+
+    // Directories not visited yet are still valid; keep what was read so far for the next scan
+    if (state.isCancelled()) {
+        untracked.clear();
+        scheduleSave();
+        return false;
+    }
+
+    // Directories that are gone, or no longer needed to answer the scan
+    for (auto it = m_directories.begin(); it != m_directories.end();) {
+        if (state.visited.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_directories.erase(it);
+            m_dirty = true;
+        }
+    }
+
+    scheduleSave();
+    return true;
+}
+
+void UntrackedCache::save()
+{
+    // A scan is running on another thread: save once it is done rather than wait for it
+    std::unique_lock<QMutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        m_saveTimer.start();
+        return;
+    }
+
+    if (!m_dirty || m_repoPath.isEmpty())
+        return;
+
+    m_dirty = false;
+    m_saveTimer.stop();
+
+    const QString path = CommitCache::pathFor(m_repoPath, "untracked");
+    const QByteArray data = serialize();
+    m_saveFuture.waitForFinished();
+    m_saveFuture = QtConcurrent::run([path, data]() {
+        writeFile(path, data);
+    });
+}
+
+void UntrackedCache::scheduleSave()
+{
+    // The timer belongs to the GUI thread, the scan may not
+    if (m_dirty)
+        QMetaObject::invokeMethod(this, [this]() { m_saveTimer.start(); });
+}
+
+UntrackedCache::Directory UntrackedCache::directory(ScanState &state, const QString &path,
+                                                    const QByteArray &parentRules)
+{
+    state.visited.insert(path);
+
+    const QString absolute = path.isEmpty() ? state.workdir : state.workdir + path + '/';
+    const QFileInfo info(absolute);
+    if (!info.isDir()) {
+        m_directories.remove(path);
+        return Directory();
+    }
+
+    Directory &entry = m_directories[path];
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+    // The .gitignore is edited in place, which leaves the directory's mtime alone: stat it too
+    const QFileInfo gitignore(absolute + ".gitignore");
+    QByteArray gitignoreStamp;
+    if (gitignore.exists()) {
+        const qint64 gitignoreTime = gitignore.lastModified().toMSecsSinceEpoch();
+        gitignoreStamp = gitignoreTime > state.racyAfter
+                             ? QByteArray("racy")
+                             : QByteArray::number(gitignoreTime) + ':' + QByteArray::number(gitignore.size());
+    }
+    if (gitignoreStamp != entry.gitignoreStamp || gitignoreStamp == "racy") {
+        entry.gitignoreStamp = gitignoreStamp;
+        entry.gitignoreHash = gitignoreStamp.isEmpty() ? QByteArray() : fileHash(gitignore.filePath());
+        m_dirty = true;
+    }
+
+    const QByteArray rules = QCryptographicHash::hash(parentRules + entry.gitignoreHash,
+                                                      QCryptographicHash::Sha1);
+    if (entry.mtime >= 0 && entry.mtime == mtime && entry.rules == rules)
+        return entry;
+
+    entry.files.clear();
+    entry.directories.clear();
+    entry.repository = false;
+
+    QDirIterator it(absolute, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo child = it.fileInfo();
+        const QString name = child.fileName();
+
+        if (name == ".git") {
+            entry.repository = !path.isEmpty();
+            continue;
+        }
+
+        // Symbolic links are files to git, wherever they point
+        const bool isDirectory = child.isDir() && !child.isSymLink();
+        const QString childPath = path.isEmpty() ? name : path + '/' + name;
+        const QByteArray ignorePath = (isDirectory ? childPath + '/' : childPath).toUtf8();
+
+        int ignored = 0;
+        if (git_ignore_path_is_ignored(&ignored, state.repo, ignorePath.constData()) == GIT_OK && ignored)
+            continue;
+
+        if (isDirectory)
+            entry.directories.append(name);
+        else
+            entry.files.append(name);
+    }
+
+    entry.mtime = mtime > state.racyAfter ? -1 : mtime;
+    entry.rules = rules;
+    m_dirty = true;
+    return entry;
+}
+
+void UntrackedCache::collect(ScanState &state, const QString &path, const QByteArray &parentRules,
+                             QStringList &untracked)
+{
+    if (state.isCancelled())
+        return;
+
+    const Directory entry = directory(state, path, parentRules);
+    const QString prefix = path.isEmpty() ? QString() : path + '/';
+
+    for (const QString &name : entry.files) {
+        const QString childPath = prefix + name;
+        if (!tracked(state.index, childPath))
+            untracked.append(childPath);
+    }
+
+    for (const QString &name : entry.directories) {
+        const QString childPath = prefix + name;
+        if (trackedBelow(state.index, childPath))
+            collect(state, childPath, entry.rules, untracked);
+        else if (!tracked(state.index, childPath) && hasContent(state, childPath, entry.rules))
+            untracked.append(childPath + '/');   // Submodules are tracked as a single entry
+    }
+}
+
+bool UntrackedCache::hasContent(ScanState &state, const QString &path, const QByteArray &parentRules)
+{
+    if (state.isCancelled())
+        return false;
+
+    // Status leaves nested repositories out altogether
+    const Directory entry = directory(state, path, parentRules);
+    if (entry.repository)
+        return false;
+    if (!entry.files.isEmpty())
+        return true;
+
+    for (const QString &name : entry.directories) {
+        if (hasContent(state, path + '/' + name, entry.rules))
+            return true;
+    }
+
+    return false;
+}
+
+QByteArray UntrackedCache::globalRules(git_repository *repo)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(fileHash(QString::fromUtf8(git_repository_commondir(repo)) + "info/exclude"));
+
+    // core.excludesFile, by default $XDG_CONFIG_HOME/git/ignore
+    QString excludesFile = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+                           + "/git/ignore";
+    git_config *config = nullptr;
+    if (git_repository_config_snapshot(&config, repo) == GIT_OK) {
+        git_buf buffer = GIT_BUF_INIT;
+        if (git_config_get_path(&buffer, config, "core.excludesFile") == GIT_OK)
+            excludesFile = QString::fromUtf8(buffer.ptr);
+        git_buf_dispose(&buffer);
+        git_config_free(config);
+    }
+
+    hash.addData(excludesFile.toUtf8());
+    hash.addData(fileHash(excludesFile));
+    return hash.result();
+}
+
+QByteArray UntrackedCache::serialize() const
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    stream << UntrackedMagic << UntrackedVersion << qint32(m_directories.size());
+    for (auto it = m_directories.cbegin(); it != m_directories.cend(); ++it) {
+        const Directory &entry = it.value();
+        stream << it.key() << entry.mtime << entry.rules << entry.gitignoreStamp << entry.gitignoreHash
+               << entry.files << entry.directories << entry.repository;
+    }
+
+    return data;
+}
+
+bool UntrackedCache::restore(const QByteArray &data)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> count;
+    if (magic != UntrackedMagic || version != UntrackedVersion || count < 0)
+        return false;
+
+    m_directories.reserve(count);
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Directory entry;
+        stream >> path >> entry.mtime >> entry.rules >> entry.gitignoreStamp >> entry.gitignoreHash
+               >> entry.files >> entry.directories >> entry.repository;
+        m_directories.insert(path, entry);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <git2/types.h>
+
+#include <atomic>
+
+/**
+ * \brief Untracked files of a working tree, remembered per directory (like git's UNTR extension)
+ *
+ * Each directory keeps the entries that are not ignored, keyed by the
+ * directory's modification time and a hash of the exclude rules in effect
+ * there (info/exclude, core.excludesFile and every .gitignore from the root
+ * down). A directory whose mtime and rules are unchanged is not read again:
+ * adding, removing or renaming an entry changes the mtime of its directory,
+ * so only the stat of each directory (and its .gitignore) is left. Whether
+ * an entry is untracked is decided against the index on every scan, so
+ * staging does not invalidate anything.
+ *
+ * The cache is saved next to the history cache and survives restarts.
+ *
+ * scan() may run on a worker thread while the object lives on the GUI
+ * thread; saving waits for a running scan instead of blocking on it.
+ */
+class UntrackedCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UntrackedCache(QObject *parent = nullptr);
+    ~UntrackedCache();
+
+    /**
+     * \brief Switch to another repository, saving the cache of the previous one and loading the saved one
+     *
+     * Must not be called while a scan is running.
+     *
+     * \param repoPath Path of the repository (its .git directory), or empty to unload
+     */
+    void setRepositoryPath(const QString &repoPath);
+
+    /**
+     * \brief List the untracked paths as git status does
+     *
+     * An untracked directory holding anything that is not ignored is listed
+     * once as "dir/"; empty ones are left out.
+     *
+     * \param repo Repository whose working tree is scanned (must match setRepositoryPath())
+     * \param untracked Receives the untracked paths relative to the working tree
+     * \param cancelled Checked for every directory; the scan stops early once it is set
+     * \return false if the repository has no working tree, its index could not be read or the scan was cancelled
+     */
+    bool scan(git_repository *repo, QStringList &untracked, const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * \brief Write the cache in the background if it changed since it was loaded or saved
+     */
+    void save();
+
+private:
+    /**
+     * \brief Entries of one directory that are not ignored
+     */
+    struct Directory
+    {
+        qint64 mtime = -1;              ///< Modification time of the directory, -1 to read it again
+        QByteArray rules;               ///< Hash of the exclude rules in effect in the directory
+        QByteArray gitignoreStamp;      ///< Modification time and size of its .gitignore
+        QByteArray gitignoreHash;       ///< Hash of its .gitignore, empty if there is none
+        QStringList files;
+        QStringList directories;
+        bool repository = false;        ///< Holds a .git of its own (a nested repository, never listed)
+    };
+
+    struct ScanState;
+
+    /**
+     * \brief The cached entries of a directory, read again if it or its rules changed
+     * \param path Directory relative to the working tree, empty for the root
+     * \param parentRules Hash of the rules in effect in the parent directory
+     */
+    Directory directory(ScanState &state, const QString &path, const QByteArray &parentRules);
+
+    /**
+     * \brief Collect the untracked paths below a directory that has tracked files
+     */
+    void collect(ScanState &state, const QString &path, const QByteArray &parentRules, QStringList &untracked);
+
+    /**
+     * \brief Whether an untracked directory holds anything that is not ignored
+     */
+    bool hasContent(ScanState &state, const QString &path, const QByteArray &parentRules);
+
+    /**
+     * \brief Hash of the repository wide rules (info/exclude, core.excludesFile)
+     */
+    static QByteArray globalRules(git_repository *repo);
+
+    /**
+     * \brief Start the save timer if anything changed; safe to call from the scanning thread
+     */
+    void scheduleSave();
+
+    QByteArray serialize() const;
+    bool restore(const QByteArray &data);
+
+    QString m_repoPath;
+    QMutex m_mutex;                             ///< Held by scan(), which may run on another thread
+    QHash<QString, Directory> m_directories;    ///< By path relative to the working tree
+    bool m_dirty = false;
+
+    QTimer m_saveTimer;
+    QFuture<void> m_saveFuture;
+};
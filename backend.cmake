@@ -10,11 +10,30 @@ set(SOURCES_BACKEND
     Src/Git/GitBranch.cpp
     Src/Git/GitCommit.cpp
     Src/Git/GitStatus.cpp
+    Src/Git/FileSystemMonitor.cpp
+    Src/Git/UntrackedCache.cpp
+    Src/Git/ParallelStatus.cpp
     Src/Git/GitRemote.cpp
     Src/Git/GitBundle.cpp
+    Src/Git/AheadBehind.cpp
+    Src/Git/Reachability.cpp
+    Src/Git/HistorySession.cpp
+    Src/Git/CommitGraph.cpp
+    Src/Git/CommitCache.cpp
+    Src/Git/CommitDecoder.cpp
+    Src/Git/CommitSearchIndex.cpp
+    Src/Git/RefMembershipIndex.cpp
+    Src/Git/RefDecorations.cpp
+    Src/Git/HistoryLoader.cpp
+    Src/Git/PathFilter.cpp
+    Src/Git/ChangesModel.cpp
+    Src/Git/CommitHistoryModel.cpp
+    Src/Git/GraphLayoutEngine.cpp
+    Src/Git/CommitGraphItem.cpp
 
     Src/Git/Models/Remote.cpp
     Src/Git/Models/Commit.cpp
+    Src/Git/Models/CommitTable.cpp
     Src/Git/Models/GitDiff.cpp
     Src/Git/Models/GitFileStatus.cpp
     Src/Git/Models/Repository.cpp
@@ -33,11 +52,31 @@ set(HEADERS_BACKEND
     Src/Git/GitBranch.h
     Src/Git/GitCommit.h
     Src/Git/GitStatus.h
+    Src/Git/FileSystemMonitor.h
+    Src/Git/UntrackedCache.h
+    Src/Git/ParallelStatus.h
     Src/Git/GitRemote.h
     Src/Git/GitBundle.h
+    Src/Git/AheadBehind.h
+    Src/Git/Reachability.h
+    Src/Git/HistorySession.h
+    Src/Git/OidHash.h
+    Src/Git/CommitGraph.h
+    Src/Git/CommitCache.h
+    Src/Git/CommitDecoder.h
+    Src/Git/CommitSearchIndex.h
+    Src/Git/RefMembershipIndex.h
+    Src/Git/RefDecorations.h
+    Src/Git/HistoryLoader.h
+    Src/Git/PathFilter.h
+    Src/Git/ChangesModel.h
+    Src/Git/CommitHistoryModel.h
+    Src/Git/GraphLayoutEngine.h
+    Src/Git/CommitGraphItem.h
 
     Src/Git/Models/Remote.h
     Src/Git/Models/Commit.h
+    Src/Git/Models/CommitTable.h
     Src/Git/Models/GitDiff.h
     Src/Git/Models/GitFileStatus.h
     Src/Git/Models/Repository.h
@@ -0,0 +1,24 @@
+# ========== GRAPH BENCHMARK ==========
+# Headless benchmark of history loading, graph layout and graph rendering on
+# generated repositories. Build with -DGITEASE_BUILD_BENCHMARKS=ON and run
+# GitEaseGraphBench --help.
+
+qt_add_executable(GitEaseGraphBench
+    Bench/GraphBench.cpp
+    ${HEADERS_BACKEND}
+    ${SOURCES_BACKEND}
+)
+
+target_include_directories(GitEaseGraphBench PRIVATE ${INCLUDE_DIRS_BACKEND})
+
+target_link_libraries(GitEaseGraphBench PRIVATE
+    Qt6::Core
+    Qt6::Quick
+    Qt6::Gui
+    Qt6::Concurrent
+    libgit2
+)
+
+if (WIN32)
+    target_link_libraries(GitEaseGraphBench PRIVATE dwmapi)
+endif()